@@ -0,0 +1,37 @@
+#
+#  This file is part of Thunderpad
+#
+#  Copyright (c) 2013-2015 Alex Spataru <alex.racotta@gmail.com>
+#  Please check the license.txt file for more information.
+#
+
+#
+# Compares the AVX2, SSE2 and scalar implementations of the document
+# statistics on random buffers, the program exits with an error code
+# if any result differs. It is not part of the application, build and
+# run it with:
+#
+#     qmake bench/document_stats_fuzz && make && ./document_stats_fuzz
+#
+# The number of buffers and the seed can be given as arguments, e.g.
+# "./document_stats_fuzz 1000000 42"
+#
+
+TEMPLATE = app
+TARGET   = document_stats_fuzz
+
+QT      -= gui
+CONFIG  += console
+CONFIG  -= app_bundle
+
+INCLUDEPATH += \
+    ../../src/editor \
+    ../../src/shared
+
+HEADERS += \
+    ../../src/shared/simd.h \
+    ../../src/editor/document_stats.h
+
+SOURCES += \
+    main.cpp \
+    ../../src/editor/document_stats.cpp
@@ -0,0 +1,137 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QByteArray>
+#include <QTextStream>
+#include <QCoreApplication>
+
+#include "document_stats.h"
+
+#define BUFFERS      200000
+#define SEED         0x5EED
+#define MAX_LENGTH   4096
+#define MAX_OFFSET   32
+
+//
+// Pieces of text used to build the buffers, they include every kind of
+// line ending, every multi-byte space and the sequences that look like
+// a multi-byte space but are not one
+//
+static const char *PIECES[] = {
+    "a", "word", "Thunderpad", "0123456789", "{}();", " ", "  ", "\t",
+    "\v", "\f", "\r", "\n", "\r\n", "\n\r", "\xC2\x85", "\xC2\xA0",
+    "\xE1\x9A\x80", "\xE2\x80\x80", "\xE2\x80\x85", "\xE2\x80\x8A",
+    "\xE2\x80\x8B", "\xE2\x80\xA8", "\xE2\x80\xA9", "\xE2\x80\xAF",
+    "\xE2\x81\x9F", "\xE3\x80\x80", "\xC2", "\xE2\x80", "\xE3", "\xC3\xA9",
+    "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xE1\x9A", "\xE2\x81", "\x80"
+};
+
+static quint32 _random = SEED;
+
+//
+// Simple linear congruential generator, so that a failure can always
+// be reproduced with the same seed
+//
+static quint32 nextRandom (void) {
+    _random = _random * 1103515245u + 12345u;
+    return _random >> 8;
+}
+
+//
+// Fills a buffer with random pieces, and sometimes with random bytes
+//
+static QByteArray randomBuffer (void) {
+    const int _pieces = sizeof (PIECES) / sizeof (PIECES[0]);
+    int _length = nextRandom() % MAX_LENGTH;
+
+    QByteArray _buffer;
+    _buffer.reserve (_length + 8);
+
+    while (_buffer.size() < _length) {
+        if (nextRandom() % 16 == 0)
+            _buffer.append ((char) (nextRandom() & 0xFF));
+        else
+            _buffer.append (PIECES[nextRandom() % _pieces]);
+    }
+
+    return _buffer;
+}
+
+int main (int argc, char *argv[]) {
+    QCoreApplication app (argc, argv);
+    QTextStream out (stdout);
+
+    int _buffers = argc > 1 ? QByteArray (argv[1]).toInt() : BUFFERS;
+    if (argc > 2)
+        _random = QByteArray (argv[2]).toUInt();
+
+    const DocumentStats::Implementation _implementations[] = {
+        DocumentStats::Sse2, DocumentStats::Avx2
+    };
+    const char *_names[] = { "SSE2", "AVX2" };
+
+    bool _supported[2];
+    qint64 _s_words, _s_characters, _s_line_ends;
+    qint64 _v_words, _v_characters, _v_line_ends;
+
+    for (int j = 0; j < 2; ++j) {
+        _supported[j] = DocumentStats::countWith (_implementations[j], "", 0,
+                                                  &_v_words, &_v_characters,
+                                                  &_v_line_ends);
+        out << _names[j] << (_supported[j] ? ": supported" : ": not supported") << endl;
+    }
+
+    for (int i = 0; i < _buffers; ++i) {
+        //
+        // Count the buffer from a random offset, so that the vectorised
+        // code also reads unaligned blocks
+        //
+        QByteArray _buffer = randomBuffer();
+        int _offset = qMin (_buffer.size(), (int) (nextRandom() % MAX_OFFSET));
+        const char *_data = _buffer.constData() + _offset;
+        qint64 _length = _buffer.size() - _offset;
+
+        DocumentStats::countWith (DocumentStats::Scalar, _data, _length,
+                                  &_s_words, &_s_characters, &_s_line_ends);
+
+        for (int j = 0; j < 2; ++j) {
+            if (!_supported[j])
+                continue;
+
+            DocumentStats::countWith (_implementations[j], _data, _length,
+                                      &_v_words, &_v_characters, &_v_line_ends);
+
+            if (_v_words != _s_words || _v_characters != _s_characters ||
+                _v_line_ends != _s_line_ends) {
+                out << _names[j] << " differs from the scalar code in buffer " << i
+                    << " (" << _length << " bytes)" << endl;
+                out << "  words:      " << _v_words << " != " << _s_words << endl;
+                out << "  characters: " << _v_characters << " != " << _s_characters << endl;
+                out << "  line ends:  " << _v_line_ends << " != " << _s_line_ends << endl;
+                out << "  data:       " << QByteArray (_data, _length).toHex() << endl;
+                return 1;
+            }
+        }
+    }
+
+    out << "Buffers: " << _buffers << ", no differences" << endl;
+    return 0;
+}
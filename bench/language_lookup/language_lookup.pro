@@ -0,0 +1,32 @@
+#
+#  This file is part of Thunderpad
+#
+#  Copyright (c) 2013-2015 Alex Spataru <alex.racotta@gmail.com>
+#  Please check the license.txt file for more information.
+#
+
+#
+# Micro-benchmark that compares the LanguageRegistry lookup with the
+# chain of comparisons that was used by the LexerDatabase before.
+# It is not part of the application, build it with:
+#
+#     qmake bench/language_lookup && make && ./language_lookup
+#
+
+TEMPLATE = app
+TARGET   = language_lookup
+
+QT      -= gui
+CONFIG  += console c++11
+CONFIG  -= app_bundle
+
+DEFINES += SOURCE_DIR=\\\"$$PWD/../..\\\"
+
+INCLUDEPATH += ../../src/editor
+
+HEADERS += \
+    ../../src/editor/language_registry.h
+
+SOURCES += \
+    main.cpp \
+    ../../src/editor/language_registry.cpp
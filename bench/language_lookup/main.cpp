@@ -0,0 +1,136 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QCoreApplication>
+
+#include "language_registry.h"
+
+#define ITERATIONS 200000
+#define DEFINITIONS SOURCE_DIR "/res/languages/languages.xml"
+
+//
+// The chain of comparisons used by the LexerDatabase before the
+// language registry was introduced, kept here as the baseline
+//
+static QString legacyLookup (const QString &file) {
+    QFile _file (file);
+    QString s = QFileInfo (_file).suffix().toLower();
+    QString n = QFileInfo (_file).baseName().toLower();
+
+    if (s == "adb" || s == "ads") return "ada";
+    else if (s == "s" || s == "asm") return "asm";
+    else if (s == "hs" || s == "lhs") return "haskell";
+    else if (s == "lisp" || s == "cl") return "lisp";
+    else if (s == "nsi") return "nsis";
+    else if (s == "sh" || s == "bsh") return "bash";
+    else if (s == "cmd" || s == "bat" || s == "btm" || s == "nt") return "batch";
+    else if (s == "cmake" || n == "cmakelists") return "cmake";
+    else if (s == "cpp" || s == "cxx" || s == "cc"  || s == "c" ||
+             s == "h"   || s == "hh"  || s == "hpp") return "cpp";
+    else if (s == "cs") return "csharp";
+    else if (s == "css") return "css";
+    else if (s == "d") return "d";
+    else if (s == "diff" || s == "patch") return "diff";
+    else if (s == "f90" || s == "f95" || s == "f03" || s == "f15" ||
+             s == "f2k") return "fortran";
+    else if (s == "f" || s == "for") return "fortran77";
+    else if (s == "html" || s == "htm") return "html";
+    else if (s == "java") return "java";
+    else if (s == "js") return "javascript";
+    else if (s == "lua") return "lua";
+    else if (s == "mak" || n == "gnumakefile" || n == "makefile") return "makefile";
+    else if (s == "m") return "matlab";
+    else if (s == "pas" || s == "inc") return "pascal";
+    else if (s == "pl" || s == "pm" || s == "plx") return "perl";
+    else if (s == "ps") return "postscript";
+    else if (s == "py" || s == "pyw") return "python";
+    else if (s == "rb" || s == "rbw") return "ruby";
+    else if (s == "cir") return "spice";
+    else if (s == "sql") return "sql";
+    else if (s == "tcl") return "tcl";
+    else if (s == "tex") return "tex";
+    else if (s == "v"  || s == "sv" || s == "vh" || s == "svh") return "verilog";
+    else if (s == "vhd" || s == " vhdl") return "vhdl";
+    else if (s == "xml"  || s == "xsl"  || s == "xsml" || s == "xsd"  ||
+             s == "kml"  || s == "wsdl" || s == "xlf"  || s == "xliff") return "xml";
+    else if (s == "yml") return "yaml";
+
+    return "plaintext";
+}
+
+//
+// Runs the given lookup function over all the sample names and returns
+// the average time (in nanoseconds) that each lookup took
+//
+template <typename Lookup>
+static double measure (const QStringList &names, Lookup lookup, int *hits) {
+    QElapsedTimer _timer;
+    _timer.start();
+
+    *hits = 0;
+    for (int i = 0; i < ITERATIONS; ++i) {
+        if (!lookup (names.at (i % names.count())).isEmpty())
+            ++*hits;
+    }
+
+    return (double) _timer.nsecsElapsed() / ITERATIONS;
+}
+
+int main (int argc, char *argv[]) {
+    QCoreApplication app (argc, argv);
+    QTextStream out (stdout);
+
+    LanguageRegistry registry;
+    if (!registry.loadDefinitions (DEFINITIONS)) {
+        out << "Cannot load " << DEFINITIONS << endl;
+        return 1;
+    }
+
+    //
+    // Sample names, the last ones fall through the whole chain
+    //
+    QStringList names;
+    names << "main.c" << "editor.cpp" << "lexer.h" << "script.py"
+          << "/home/user/project/CMakeLists.txt" << "Makefile"
+          << "index.html" << "style.css" << "app.js" << "config.yml"
+          << "design.vhdl" << "schema.xsd" << "module.adb" << "boot.asm"
+          << "readme.txt" << "notes" << "LICENSE" << "archive.tar";
+
+    int legacy_hits = 0;
+    int registry_hits = 0;
+
+    double legacy = measure (names, legacyLookup, &legacy_hits);
+    double hashed = measure (names, [&registry] (const QString & file) {
+        return registry.languageForFile (file);
+    }, &registry_hits);
+
+    out << "Lookups:           " << ITERATIONS << endl;
+    out << "Comparison chain:  " << legacy << " ns/lookup" << endl;
+    out << "Language registry: " << hashed << " ns/lookup" << endl;
+    out << "Speed-up:          " << legacy / hashed << "x" << endl;
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+#
+#  This file is part of Thunderpad
+#
+#  Copyright (c) 2013-2015 Alex Spataru <alex.racotta@gmail.com>
+#  Please check the license.txt file for more information.
+#
+
+#
+# Measures the throughput of every lexer known by the LexerDatabase and
+# writes the results as JSON. It is not part of the application, build
+# and run it with:
+#
+#     qmake bench/lexer_throughput && make
+#     QT_QPA_PLATFORM=offscreen ./lexer_throughput --output results.json
+#
+# Run ./lexer_throughput --help for the list of options.
+#
+
+TEMPLATE = app
+TARGET   = lexer_throughput
+
+QT      += gui widgets printsupport
+CONFIG  += console c++11 qscintilla2
+CONFIG  -= app_bundle
+
+unix:!macx {
+    LIBS += -lqscintilla2
+}
+
+INCLUDEPATH += \
+    ../../src/app \
+    ../../src/dialogs \
+    ../../src/editor \
+    ../../src/editor/lexers \
+    ../../src/shared \
+    ../../src/window
+
+RESOURCES += ../../res/res.qrc
+
+HEADERS += \
+    ../../src/editor/theme.h \
+    ../../src/editor/lexer_database.h \
+    ../../src/editor/language_registry.h \
+    ../../src/editor/language_detector.h \
+    ../../src/editor/syntax_grammar.h \
+    ../../src/editor/lexers/qscilexerada.h \
+    ../../src/editor/lexers/qscilexerasm.h \
+    ../../src/editor/lexers/qscilexerhaskell.h \
+    ../../src/editor/lexers/qscilexerlisp.h \
+    ../../src/editor/lexers/qscilexernsis.h \
+    ../../src/editor/lexers/qscilexergrammar.h \
+    ../../src/editor/lexers/qscilexerplaintext.h
+
+SOURCES += \
+    main.cpp \
+    ../../src/editor/theme.cpp \
+    ../../src/editor/lexer_database.cpp \
+    ../../src/editor/language_registry.cpp \
+    ../../src/editor/language_detector.cpp \
+    ../../src/editor/syntax_grammar.cpp \
+    ../../src/editor/lexers/qscilexerada.cpp \
+    ../../src/editor/lexers/qscilexerasm.cpp \
+    ../../src/editor/lexers/qscilexerhaskell.cpp \
+    ../../src/editor/lexers/qscilexerlisp.cpp \
+    ../../src/editor/lexers/qscilexernsis.cpp \
+    ../../src/editor/lexers/qscilexergrammar.cpp \
+    ../../src/editor/lexers/qscilexerplaintext.cpp
@@ -0,0 +1,1312 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QFile>
+#include <QHash>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QStringList>
+#include <QApplication>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QCommandLineParser>
+
+#include <Qsci/qscilexer.h>
+#include <Qsci/qsciglobal.h>
+#include <Qsci/qsciscintilla.h>
+
+#include "theme.h"
+#include "lexer_database.h"
+#include "language_registry.h"
+#include "language_detector.h"
+
+#define THEME             "Light"
+#define DEFAULT_SIZE      4
+#define DEFAULT_EDITS     50
+#define DEFAULT_ROUNDS    3
+#define EDIT_VIEW_LINES   60
+#define EDIT_SEED         0x2545F491u
+#define MEGABYTE          (1024.0 * 1024.0)
+
+//
+// Representative sources for each language that the LexerDatabase knows,
+// they are repeated until the corpus reaches the requested size. Languages
+// without a sample here are measured with the generic one at the bottom.
+//
+struct Sample {
+    const char *language;
+    const char *text;
+};
+
+static const Sample SAMPLES[] = {
+    {
+        "ada", R"CORPUS(-- Bounded stack of integers
+with Ada.Text_IO; use Ada.Text_IO;
+
+package body Stacks is
+   procedure Push (S : in out Stack; Item : Integer) is
+   begin
+      if S.Top = Capacity then
+         raise Overflow with "stack is full";
+      end if;
+      S.Top := S.Top + 1;
+      S.Items (S.Top) := Item;
+   end Push;
+
+   function Pop (S : in out Stack) return Integer is
+      Result : constant Integer := S.Items (S.Top);
+   begin
+      S.Top := S.Top - 1;
+      Put_Line ("Popped" & Integer'Image (Result));
+      return Result;
+   end Pop;
+end Stacks;
+)CORPUS"
+    },
+    {
+        "asm", R"CORPUS(; Copies a zero terminated string
+section .text
+global copy_string
+
+copy_string:
+    push    rbp
+    mov     rbp, rsp
+    xor     rcx, rcx
+.loop:
+    mov     al, byte [rsi + rcx]
+    mov     byte [rdi + rcx], al
+    inc     rcx
+    test    al, al
+    jnz     .loop
+    mov     rax, rcx        ; return the length
+    pop     rbp
+    ret
+
+section .data
+message: db "Hello, world", 10, 0
+)CORPUS"
+    },
+    {
+        "haskell", R"CORPUS(-- | Run-length encoding of a list
+module Encode (encode, decode) where
+
+import Data.List (group)
+
+{- The encoded form stores each element
+   together with its repetition count -}
+encode :: Eq a => [a] -> [(Int, a)]
+encode = map (\xs -> (length xs, head xs)) . group
+
+decode :: [(Int, a)] -> [a]
+decode = concatMap (uncurry replicate)
+
+main :: IO ()
+main = do
+  let sample = "aaabccddd"
+  print (encode sample)
+  putStrLn $ decode [(3, 'x'), (2, 'y')]
+)CORPUS"
+    },
+    {
+        "lisp", R"CORPUS(;;; Association list helpers
+(defun alist-get-or (key alist default)
+  "Returns the value of KEY in ALIST or DEFAULT."
+  (let ((cell (assoc key alist :test #'equal)))
+    (if cell
+        (cdr cell)
+        default)))
+
+(defmacro with-counter ((var &optional (start 0)) &body body)
+  `(let ((,var ,start))
+     (flet ((tick () (incf ,var)))
+       ,@body
+       ,var)))
+
+#| A block comment
+   spanning several lines |#
+(format t "~a items~%" (with-counter (n) (dotimes (i 10) (tick))))
+)CORPUS"
+    },
+    {
+        "nsis", R"CORPUS(; Installer script
+!define APPNAME "Thunderpad"
+!include "MUI2.nsh"
+
+Name "${APPNAME}"
+OutFile "setup.exe"
+InstallDir "$PROGRAMFILES\${APPNAME}"
+RequestExecutionLevel admin
+
+Section "Install"
+    SetOutPath $INSTDIR
+    File /r "bin\*.*"
+    WriteUninstaller "$INSTDIR\uninstall.exe"
+    CreateShortCut "$SMPROGRAMS\${APPNAME}.lnk" "$INSTDIR\thunderpad.exe"
+SectionEnd
+
+Function .onInit
+    StrCmp $LANGUAGE "1033" done
+    MessageBox MB_OK "Only English is supported"
+done:
+FunctionEnd
+)CORPUS"
+    },
+    {
+        "bash", R"CORPUS(#!/bin/bash
+# Rotates the log files in the given directory
+set -euo pipefail
+
+LOG_DIR="${1:-/var/log/app}"
+KEEP=5
+
+rotate() {
+    local file="$1"
+    for i in $(seq $((KEEP - 1)) -1 1); do
+        [ -f "$file.$i" ] && mv "$file.$i" "$file.$((i + 1))"
+    done
+    mv "$file" "$file.1" && touch "$file"
+}
+
+for log in "$LOG_DIR"/*.log; do
+    echo "Rotating $log"
+    rotate "$log"
+done
+)CORPUS"
+    },
+    {
+        "batch", R"CORPUS(@echo off
+rem Builds the project in release mode
+setlocal enabledelayedexpansion
+
+set BUILD_DIR=%~dp0build
+if not exist "%BUILD_DIR%" mkdir "%BUILD_DIR%"
+
+pushd "%BUILD_DIR%"
+qmake ..\thunderpad.pro CONFIG+=release
+if errorlevel 1 goto :error
+nmake
+popd
+goto :eof
+
+:error
+echo Build failed with code %errorlevel%
+exit /b 1
+)CORPUS"
+    },
+    {
+        "cmake", R"CORPUS(# Project definition
+cmake_minimum_required(VERSION 3.1)
+project(Thunderpad VERSION 0.9.3 LANGUAGES CXX)
+
+set(CMAKE_AUTOMOC ON)
+find_package(Qt5 COMPONENTS Widgets PrintSupport REQUIRED)
+
+file(GLOB SOURCES src/*.cpp src/editor/*.cpp)
+add_executable(thunderpad ${SOURCES} res/res.qrc)
+
+if(UNIX AND NOT APPLE)
+    target_link_libraries(thunderpad qscintilla2 z)
+else()
+    target_link_libraries(thunderpad qscintilla2_qt5)
+endif()
+
+install(TARGETS thunderpad DESTINATION bin)
+)CORPUS"
+    },
+    {
+        "cpp", R"CORPUS(#include <vector>
+#include <string>
+
+/* Splits a string at every occurrence of the separator */
+std::vector<std::string> split (const std::string &text, char separator) {
+    std::vector<std::string> parts;
+    std::string::size_type start = 0;
+
+    for (std::string::size_type i = 0; i <= text.size(); ++i) {
+        if (i == text.size() || text[i] == separator) {
+            parts.push_back (text.substr (start, i - start));
+            start = i + 1;
+        }
+    }
+
+#ifdef DEBUG
+    printf ("%d parts\n", (int) parts.size());
+#endif
+    return parts; // moved out
+}
+)CORPUS"
+    },
+    {
+        "csharp", R"CORPUS(using System;
+using System.Collections.Generic;
+
+namespace Thunderpad.Tools
+{
+    /// <summary>Counts the words of a text</summary>
+    public static class WordCounter
+    {
+        public static Dictionary<string, int> Count(string text)
+        {
+            var result = new Dictionary<string, int>();
+            foreach (var word in text.Split(' ', '\n', '\t'))
+            {
+                if (string.IsNullOrEmpty(word)) continue;
+                result.TryGetValue(word, out int count);
+                result[word] = count + 1;
+            }
+            return result; // @"verbatim"
+        }
+    }
+}
+)CORPUS"
+    },
+    {
+        "css", R"CORPUS(/* Editor toolbar */
+.toolbar {
+    display: flex;
+    padding: 4px 8px;
+    background: linear-gradient(#fafafa, #e0e0e0);
+    border-bottom: 1px solid #c0c0c0;
+}
+
+.toolbar > button:hover,
+.toolbar > button:focus {
+    color: #1a73e8;
+    outline: none !important;
+}
+
+@media (max-width: 600px) {
+    .toolbar { flex-direction: column; }
+}
+
+#status-bar::after { content: "ready"; font-size: 0.9em; }
+)CORPUS"
+    },
+    {
+        "d", R"CORPUS(import std.stdio;
+import std.algorithm : filter, map;
+
+/// Returns the squares of the even numbers
+auto evenSquares(int[] values)
+{
+    return values.filter!(v => v % 2 == 0)
+                 .map!(v => v * v);
+}
+
+void main()
+{
+    int[] numbers = [1, 2, 3, 4, 5, 6];
+    /+ nested /+ comment +/ here +/
+    foreach (square; evenSquares(numbers))
+        writefln("%d", square);
+
+    immutable string name = "thunderpad";
+    writeln(name ~ " " ~ __VERSION__.stringof);
+}
+)CORPUS"
+    },
+    {
+        "diff", R"CORPUS(diff --git a/src/editor/editor.cpp b/src/editor/editor.cpp
+index 3f2a1c4..8b9e0d7 100644
+--- a/src/editor/editor.cpp
++++ b/src/editor/editor.cpp
+@@ -120,7 +120,9 @@ void Editor::updateLexer (void) {
+     QString _language = lexerDatabase()->languageForFile (m_file);
+-    setLexer (lexerDatabase()->getLexer (m_file, theme(), this));
++    QsciLexer *_current = lexer();
++    if (_current == NULL)
++        _current = lexerDatabase()->cloneLexer (_language, theme(), this);
+ 
+     updateSettings();
+ }
+@@ -240,3 +242,4 @@ void Editor::updateSettings (void) {
+     setTabWidth (settings()->tabWidth());
++    setIndentationsUseTabs (false);
+ }
+)CORPUS"
+    },
+    {
+        "fortran", R"CORPUS(! Solves a tridiagonal system
+module tridiagonal
+  implicit none
+contains
+  subroutine solve(a, b, c, d, x, n)
+    integer, intent(in) :: n
+    real(8), intent(in) :: a(n), b(n), c(n), d(n)
+    real(8), intent(out) :: x(n)
+    real(8) :: cp(n), dp(n), m
+    integer :: i
+
+    cp(1) = c(1) / b(1)
+    dp(1) = d(1) / b(1)
+    do i = 2, n
+      m = b(i) - cp(i - 1) * a(i)
+      cp(i) = c(i) / m
+      dp(i) = (d(i) - dp(i - 1) * a(i)) / m
+    end do
+    x(n) = dp(n)
+  end subroutine solve
+end module tridiagonal
+)CORPUS"
+    },
+    {
+        "fortran77", R"CORPUS(C     Computes the factorial of N
+      PROGRAM FACT
+      INTEGER N, I
+      DOUBLE PRECISION RESULT
+      N = 10
+      RESULT = 1.0D0
+      DO 10 I = 1, N
+         RESULT = RESULT * I
+   10 CONTINUE
+      WRITE (*, 20) N, RESULT
+   20 FORMAT (' FACTORIAL OF ', I3, ' IS ', F20.1)
+      IF (RESULT .GT. 1.0D6) THEN
+         PRINT *, 'LARGE RESULT'
+      ENDIF
+      STOP
+      END
+)CORPUS"
+    },
+    {
+        "html", R"CORPUS(<!DOCTYPE html>
+<html lang="en">
+<head>
+  <meta charset="utf-8">
+  <title>Thunderpad</title>
+  <style>body { font-family: sans-serif; }</style>
+  <!-- page scripts -->
+  <script>
+    document.addEventListener("DOMContentLoaded", function () {
+      var items = document.querySelectorAll("li.item");
+      console.log(items.length + " items");
+    });
+  </script>
+</head>
+<body>
+  <h1 class="title">Release notes</h1>
+  <ul>
+    <li class="item">Faster <em>syntax highlighting</em> &amp; folding</li>
+    <li class="item"><a href="https://example.org/">Download</a></li>
+  </ul>
+</body>
+</html>
+)CORPUS"
+    },
+    {
+        "java", R"CORPUS(package org.thunderpad.tools;
+
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * Keeps the most recently used files.
+ */
+public class RecentFiles {
+    private static final int LIMIT = 10;
+    private final List<String> files = new ArrayList<>();
+
+    public void add(String file) {
+        files.remove(file);
+        files.add(0, file);
+        while (files.size() > LIMIT) {
+            files.remove(files.size() - 1);
+        }
+    }
+
+    @Override
+    public String toString() {
+        return "RecentFiles" + files; // debugging aid
+    }
+}
+)CORPUS"
+    },
+    {
+        "javascript", R"CORPUS(// Debounces the given function
+function debounce(fn, delay) {
+    var timer = null;
+    return function () {
+        var args = arguments, self = this;
+        clearTimeout(timer);
+        timer = setTimeout(function () {
+            fn.apply(self, args);
+        }, delay);
+    };
+}
+
+/* Autosave the document every second */
+const save = debounce(async (doc) => {
+    const response = await fetch("/save", { method: "POST", body: doc.text });
+    if (!response.ok) throw new Error(`save failed: ${response.status}`);
+}, 1000);
+
+var pattern = /^\s*(\w+)\s*=\s*(.*)$/gm;
+)CORPUS"
+    },
+    {
+        "lua", R"CORPUS(-- Simple class with inheritance
+local Shape = {}
+Shape.__index = Shape
+
+function Shape.new(name)
+    local self = setmetatable({}, Shape)
+    self.name = name or "shape"
+    return self
+end
+
+function Shape:describe()
+    return string.format("%s with area %.2f", self.name, self:area())
+end
+
+--[[ Circles override the area
+     method of the base shape ]]
+local Circle = setmetatable({}, { __index = Shape })
+Circle.__index = Circle
+
+function Circle:area() return math.pi * self.radius ^ 2 end
+
+for i = 1, 3 do print(i, [[long string]]) end
+)CORPUS"
+    },
+    {
+        "makefile", R"CORPUS(# Builds the command line tools
+CC      ?= gcc
+CFLAGS  += -O2 -Wall -Wextra
+PREFIX  ?= /usr/local
+SOURCES := $(wildcard src/*.c)
+OBJECTS := $(SOURCES:.c=.o)
+
+.PHONY: all clean install
+
+all: tool
+
+tool: $(OBJECTS)
+	$(CC) $(CFLAGS) -o $@ $^ $(LDFLAGS)
+
+%.o: %.c
+	$(CC) $(CFLAGS) -c -o $@ $<
+
+install: tool
+	install -m 755 tool $(DESTDIR)$(PREFIX)/bin/
+
+clean:
+	rm -f $(OBJECTS) tool
+)CORPUS"
+    },
+    {
+        "matlab", R"CORPUS(% Plots a damped oscillation
+function plot_damped(zeta, omega)
+    if nargin < 2
+        omega = 2 * pi;
+    end
+
+    t = linspace(0, 10, 1000);
+    y = exp(-zeta * omega * t) .* cos(omega * sqrt(1 - zeta^2) * t);
+
+    figure;
+    plot(t, y, 'LineWidth', 2);
+    xlabel('time [s]');
+    ylabel('amplitude');
+    title(sprintf('zeta = %.2f', zeta));
+    grid on;
+end
+)CORPUS"
+    },
+    {
+        "pascal", R"CORPUS(program Primes;
+{ Prints the prime numbers below a limit }
+const
+  Limit = 100;
+var
+  Sieve: array[2..Limit] of Boolean;
+  I, J: Integer;
+begin
+  for I := 2 to Limit do
+    Sieve[I] := True;
+  for I := 2 to Limit do
+    if Sieve[I] then
+    begin
+      Write(I, ' ');
+      J := I * I;
+      while J <= Limit do
+      begin
+        Sieve[J] := False; (* not a prime *)
+        J := J + I;
+      end;
+    end;
+  WriteLn;
+end.
+)CORPUS"
+    },
+    {
+        "perl", R"CORPUS(#!/usr/bin/perl
+# Counts the words in the given files
+use strict;
+use warnings;
+
+my %count;
+while (my $line = <>) {
+    chomp $line;
+    next if $line =~ /^\s*#/;
+    $count{lc $_}++ for split /\W+/, $line;
+}
+
+foreach my $word (sort { $count{$b} <=> $count{$a} } keys %count) {
+    printf "%-20s %5d\n", $word, $count{$word};
+}
+
+print <<"END";
+Done, ${\ scalar keys %count} distinct words
+END
+)CORPUS"
+    },
+    {
+        "postscript", R"CORPUS(%!PS-Adobe-3.0
+%%Title: Grid
+/inch { 72 mul } def
+/cell 0.5 inch def
+
+% Draws a square with the given size
+/square {
+    /size exch def
+    newpath 0 0 moveto
+    size 0 rlineto 0 size rlineto size neg 0 rlineto
+    closepath stroke
+} def
+
+1 inch 1 inch translate
+0 1 9 {
+    /row exch def
+    gsave 0 row cell mul translate
+    cell square grestore
+} for
+(Grid) show
+showpage
+)CORPUS"
+    },
+    {
+        "python", R"CORPUS(#!/usr/bin/env python3
+"""Finds duplicated files below a directory."""
+
+import hashlib
+import os
+from collections import defaultdict
+
+
+def digest(path, block=65536):
+    h = hashlib.sha1()
+    with open(path, "rb") as f:
+        for chunk in iter(lambda: f.read(block), b""):
+            h.update(chunk)
+    return h.hexdigest()
+
+
+class Finder:
+    def __init__(self, root):
+        self.root = root
+
+    def duplicates(self):
+        groups = defaultdict(list)
+        for base, _, files in os.walk(self.root):
+            for name in files:
+                groups[digest(os.path.join(base, name))].append(name)
+        return [g for g in groups.values() if len(g) > 1]  # only dupes
+)CORPUS"
+    },
+    {
+        "ruby", R"CORPUS(# Minimal key/value store
+require 'json'
+
+class Store
+  attr_reader :path
+
+  def initialize(path)
+    @path = path
+    @data = File.exist?(path) ? JSON.parse(File.read(path)) : {}
+  end
+
+  def [](key)
+    @data.fetch(key.to_s) { nil }
+  end
+
+  def []=(key, value)
+    @data[key.to_s] = value
+    File.write(@path, JSON.pretty_generate(@data))
+  end
+end
+
+store = Store.new("/tmp/store.json")
+store[:visits] = (store[:visits] || 0) + 1
+puts "Visits: #{store[:visits]}"
+)CORPUS"
+    },
+    {
+        "spice", R"CORPUS(* RC low pass filter
+.title RC filter
+V1 in 0 AC 1 SIN(0 1 1k)
+R1 in out 1k
+C1 out 0 159n
+
+.model DMOD D (IS=1e-14 N=1.05)
+D1 out 0 DMOD
+
+.ac dec 100 10 100k
+.tran 10u 5m
+.control
+run
+plot v(out)
+.endc
+.end
+)CORPUS"
+    },
+    {
+        "sql", R"CORPUS(-- Monthly revenue per customer
+CREATE TABLE IF NOT EXISTS orders (
+    id          INTEGER PRIMARY KEY,
+    customer_id INTEGER NOT NULL REFERENCES customers (id),
+    total       DECIMAL(10, 2) DEFAULT 0,
+    created_at  TIMESTAMP NOT NULL
+);
+
+SELECT c.name,
+       strftime('%Y-%m', o.created_at) AS month,
+       SUM(o.total) AS revenue
+  FROM customers c
+  JOIN orders o ON o.customer_id = c.id
+ WHERE o.created_at >= '2015-01-01'
+ GROUP BY c.name, month
+HAVING revenue > 100
+ ORDER BY revenue DESC; /* largest first */
+)CORPUS"
+    },
+    {
+        "tcl", R"CORPUS(# Prints a multiplication table
+proc table {size} {
+    for {set i 1} {$i <= $size} {incr i} {
+        set row {}
+        for {set j 1} {$j <= $size} {incr j} {
+            lappend row [format "%4d" [expr {$i * $j}]]
+        }
+        puts [join $row ""]
+    }
+}
+
+namespace eval ::util {
+    variable count 0
+    proc bump {} { variable count; incr count }
+}
+
+if {[info exists argv] && [llength $argv] > 0} {
+    table [lindex $argv 0]
+} else {
+    table 10
+}
+)CORPUS"
+    },
+    {
+        "tex", R"CORPUS(\documentclass[11pt]{article}
+\usepackage{amsmath}
+\usepackage[utf8]{inputenc}
+
+% Title and author
+\title{Notes on Lexing}
+\author{Thunderpad}
+
+\begin{document}
+\maketitle
+
+\section{Introduction}
+A lexer splits the text in \emph{tokens}, its cost is
+\begin{equation}
+  T(n) = \sum_{i=1}^{n} c_i \approx \mathcal{O}(n).
+\end{equation}
+
+\subsection{Incremental styling}
+Only the lines after an edit are styled again, see~\cite{scintilla}.
+\end{document}
+)CORPUS"
+    },
+    {
+        "verilog", R"CORPUS(// 8 bit counter with synchronous reset
+module counter #(parameter WIDTH = 8) (
+    input  wire             clk,
+    input  wire             rst,
+    input  wire             enable,
+    output reg [WIDTH-1:0]  value
+);
+
+    /* The counter wraps around */
+    always @(posedge clk) begin
+        if (rst)
+            value <= {WIDTH{1'b0}};
+        else if (enable)
+            value <= value + 1'b1;
+    end
+
+`ifdef SIMULATION
+    initial $display("counter width = %0d", WIDTH);
+`endif
+endmodule
+)CORPUS"
+    },
+    {
+        "vhdl", R"CORPUS(-- 2 to 1 multiplexer
+library ieee;
+use ieee.std_logic_1164.all;
+
+entity mux2 is
+    generic (WIDTH : integer := 8);
+    port (
+        sel : in  std_logic;
+        a   : in  std_logic_vector(WIDTH - 1 downto 0);
+        b   : in  std_logic_vector(WIDTH - 1 downto 0);
+        y   : out std_logic_vector(WIDTH - 1 downto 0)
+    );
+end entity mux2;
+
+architecture rtl of mux2 is
+begin
+    process (sel, a, b)
+    begin
+        if sel = '0' then
+            y <= a;
+        else
+            y <= b;
+        end if;
+    end process;
+end architecture rtl;
+)CORPUS"
+    },
+    {
+        "xml", R"CORPUS(<?xml version="1.0" encoding="UTF-8"?>
+<!-- Editor configuration -->
+<configuration version="2">
+  <editor font="Monospace" size="10">
+    <option name="word-wrap" value="true"/>
+    <option name="tab-width" value="4"/>
+  </editor>
+  <languages>
+    <language name="cpp" extensions="c cpp h hpp"/>
+    <language name="python" extensions="py pyw"/>
+  </languages>
+  <![CDATA[ raw <text> & more ]]>
+  <recent>
+    <file path="/home/user/notes.txt" line="42"/>
+  </recent>
+</configuration>
+)CORPUS"
+    },
+    {
+        "yaml", R"CORPUS(# Continuous integration
+name: build
+on:
+  push:
+    branches: [ master, "release/*" ]
+  pull_request:
+
+jobs:
+  linux:
+    runs-on: ubuntu-latest
+    env:
+      QT_QPA_PLATFORM: offscreen
+    steps:
+      - uses: actions/checkout@v2
+      - name: Install dependencies
+        run: |
+          sudo apt-get update
+          sudo apt-get install -y qt5-default libqscintilla2-qt5-dev
+      - name: Build
+        run: qmake && make -j4   # parallel build
+---
+anchors: &defaults
+  retries: 3
+)CORPUS"
+    },
+    {
+        "json", R"CORPUS({
+    "name": "thunderpad",
+    "version": "0.9.3",
+    "settings": {
+        "font": "Monospace",
+        "size": 10,
+        "wrap": true,
+        "ratio": 1.5e-3,
+        "theme": null
+    },
+    "recent": [
+        { "path": "/home/user/notes.txt", "line": 42 },
+        { "path": "C:\\Users\\user\\todo.md", "line": 7 }
+    ],
+    "tags": ["editor", "qt", "\u00e9dition"]
+}
+)CORPUS"
+    },
+    {
+        "toml", R"CORPUS(# Package manifest
+[package]
+name = "thunderpad-tools"
+version = "0.9.3"
+authors = ["Alex Spataru <alex@example.org>"]
+edition = 2018
+
+[dependencies]
+serde = { version = "1.0", features = ["derive"] }
+regex = "1"
+
+[profile.release]
+lto = true
+opt-level = 3
+
+[[bin]]
+name = 'lexer-bench'
+path = "src/main.rs"
+released = 2015-06-01T10:00:00Z
+description = """
+A multi-line
+string"""
+)CORPUS"
+    },
+    {
+        "markdown", R"CORPUS(# Thunderpad
+
+A **simple** and *fast* text editor written with `Qt` and QScintilla.
+
+## Building
+
+1. Install the dependencies
+2. Run `qmake` and `make`
+
+```sh
+qmake thunderpad.pro
+make -j4
+```
+
+> Large files are opened in a read-only viewer.
+
+- [Download](https://example.org/download)
+- ![Screenshot](doc/screenshot.png)
+
+---
+
+| Option | Default |
+|--------|---------|
+| wrap   | on      |
+)CORPUS"
+    },
+    {
+        "go", R"CORPUS(package main
+
+import (
+	"fmt"
+	"strings"
+)
+
+// Tokenizer splits the input in words
+type Tokenizer struct {
+	input string
+	pos   int
+}
+
+func (t *Tokenizer) Next() (string, bool) {
+	for t.pos < len(t.input) && t.input[t.pos] == ' ' {
+		t.pos++
+	}
+	start := t.pos
+	for t.pos < len(t.input) && t.input[t.pos] != ' ' {
+		t.pos++
+	}
+	return t.input[start:t.pos], start < t.pos
+}
+
+/* Entry point */
+func main() {
+	t := &Tokenizer{input: strings.Repeat("go fast ", 3)}
+	for w, ok := t.Next(); ok; w, ok = t.Next() {
+		fmt.Printf("%q %d\n", w, 0x1F)
+	}
+	raw := `raw string`
+	_ = raw
+}
+)CORPUS"
+    },
+    {
+        "rust", R"CORPUS(use std::collections::HashMap;
+
+/// Counts the words of a text
+pub fn word_count(text: &str) -> HashMap<&str, usize> {
+    let mut counts = HashMap::new();
+    for word in text.split_whitespace() {
+        *counts.entry(word).or_insert(0) += 1;
+    }
+    counts
+}
+
+#[derive(Debug, Clone)]
+struct Span<'a> {
+    text: &'a str,
+    start: usize,
+}
+
+fn main() {
+    /* sample input */
+    let counts = word_count("a b a c b a");
+    let raw = r"C:\path";
+    let byte = b'x';
+    println!("{:?} {} {} {}", counts, raw, byte, 1_000u32);
+}
+)CORPUS"
+    },
+    {
+        "protobuf", R"CORPUS(syntax = "proto3";
+
+package thunderpad.sync;
+
+import "google/protobuf/timestamp.proto";
+
+// A document stored on the server
+message Document {
+  string path = 1;
+  bytes contents = 2;
+  google.protobuf.Timestamp modified = 3;
+  repeated string tags = 4;
+
+  enum Encoding {
+    UTF8 = 0;
+    LATIN1 = 1;
+  }
+  Encoding encoding = 5;
+}
+
+service Sync {
+  rpc Upload (stream Document) returns (Document);
+}
+)CORPUS"
+    },
+    {
+        "plaintext", R"CORPUS(Thunderpad is a simple text editor. It highlights the syntax of
+the most common programming languages, opens large files in a
+read-only viewer and remembers the documents that were open when
+the application was closed.
+
+These lines are used for every language that does not have a
+sample of its own, so that every lexer is measured.
+)CORPUS"
+    }
+};
+
+//
+// The results of measuring one lexer
+//
+struct Result {
+    QString language;
+    QString lexer;
+    qint64 bytes;
+    int lines;
+    double style_ms;
+    double fold_ms;
+    double edit_ms_avg;
+    double edit_ms_max;
+};
+
+//
+// Returns the built-in sample of the given language, or the plain text
+// sample when the language has no sample of its own
+//
+static QByteArray sample (const QString &language) {
+    const int count = sizeof (SAMPLES) / sizeof (SAMPLES[0]);
+
+    for (int i = 0; i < count; ++i) {
+        if (language == SAMPLES[i].language)
+            return QByteArray (SAMPLES[i].text);
+    }
+
+    return QByteArray (SAMPLES[count - 1].text);
+}
+
+//
+// Repeats the given text until the corpus has (at least) the given size
+//
+static QByteArray repeat (const QByteArray &text, qint64 size) {
+    QByteArray _corpus;
+    if (text.isEmpty())
+        return _corpus;
+
+    _corpus.reserve (size + text.size());
+    while (_corpus.size() < size)
+        _corpus.append (text);
+
+    return _corpus;
+}
+
+//
+// Reads every file below the given directory and groups their contents
+// by the language that the LexerDatabase assigns to them
+//
+static QHash<QString, QByteArray> loadCorpora (const QString &directory) {
+    QHash<QString, QByteArray> _corpora;
+    QDirIterator _it (directory, QDir::Files, QDirIterator::Subdirectories);
+
+    while (_it.hasNext()) {
+        QFile _file (_it.next());
+        if (!_file.open (QFile::ReadOnly))
+            continue;
+
+        QByteArray _data = _file.readAll();
+        QString _language = LexerDatabase::instance()->languageForFile (
+                                _file.fileName(), _data.left (LANGUAGE_SAMPLE_SIZE));
+
+        _corpora[_language].append (_data);
+        if (!_data.endsWith ('\n'))
+            _corpora[_language].append ('\n');
+    }
+
+    return _corpora;
+}
+
+//
+// Styles (and folds, if enabled) the whole document and returns the
+// best time of the given number of rounds, in milliseconds
+//
+static double styleDocument (QsciScintilla *editor, int rounds) {
+    double _best = -1;
+    QElapsedTimer _timer;
+
+    for (int i = 0; i < rounds; ++i) {
+        editor->SendScintilla (QsciScintilla::SCI_CLEARDOCUMENTSTYLE);
+
+        _timer.start();
+        editor->SendScintilla (QsciScintilla::SCI_COLOURISE, 0L, -1L);
+        double _ms = _timer.nsecsElapsed() / 1e6;
+
+        if (_best < 0 || _ms < _best)
+            _best = _ms;
+    }
+
+    return _best;
+}
+
+//
+// Types one character in the middle of a (pseudo) random line and
+// styles the lines that would be visible around it, as the editor does
+// after each key stroke. The edits are undone after being measured so
+// that every lexer sees the same document.
+//
+static void measureEdits (QsciScintilla *editor, int edits,
+                          double *average, double *maximum) {
+    *average = 0;
+    *maximum = 0;
+
+    int _lines = editor->SendScintilla (QsciScintilla::SCI_GETLINECOUNT);
+    if (edits <= 0 || _lines <= 0)
+        return;
+
+    quint32 _seed = EDIT_SEED;
+    QElapsedTimer _timer;
+
+    for (int i = 0; i < edits; ++i) {
+        _seed = _seed * 1664525u + 1013904223u;
+        long _line = _seed % _lines;
+
+        long _start = editor->SendScintilla (QsciScintilla::SCI_POSITIONFROMLINE, _line);
+        long _end = editor->SendScintilla (QsciScintilla::SCI_GETLINEENDPOSITION, _line);
+        long _pos = editor->SendScintilla (QsciScintilla::SCI_POSITIONBEFORE,
+                                           editor->SendScintilla (
+                                               QsciScintilla::SCI_POSITIONAFTER,
+                                               _start + (_end - _start) / 2));
+        long _view = -1;
+        if (_line + EDIT_VIEW_LINES < _lines)
+            _view = editor->SendScintilla (QsciScintilla::SCI_POSITIONFROMLINE,
+                                           _line + EDIT_VIEW_LINES);
+
+        _timer.start();
+        editor->SendScintilla (QsciScintilla::SCI_INSERTTEXT, _pos, "x");
+        editor->SendScintilla (QsciScintilla::SCI_COLOURISE, _start, _view);
+        double _ms = _timer.nsecsElapsed() / 1e6;
+
+        *average += _ms;
+        *maximum = qMax (*maximum, _ms);
+
+        editor->SendScintilla (QsciScintilla::SCI_DELETERANGE, _pos, 1L);
+        editor->SendScintilla (QsciScintilla::SCI_COLOURISE, _start, -1L);
+    }
+
+    *average /= edits;
+}
+
+//
+// Measures the full styling, folding and incremental restyling of the
+// given corpus with the lexer that the LexerDatabase uses for the language
+//
+static Result measure (const QString &language, const QByteArray &corpus,
+                       Theme *theme, int edits, int rounds) {
+    Result _result;
+    QsciScintilla _editor;
+    QsciLexer *_lexer = LexerDatabase::instance()->lexerForLanguage (language, theme,
+                        &_editor);
+
+    _editor.setUtf8 (true);
+    _editor.setLexer (_lexer);
+    _editor.setText (QString::fromUtf8 (corpus));
+
+    _result.language = language;
+    _result.lexer = _lexer->language();
+    _result.bytes = corpus.size();
+    _result.lines = _editor.SendScintilla (QsciScintilla::SCI_GETLINECOUNT);
+
+    _editor.setFolding (QsciScintilla::NoFoldStyle);
+    _editor.SendScintilla (QsciScintilla::SCI_SETPROPERTY, "fold", "0");
+    _result.style_ms = styleDocument (&_editor, rounds);
+
+    _editor.setFolding (QsciScintilla::BoxedTreeFoldStyle);
+    _editor.SendScintilla (QsciScintilla::SCI_SETPROPERTY, "fold", "1");
+    _result.fold_ms = qMax (0.0, styleDocument (&_editor, rounds) - _result.style_ms);
+
+    measureEdits (&_editor, edits, &_result.edit_ms_avg, &_result.edit_ms_max);
+    return _result;
+}
+
+//
+// Returns the throughput, in MB/s, of styling the given bytes in \a ms
+//
+static double throughput (qint64 bytes, double ms) {
+    if (ms <= 0)
+        return 0;
+
+    return (bytes / MEGABYTE) / (ms / 1000);
+}
+
+int main (int argc, char *argv[]) {
+    QApplication app (argc, argv);
+    QTextStream err (stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription ("Measures the throughput of the lexers");
+    parser.addHelpOption();
+
+    QCommandLineOption output (QStringList() << "o" << "output",
+                               "Writes the results to <file> instead of stdout.",
+                               "file");
+    QCommandLineOption corpus (QStringList() << "c" << "corpus",
+                               "Loads the corpora from the files in <directory>.",
+                               "directory");
+    QCommandLineOption language (QStringList() << "l" << "language",
+                                 "Only measures <language>, can be repeated.",
+                                 "language");
+    QCommandLineOption size (QStringList() << "s" << "size",
+                             "Size of each corpus in <megabytes>.",
+                             "megabytes", QString::number (DEFAULT_SIZE));
+    QCommandLineOption edits (QStringList() << "e" << "edits",
+                              "Number of single character <edits> to time.",
+                              "edits", QString::number (DEFAULT_EDITS));
+    QCommandLineOption rounds (QStringList() << "r" << "rounds",
+                               "Keeps the best of <rounds> full stylings.",
+                               "rounds", QString::number (DEFAULT_ROUNDS));
+    QCommandLineOption label ("label",
+                              "Stores <label> with the results to tell builds apart.",
+                              "label");
+
+    parser.addOption (output);
+    parser.addOption (corpus);
+    parser.addOption (language);
+    parser.addOption (size);
+    parser.addOption (edits);
+    parser.addOption (rounds);
+    parser.addOption (label);
+    parser.process (app);
+
+    qint64 _size = qMax (0.0, parser.value (size).toDouble()) * MEGABYTE;
+    int _edits = qMax (0, parser.value (edits).toInt());
+    int _rounds = qMax (1, parser.value (rounds).toInt());
+
+    Theme _theme;
+    _theme.readTheme (THEME);
+
+    //
+    // Measure every language known by the database, plus plain text
+    //
+    QStringList _languages = LexerDatabase::instance()->registry()->languages();
+    if (!_languages.contains ("plaintext"))
+        _languages.append ("plaintext");
+
+    if (parser.isSet (language))
+        _languages = parser.values (language);
+
+    QHash<QString, QByteArray> _corpora;
+    if (parser.isSet (corpus))
+        _corpora = loadCorpora (parser.value (corpus));
+
+    QJsonArray _results;
+    foreach (const QString &_language, _languages) {
+        QByteArray _text = _corpora.value (_language);
+        if (_text.isEmpty())
+            _text = sample (_language);
+
+        err << "Measuring " << _language << "..." << endl;
+        Result _result = measure (_language, repeat (_text, _size), &_theme,
+                                  _edits, _rounds);
+
+        QJsonObject _object;
+        _object.insert ("language", _result.language);
+        _object.insert ("lexer", _result.lexer);
+        _object.insert ("bytes", (double) _result.bytes);
+        _object.insert ("lines", _result.lines);
+        _object.insert ("style_ms", _result.style_ms);
+        _object.insert ("style_mb_s", throughput (_result.bytes, _result.style_ms));
+        _object.insert ("fold_ms", _result.fold_ms);
+        _object.insert ("edit_ms_avg", _result.edit_ms_avg);
+        _object.insert ("edit_ms_max", _result.edit_ms_max);
+        _results.append (_object);
+    }
+
+    QJsonObject _build;
+    _build.insert ("qt", QString (qVersion()));
+    _build.insert ("qscintilla", QString (QSCINTILLA_VERSION_STR));
+    _build.insert ("label", parser.value (label));
+
+    QJsonObject _root;
+    _root.insert ("build", _build);
+    _root.insert ("date", QDateTime::currentDateTimeUtc().toString (Qt::ISODate));
+    _root.insert ("corpus_bytes", (double) _size);
+    _root.insert ("edits", _edits);
+    _root.insert ("rounds", _rounds);
+    _root.insert ("results", _results);
+
+    QByteArray _json = QJsonDocument (_root).toJson();
+
+    if (!parser.isSet (output)) {
+        QFile _stdout;
+        _stdout.open (stdout, QFile::WriteOnly);
+        _stdout.write (_json);
+        return 0;
+    }
+
+    QFile _file (parser.value (output));
+    if (!_file.open (QFile::WriteOnly)) {
+        err << "Cannot write " << _file.fileName() << endl;
+        return 1;
+    }
+
+    _file.write (_json);
+    return 0;
+}
@@ -19,17 +19,21 @@
 //  USA
 //
 
+#include <QDir>
 #include <QIcon>
 #include <QTimer>
-#include <QSettings>
 #include <QMessageBox>
 #include <QFileOpenEvent>
 
 #include "app.h"
+#include "editor.h"
 #include "window.h"
 #include "defaults.h"
 #include "platform.h"
 #include "fvupdater.h"
+#include "edit_journal.h"
+#include "journal_writer.h"
+#include "settings_registry.h"
 
 /*!
  * \class Application
@@ -71,6 +75,7 @@ int Application::start (const QString &arguments) {
     QTimer *timer = new QTimer (this);
     timer->singleShot (250, this, SLOT (setupUpdater()));
 
+    recoverDocuments();
     showWelcomeMessages();
 
     return exec();
@@ -92,7 +97,7 @@ void Application::checkForUpdates (void) {
 void Application::setupUpdater (void) {
     FvUpdater::sharedUpdater()->SetFeedURL ("http://thunderpad.sourceforge.net/updater/appcast.xml");
 
-    if (settings()->value ("check-for-updates", SETTINGS_AUTO_CHECK_UPDATES).toBool())
+    if (settings()->checkForUpdates())
         FvUpdater::sharedUpdater()->CheckForUpdates (true);
 }
 
@@ -112,7 +117,7 @@ void Application::showWelcomeMessages (void) {
     //
     // Its the first launch, welcome the user to the application
     //
-    if (settings()->value ("first-launch", true).toBool()) {
+    if (settings()->firstLaunch()) {
         _message.setStandardButtons (QMessageBox::Close);
         _message.setText ("<b>" + tr ("Thank you for downloading Thunderpad!") +
                           "</b>           ");
@@ -126,15 +131,15 @@ void Application::showWelcomeMessages (void) {
 
         _message.exec();
 
-        settings()->setValue ("first-launch", false);
-        settings()->setValue ("second-launch", true);
+        settings()->setFirstLaunch (false);
+        settings()->setSecondLaunch (true);
     }
 
     //
     // Its the second launch, ask the user if he/she wants to allow the application
     // to check for updates automatically
     //
-    else if (settings()->value ("second-launch", false).toBool()) {
+    else if (settings()->secondLaunch()) {
         _message.setStandardButtons (QMessageBox::Yes | QMessageBox::No);
         _message.setDefaultButton (QMessageBox::Yes);
         _message.setText (
@@ -142,11 +147,93 @@ void Application::showWelcomeMessages (void) {
         _message.setInformativeText (tr ("You can always check for updates from the "
                                          "Help menu"));
 
-        settings()->setValue ("second-launch", false);
-        settings()->setValue ("check-for-updates", _message.exec() == QMessageBox::Yes);
+        settings()->setSecondLaunch (false);
+        settings()->setCheckForUpdates (_message.exec() == QMessageBox::Yes);
     }
 }
 
+/*!
+ * Looks for the journals of the documents that were not saved when the
+ * application crashed, and asks the user to recover them. Each recovered
+ * document is opened in a new window (or in the main window if it is empty).
+ *
+ * The journals that cannot be replayed (e.g. because their base file was
+ * changed) are kept, and the user is told which documents were not
+ * recovered.
+ */
+
+void Application::recoverDocuments (void) {
+    QStringList _journals = EditJournal::journals();
+
+    if (_journals.isEmpty())
+        return;
+
+    QMessageBox _message;
+    _message.setWindowModality (Qt::WindowModal);
+    _message.setIcon (QMessageBox::Question);
+    _message.setStandardButtons (QMessageBox::Yes | QMessageBox::No);
+    _message.setDefaultButton (QMessageBox::Yes);
+    _message.setText ("<b>" + tr ("Thunderpad was not closed properly") + "</b>");
+    _message.setInformativeText (tr ("%1 document(s) had unsaved changes. "
+                                     "Do you want to recover them?")
+                                 .arg (_journals.count()));
+
+    QStringList _failed;
+    QStringList _names;
+
+    if (_message.exec() == QMessageBox::Yes) {
+        foreach (const QString &_journal, _journals) {
+            QString _file;
+            QByteArray _text;
+            QByteArray _encoding;
+
+            if (!EditJournal::replay (_journal, &_file, &_encoding, &_text)) {
+                _failed.append (_journal);
+                _names.append (_file.isEmpty() ? tr ("Untitled") :
+                               QDir::toNativeSeparators (_file));
+                continue;
+            }
+
+            //
+            // Use the main window if it does not have a document
+            //
+            Window *_window = m_window;
+            if (!_window->editor()->titleIsShit() ||
+                _window->editor()->isModified() ||
+                _window->editor()->isLoading()) {
+                _window = new Window ("");
+                m_window->configureWindow (_window);
+            }
+
+            _window->editor()->recoverDocument (_file, _encoding, _text);
+        }
+    }
+
+    //
+    // The recovered documents have new journals
+    //
+    foreach (const QString &_journal, _journals) {
+        if (!_failed.contains (_journal))
+            JournalWriter::instance()->removeFile (_journal);
+    }
+
+    if (_failed.isEmpty())
+        return;
+
+    QMessageBox _warning;
+    _warning.setWindowModality (Qt::WindowModal);
+    _warning.setIcon (QMessageBox::Warning);
+    _warning.setStandardButtons (QMessageBox::Ok);
+    _warning.setText ("<b>" + tr ("Some documents could not be recovered") + "</b>");
+    _warning.setInformativeText (tr ("The journals of the following documents cannot be "
+                                     "replayed, their files were probably changed after "
+                                     "the crash:\n\n%1\n\n"
+                                     "The journals were kept in %2")
+                                 .arg (_names.join ("\n"),
+                                       QDir::toNativeSeparators (EditJournal::directory())));
+    _warning.exec();
+}
+
 /*!
  * Gets data from other instances of the application and
  * acts accordingly (ex: open a file or create a new one)
@@ -179,6 +266,6 @@ bool Application::event (QEvent *_event) {
  * Allows the class to access the application settings
  */
 
-QSettings *Application::settings (void) const {
-    return new QSettings (APP_COMPANY, APP_NAME);
+SettingsRegistry *Application::settings (void) const {
+    return SettingsRegistry::instance();
 }
@@ -13,7 +13,7 @@ extern "C++" {
 #endif
 
 class Window;
-class QSettings;
+class SettingsRegistry;
 
 #include <qtsingleapplication.h>
 
@@ -31,6 +31,7 @@ class Application : public QtSingleApplication {
     private slots:
         void setupUpdater (void);
         void showWelcomeMessages (void);
+        void recoverDocuments (void);
         void onMessageReceived (const QString &msg);
 
     protected:
@@ -38,7 +39,7 @@ class Application : public QtSingleApplication {
 
     private:
         Window *m_window;      
-        QSettings *settings (void) const;
+        SettingsRegistry *settings (void) const;
 };
 
 #endif
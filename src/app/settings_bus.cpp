@@ -0,0 +1,108 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QCoreApplication>
+
+#include "window.h"
+#include "settings_bus.h"
+#include "update_scheduler.h"
+
+/*!
+ * \class SettingsBus
+ * \brief Delivers the changed settings to every window of the application
+ *
+ * Each window subscribes once to the bus. When a setting is changed (by
+ * any window), the \c SettingsRegistry publishes its key. The keys
+ * published during the same frame are delivered together, once, to each
+ * window, which forwards them to its widgets or keeps them until it is
+ * shown again.
+ */
+
+/*!
+ * Returns the only instance of the bus
+ */
+
+SettingsBus *SettingsBus::instance (void) {
+    static SettingsBus *_instance = NULL;
+
+    if (_instance == NULL)
+        _instance = new SettingsBus (qApp);
+
+    return _instance;
+}
+
+/*!
+ * \internal
+ * Initializes the bus, the published keys are delivered through the
+ * \c UpdateScheduler so that they are delivered at most once per frame
+ */
+
+SettingsBus::SettingsBus (QObject *parent) : QObject (parent) {
+    UpdateScheduler::instance()->connectUpdate (this, SIGNAL (published()),
+                                                this, SLOT (deliver()));
+}
+
+/*!
+ * Delivers the changed settings to the given \a {window}, the window is
+ * unsubscribed when it is destroyed
+ */
+
+void SettingsBus::subscribe (Window *window) {
+    Q_ASSERT (window != NULL);
+
+    if (!m_windows.contains (window))
+        m_windows.append (window);
+}
+
+/*!
+ * Tells the windows that the setting with the given \a {key} was changed
+ */
+
+void SettingsBus::publish (int key) {
+    if (!m_pending.contains (key))
+        m_pending.append (key);
+
+    emit published();
+}
+
+/*!
+ * \internal
+ * Delivers the published keys to each window and removes the windows
+ * that were destroyed
+ */
+
+void SettingsBus::deliver (void) {
+    QList<int> _keys = m_pending;
+    m_pending.clear();
+
+    QList<QPointer<Window> > _windows;
+    foreach (const QPointer<Window> &_window, m_windows) {
+        if (!_window.isNull())
+            _windows.append (_window);
+    }
+
+    m_windows = _windows;
+
+    foreach (const QPointer<Window> &_window, _windows) {
+        if (!_window.isNull())
+            _window->deliverSettings (_keys);
+    }
+}
@@ -0,0 +1,61 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef SETTINGS_BUS_H
+#define SETTINGS_BUS_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+class Window;
+
+#include <QList>
+#include <QObject>
+#include <QPointer>
+
+class SettingsBus : public QObject {
+        Q_OBJECT
+
+    public:
+        static SettingsBus *instance (void);
+
+        void subscribe (Window *window);
+        void publish (int key);
+
+    signals:
+        void published (void);
+
+    private slots:
+        void deliver (void);
+
+    private:
+        explicit SettingsBus (QObject *parent = 0);
+
+        QList<int> m_pending;
+        QList<QPointer<Window> > m_windows;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -0,0 +1,126 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include "settings_bus.h"
+#include "settings_store.h"
+#include "settings_registry.h"
+
+/*!
+ * \internal
+ * Keys used in the settings file, in the order of \c SettingsRegistry::Key
+ */
+
+static const char *KEY_NAMES [] = {
+#define SETTINGS_REGISTRY_NAME(id, getter, setter, name, type, fallback) name,
+    SETTINGS_REGISTRY (SETTINGS_REGISTRY_NAME)
+#undef SETTINGS_REGISTRY_NAME
+};
+
+/*!
+ * \class SettingsRegistry
+ * \brief Typed access to the settings listed in \c SETTINGS_REGISTRY
+ *
+ * Each entry of the \c SETTINGS_REGISTRY table (in "defaults.h") gets an
+ * identifier in the \c Key enum and a pair of typed accessors, such as
+ * \c wordWrap() and \c setWordWrap(), which return the default value of
+ * the entry when the setting does not exist.
+ *
+ * The values are kept by the \c SettingsStore. When a value is changed, its
+ * key is published on the \c SettingsBus, so each window can re-apply only
+ * the part of its configuration that depends on it.
+ */
+
+/*!
+ * Returns the only instance of the registry
+ */
+
+SettingsRegistry *SettingsRegistry::instance (void) {
+    static SettingsRegistry *_instance = NULL;
+
+    if (_instance == NULL)
+        _instance = new SettingsRegistry();
+
+    return _instance;
+}
+
+/*!
+ * \internal
+ * Initializes the registry
+ */
+
+SettingsRegistry::SettingsRegistry (void) {
+}
+
+/*!
+ * Returns the name of the given \a {key} in the settings file
+ */
+
+QString SettingsRegistry::keyName (Key key) {
+    Q_ASSERT (key >= 0 && key < KeyCount);
+    return QString::fromLatin1 (KEY_NAMES [key]);
+}
+
+/*!
+ * Returns the default value of the given \a {key}
+ */
+
+QVariant SettingsRegistry::defaultValue (Key key) {
+    switch (key) {
+#define SETTINGS_REGISTRY_DEFAULT(id, getter, setter, name, type, fallback) \
+    case id:                                                            \
+        return QVariant::fromValue<type> (fallback);
+        SETTINGS_REGISTRY (SETTINGS_REGISTRY_DEFAULT)
+#undef SETTINGS_REGISTRY_DEFAULT
+
+    default:
+        return QVariant();
+    }
+}
+
+/*!
+ * Returns the value of the given \a {key}, or its default value if the
+ * setting does not exist
+ */
+
+QVariant SettingsRegistry::value (Key key) const {
+    return SettingsStore::instance()->value (keyName (key), defaultValue (key));
+}
+
+/*!
+ * Changes the \a {value} of the given \a {key}, the key is published on the
+ * \c SettingsBus if the value is different
+ */
+
+void SettingsRegistry::setValue (Key key, const QVariant &value) {
+    //
+    // The values read from the settings file may be strings, so both values
+    // are converted to the type of the setting before comparing them
+    //
+    QVariant _old = this->value (key);
+    QVariant _new = value;
+    int _type = defaultValue (key).userType();
+
+    if (_old.convert (_type) && _new.convert (_type) && _old == _new)
+        return;
+
+    SettingsStore::instance()->setValue (keyName (key), _new);
+    SettingsBus::instance()->publish (key);
+}
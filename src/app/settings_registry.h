@@ -0,0 +1,71 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef SETTINGS_REGISTRY_H
+#define SETTINGS_REGISTRY_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QSize>
+#include <QPoint>
+#include <QString>
+#include <QVariant>
+
+#include "defaults.h"
+
+class SettingsRegistry {
+    public:
+#define SETTINGS_REGISTRY_ID(id, getter, setter, name, type, fallback) id,
+        enum Key {
+            SETTINGS_REGISTRY (SETTINGS_REGISTRY_ID)
+            KeyCount
+        };
+#undef SETTINGS_REGISTRY_ID
+
+        static SettingsRegistry *instance (void);
+
+        static QString keyName (Key key);
+        static QVariant defaultValue (Key key);
+
+        QVariant value (Key key) const;
+        void setValue (Key key, const QVariant &value);
+
+#define SETTINGS_REGISTRY_ACCESSORS(id, getter, setter, name, type, fallback) \
+        type getter (void) const {                                            \
+            return value (id).value<type>();                                  \
+        }                                                                     \
+        void setter (const type &_value) {                                    \
+            setValue (id, QVariant::fromValue<type> (_value));                \
+        }
+        SETTINGS_REGISTRY (SETTINGS_REGISTRY_ACCESSORS)
+#undef SETTINGS_REGISTRY_ACCESSORS
+
+    private:
+        SettingsRegistry (void);
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -0,0 +1,174 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QSettings>
+#include <QStringList>
+#include <QMutexLocker>
+#include <QCoreApplication>
+
+#include "settings_store.h"
+
+#define FLUSH_INTERVAL 2000
+
+/*!
+ * \class SettingsStore
+ * \brief Keeps the application settings in memory and writes them in
+ *        the background
+ *
+ * The settings are read from the disk once, when the store is created,
+ * and the calls to \c value() are served from memory. The values given
+ * to \c setValue() are written by the store thread every
+ * \c FLUSH_INTERVAL milliseconds, so several changes of the same key
+ * (such as the geometry of a window that is being dragged) cause a
+ * single write. Setting a key to its current value does nothing.
+ *
+ * The pending values are written when the application quits.
+ */
+
+/*!
+ * Returns the only instance of the store, the settings are loaded and
+ * the thread is started the first time this function is called
+ */
+
+SettingsStore *SettingsStore::instance (void) {
+    static SettingsStore *_instance = NULL;
+
+    if (_instance == NULL) {
+        _instance = new SettingsStore (qApp);
+        _instance->start (QThread::LowPriority);
+
+        connect (qApp, SIGNAL (aboutToQuit()), _instance, SLOT (stop()));
+    }
+
+    return _instance;
+}
+
+/*!
+ * \internal
+ * Loads the settings from the disk
+ */
+
+SettingsStore::SettingsStore (QObject *parent) : QThread (parent),
+    m_stop (false) {
+    QSettings _settings (APP_COMPANY, APP_NAME);
+
+    foreach (const QString &_key, _settings.allKeys())
+        m_values.insert (_key, _settings.value (_key));
+}
+
+/*!
+ * Returns the value of the given \a {key}, or \a {default_value} if
+ * the key does not exist
+ */
+
+QVariant SettingsStore::value (const QString &key, const QVariant &default_value) const {
+    QMutexLocker _locker (&m_mutex);
+    return m_values.value (key, default_value);
+}
+
+/*!
+ * Changes the \a {value} of the given \a {key}, the value is written to
+ * the disk later
+ */
+
+void SettingsStore::setValue (const QString &key, const QVariant &value) {
+    QMutexLocker _locker (&m_mutex);
+
+    QHash<QString, QVariant>::const_iterator _it = m_values.constFind (key);
+    if (_it != m_values.constEnd() && _it.value() == value)
+        return;
+
+    m_values.insert (key, value);
+    m_pending.insert (key, value);
+
+    //
+    // The thread is stopped when the application quits, but the windows
+    // may still save their state while they are destroyed
+    //
+    if (m_stop) {
+        _locker.unlock();
+        write();
+    }
+}
+
+/*!
+ * Writes the pending values without waiting for the next interval
+ */
+
+void SettingsStore::flush (void) {
+    m_condition.wakeAll();
+}
+
+/*!
+ * Writes the pending values and stops the thread
+ */
+
+void SettingsStore::stop (void) {
+    m_mutex.lock();
+    m_stop = true;
+    m_condition.wakeAll();
+    m_mutex.unlock();
+
+    wait();
+}
+
+/*!
+ * \internal
+ * Writes the pending values every \c FLUSH_INTERVAL milliseconds
+ */
+
+void SettingsStore::run (void) {
+    m_mutex.lock();
+
+    while (!m_stop) {
+        m_condition.wait (&m_mutex, FLUSH_INTERVAL);
+
+        m_mutex.unlock();
+        write();
+        m_mutex.lock();
+    }
+
+    m_mutex.unlock();
+    write();
+}
+
+/*!
+ * \internal
+ * Writes the pending values to the disk
+ */
+
+void SettingsStore::write (void) {
+    m_mutex.lock();
+    QHash<QString, QVariant> _pending = m_pending;
+    m_pending.clear();
+    m_mutex.unlock();
+
+    if (_pending.isEmpty())
+        return;
+
+    QSettings _settings (APP_COMPANY, APP_NAME);
+
+    QHash<QString, QVariant>::const_iterator _it;
+    for (_it = _pending.constBegin(); _it != _pending.constEnd(); ++_it)
+        _settings.setValue (_it.key(), _it.value());
+
+    _settings.sync();
+}
@@ -0,0 +1,68 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QHash>
+#include <QMutex>
+#include <QThread>
+#include <QString>
+#include <QVariant>
+#include <QWaitCondition>
+
+class SettingsStore : public QThread {
+        Q_OBJECT
+
+    public:
+        static SettingsStore *instance (void);
+
+        QVariant value (const QString &key,
+                        const QVariant &default_value = QVariant()) const;
+        void setValue (const QString &key, const QVariant &value);
+
+    public slots:
+        void flush (void);
+        void stop (void);
+
+    protected:
+        void run (void);
+
+    private:
+        explicit SettingsStore (QObject *parent = 0);
+        void write (void);
+
+        bool m_stop;
+        mutable QMutex m_mutex;
+        QWaitCondition m_condition;
+        QHash<QString, QVariant> m_values;
+        QHash<QString, QVariant> m_pending;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -0,0 +1,250 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QDebug>
+#include <QCoreApplication>
+
+#include "update_scheduler.h"
+
+#define FRAME_INTERVAL 16
+#define STATISTICS_VARIABLE "THUNDERPAD_UPDATE_STATS"
+
+/*!
+ * \class UpdateScheduler
+ * \brief Coalesces the UI updates requested by the editor and the window
+ *
+ * Consumers such as the window title, the status bar labels or the
+ * line number margin are refreshed when the document changes. Typing or
+ * pasting may emit several change signals in a row, so instead of calling
+ * the consumers directly, the signals mark them as dirty and the scheduler
+ * calls each dirty consumer once, in the next idle tick and at most once
+ * every \c FRAME_INTERVAL milliseconds.
+ *
+ * The scheduler counts the update requests and the updates that were
+ * actually performed, the difference is the number of redundant updates
+ * that were saved. The counters are printed when the application quits
+ * if the \c THUNDERPAD_UPDATE_STATS environment variable is set.
+ */
+
+/*!
+ * Returns the only instance of the scheduler, which is shared by all the
+ * windows of the application
+ */
+
+UpdateScheduler *UpdateScheduler::instance (void) {
+    static UpdateScheduler *_instance = NULL;
+
+    if (_instance == NULL) {
+        _instance = new UpdateScheduler (qApp);
+
+        if (qEnvironmentVariableIsSet (STATISTICS_VARIABLE))
+            connect (qApp, SIGNAL (aboutToQuit()), _instance, SLOT (printStatistics()));
+    }
+
+    return _instance;
+}
+
+/*!
+ * \internal
+ * Initializes the scheduler
+ */
+
+UpdateScheduler::UpdateScheduler (QObject *parent) : QObject (parent),
+    m_last_flush (-FRAME_INTERVAL),
+    m_requests (0),
+    m_updates (0) {
+    m_clock.start();
+    m_timer.setSingleShot (true);
+    m_timer.setTimerType (Qt::PreciseTimer);
+
+    connect (&m_timer, SIGNAL (timeout()), this, SLOT (flush()));
+}
+
+/*!
+ * Works like \c QObject::connect(), but instead of calling the \a {slot}
+ * of the \a {receiver} every time that the \a {signal} is emitted, the
+ * receiver is marked as dirty and the slot is called in the next flush.
+ *
+ * The slot must not take any arguments. Several signals may be connected
+ * to the same slot, in which case they share the same dirty flag.
+ */
+
+void UpdateScheduler::connectUpdate (const QObject *sender, const char *signal,
+                                     QObject *receiver, const char *slot) {
+    Q_ASSERT (sender != NULL);
+    Q_ASSERT (receiver != NULL);
+
+    UpdateRequest *_request = new UpdateRequest (consumerId (receiver, slot),
+                                                 receiver);
+    connect (sender, signal, _request, SLOT (request()));
+}
+
+/*!
+ * Returns the number of updates requested by the connected signals
+ */
+
+quint64 UpdateScheduler::requestCount (void) const {
+    return m_requests;
+}
+
+/*!
+ * Returns the number of times that a consumer was actually updated
+ */
+
+quint64 UpdateScheduler::updateCount (void) const {
+    return m_updates;
+}
+
+/*!
+ * Returns the number of update requests that were merged with another
+ * request of the same consumer, which is the work saved by the scheduler
+ */
+
+quint64 UpdateScheduler::savedUpdates (void) const {
+    return m_requests - m_updates;
+}
+
+/*!
+ * Prints the update counters to the debug output, this is used to see
+ * how much work the scheduler saves
+ */
+
+void UpdateScheduler::printStatistics (void) {
+    qDebug() << "UpdateScheduler:" << requestCount() << "requests,"
+             << updateCount() << "updates," << savedUpdates() << "saved";
+}
+
+/*!
+ * Marks the given \a {consumer} as dirty and schedules a flush, the flush
+ * happens in the next idle tick, unless the previous flush happened less
+ * than a frame ago
+ */
+
+void UpdateScheduler::requestUpdate (int consumer) {
+    Q_ASSERT (consumer >= 0 && consumer < m_consumers.count());
+
+    ++m_requests;
+
+    Consumer &_consumer = m_consumers [consumer];
+    if (!_consumer.dirty) {
+        _consumer.dirty = true;
+        m_dirty.append (consumer);
+    }
+
+    if (!m_timer.isActive()) {
+        qint64 _elapsed = m_clock.elapsed() - m_last_flush;
+        m_timer.start (_elapsed >= FRAME_INTERVAL ? 0 : FRAME_INTERVAL - _elapsed);
+    }
+}
+
+/*!
+ * Updates the dirty consumers, each of them is called only once, in
+ * the order in which they were marked as dirty.
+ *
+ * A consumer that requests another update while it is being called
+ * is updated in the next flush.
+ */
+
+void UpdateScheduler::flush (void) {
+    m_timer.stop();
+    m_last_flush = m_clock.elapsed();
+
+    QVector<int> _dirty = m_dirty;
+    m_dirty.clear();
+
+    foreach (int _id, _dirty) {
+        QPointer<QObject> _receiver = m_consumers.at (_id).receiver;
+        QByteArray _method = m_consumers.at (_id).method;
+        m_consumers [_id].dirty = false;
+
+        if (_receiver.isNull())
+            continue;
+
+        ++m_updates;
+        QMetaObject::invokeMethod (_receiver.data(), _method.constData(),
+                                   Qt::DirectConnection);
+    }
+}
+
+/*!
+ * \internal
+ * Returns the index of the consumer that calls the \a {slot} of the
+ * \a {receiver}, the consumer is created if it does not exist yet.
+ *
+ * The consumers of destroyed receivers are reused.
+ */
+
+int UpdateScheduler::consumerId (QObject *receiver, const char *slot) {
+    //
+    // Convert the "1name()" string created by SLOT() into a method name
+    //
+    QByteArray _method = QMetaObject::normalizedSignature (slot + 1);
+    _method.truncate (_method.indexOf ('('));
+
+    int _free = -1;
+    for (int i = 0; i < m_consumers.count(); ++i) {
+        const Consumer &_consumer = m_consumers.at (i);
+
+        if (_consumer.receiver == receiver && _consumer.method == _method)
+            return i;
+
+        else if (_free == -1 && _consumer.receiver.isNull() && !_consumer.dirty)
+            _free = i;
+    }
+
+    Consumer _consumer;
+    _consumer.receiver = receiver;
+    _consumer.method = _method;
+    _consumer.dirty = false;
+
+    if (_free != -1) {
+        m_consumers [_free] = _consumer;
+        return _free;
+    }
+
+    m_consumers.append (_consumer);
+    return m_consumers.count() - 1;
+}
+
+/*!
+ * \class UpdateRequest
+ * \brief Forwards a signal to the \c UpdateScheduler
+ *
+ * An \c UpdateRequest is created by \c UpdateScheduler::connectUpdate()
+ * for each connected signal. It is a child of the receiver, so the
+ * connection is removed when the receiver is destroyed.
+ */
+
+/*!
+ * Initializes the request for the given \a {consumer}
+ */
+
+UpdateRequest::UpdateRequest (int consumer, QObject *parent) : QObject (parent),
+    m_consumer (consumer) {
+}
+
+/*!
+ * Marks the consumer as dirty
+ */
+
+void UpdateRequest::request (void) {
+    UpdateScheduler::instance()->requestUpdate (m_consumer);
+}
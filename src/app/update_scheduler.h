@@ -0,0 +1,91 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef UPDATE_SCHEDULER_H
+#define UPDATE_SCHEDULER_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QTimer>
+#include <QVector>
+#include <QPointer>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+class UpdateScheduler : public QObject {
+        Q_OBJECT
+
+    public:
+        static UpdateScheduler *instance (void);
+
+        void connectUpdate (const QObject *sender, const char *signal,
+                            QObject *receiver, const char *slot);
+
+        quint64 requestCount (void) const;
+        quint64 updateCount (void) const;
+        quint64 savedUpdates (void) const;
+
+    public slots:
+        void requestUpdate (int consumer);
+        void flush (void);
+        void printStatistics (void);
+
+    private:
+        explicit UpdateScheduler (QObject *parent = 0);
+        int consumerId (QObject *receiver, const char *slot);
+
+        struct Consumer {
+            QPointer<QObject> receiver;
+            QByteArray method;
+            bool dirty;
+        };
+
+        QTimer m_timer;
+        QElapsedTimer m_clock;
+        qint64 m_last_flush;
+
+        quint64 m_requests;
+        quint64 m_updates;
+
+        QVector<int> m_dirty;
+        QVector<Consumer> m_consumers;
+};
+
+class UpdateRequest : public QObject {
+        Q_OBJECT
+
+    public:
+        explicit UpdateRequest (int consumer, QObject *parent = 0);
+
+    public slots:
+        void request (void);
+
+    private:
+        int m_consumer;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
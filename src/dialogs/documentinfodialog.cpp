@@ -0,0 +1,309 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QLabel>
+#include <QLocale>
+#include <QFileInfo>
+#include <QScrollBar>
+#include <QStringList>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QTextBrowser>
+#include <QProgressBar>
+
+#include "update_scheduler.h"
+#include "document_analyzer.h"
+#include "documentinfodialog.h"
+
+#define HISTOGRAM_BAR_WIDTH 40
+#define LINE_MEMORY_OVERHEAD 16
+
+/*!
+ * \class DocumentInfoDialog
+ * \brief Displays the statistics of the current document
+ *
+ * The \c DocumentInfoDialog starts the given \c DocumentAnalyzer and
+ * displays its report, which is updated while the document is being
+ * analyzed. The analysis is cancelled when the dialog is closed.
+ */
+
+DocumentInfoDialog::DocumentInfoDialog (DocumentAnalyzer *analyzer,
+                                        const QString &title,
+                                        QWidget *parent) : QDialog (parent) {
+    QIcon _blank;
+    setWindowIcon (_blank);
+    setAttribute (Qt::WA_DeleteOnClose);
+
+    //
+    // Configure the window
+    //
+    resize (480, 560);
+    setWindowTitle (tr ("Document information"));
+
+    //
+    // The analyzer is destroyed (and stopped) with the dialog
+    //
+    m_analyzer = analyzer;
+    m_analyzer->setParent (this);
+
+    //
+    // Initialize UI items
+    //
+    ui_layout = new QVBoxLayout (this);
+    ui_title_label = new QLabel (this);
+    ui_report = new QTextBrowser (this);
+    ui_close_button = new QPushButton (this);
+    ui_progress_bar = new QProgressBar (this);
+
+    ui_close_button->setText (tr ("Close"));
+    ui_title_label->setText ("<b>" + QFileInfo (title).fileName().toHtmlEscaped() + "</b>");
+
+    ui_progress_bar->setRange (0, 100);
+    ui_progress_bar->setValue (0);
+
+    ui_layout->setSpacing (10);
+    ui_layout->addWidget (ui_title_label);
+    ui_layout->addWidget (ui_progress_bar);
+    ui_layout->addWidget (ui_report);
+    ui_layout->addWidget (ui_close_button, 0, Qt::AlignRight);
+
+    //
+    // Display the partial reports at most once per frame
+    //
+    UpdateScheduler *_scheduler = UpdateScheduler::instance();
+    _scheduler->connectUpdate (m_analyzer, SIGNAL (progressChanged()), this, SLOT (updateReport()));
+    _scheduler->connectUpdate (m_analyzer, SIGNAL (finished()), this, SLOT (updateReport()));
+
+    connect (ui_close_button, SIGNAL (clicked()), this, SLOT (close()));
+
+    updateReport();
+    m_analyzer->start (QThread::LowPriority);
+}
+
+/*!
+ * \internal
+ * Displays the last report published by the analyzer
+ */
+
+void DocumentInfoDialog::updateReport (void) {
+    QLocale _locale;
+    DocumentReport _report = m_analyzer->report();
+
+    int _progress = m_analyzer->progress();
+    ui_progress_bar->setValue (_progress);
+    ui_progress_bar->setVisible (!m_analyzer->isComplete());
+
+    QString _html = "<table cellspacing=\"4\">";
+    QString _row = "<tr><td>%1</td><td align=\"right\">%2</td></tr>";
+
+    if (!m_analyzer->errorString().isEmpty())
+        _html.append (_row.arg (tr ("Error"), m_analyzer->errorString().toHtmlEscaped()));
+
+    //
+    // Counts
+    //
+    _html.append (_row.arg (tr ("Size"), formatSize (_report.bytes)));
+    _html.append (_row.arg (tr ("Characters"), _locale.toString (_report.characters)));
+    _html.append (_row.arg (tr ("Words"), _locale.toString (_report.words)));
+    _html.append (_row.arg (tr ("Lines"), _locale.toString (_report.line_ends + 1)));
+    _html.append (_row.arg (tr ("Longest line"),
+                            tr ("%1 (%2 characters)")
+                            .arg (_locale.toString (_report.longest_line + 1))
+                            .arg (_locale.toString (_report.longest_length))));
+
+    //
+    // Format
+    //
+    QString _encoding = m_analyzer->encoding();
+    if (_report.ascii)
+        _encoding.append (" (" + tr ("ASCII only") + ")");
+    else if (!_report.valid_utf8)
+        _encoding.append (" (" + tr ("not valid UTF-8") + ")");
+
+    _html.append (_row.arg (tr ("Encoding"), _encoding.toHtmlEscaped()));
+    _html.append (_row.arg (tr ("Line endings"), lineEndings (_report)));
+    _html.append (_row.arg (tr ("Indentation"), indentation (_report)));
+
+    //
+    // The editor keeps a style byte for each byte of text, and a few
+    // integers (position, fold level and markers) for each line
+    //
+    qint64 _memory = _report.bytes * 2 + (_report.line_ends + 1) * LINE_MEMORY_OVERHEAD;
+    _html.append (_row.arg (tr ("Estimated memory use"), formatSize (_memory)));
+    _html.append ("</table>");
+
+    _html.append ("<h4>" + tr ("Line lengths") + "</h4>");
+    _html.append (histogram (_report));
+
+    _html.append ("<h4>" + tr ("Most frequent words") + "</h4>");
+    _html.append (topWords (_report));
+
+    if (!m_analyzer->isComplete())
+        _html.append ("<p><i>" + tr ("Analyzed %1% of the document...").arg (_progress) + "</i></p>");
+
+    //
+    // Keep the scroll position while the report is updated
+    //
+    int _scroll = ui_report->verticalScrollBar()->value();
+    ui_report->setHtml (_html);
+    ui_report->verticalScrollBar()->setValue (_scroll);
+}
+
+/*!
+ * \internal
+ * Returns the given number of \a {bytes} in bytes, KB, MB or GB
+ */
+
+QString DocumentInfoDialog::formatSize (qint64 bytes) const {
+    double _size = bytes;
+    QStringList _units;
+    _units << tr ("bytes") << tr ("KB") << tr ("MB") << tr ("GB");
+
+    int _unit = 0;
+    while (_size >= 1024 && _unit < _units.count() - 1) {
+        _size /= 1024;
+        ++_unit;
+    }
+
+    return QString::number (_size, 'f', _unit == 0 ? 0 : 2) + " " + _units.at (_unit);
+}
+
+/*!
+ * \internal
+ * Returns the kinds of line endings used by the document
+ */
+
+QString DocumentInfoDialog::lineEndings (const DocumentReport &report) const {
+    QLocale _locale;
+    QStringList _endings;
+
+    if (report.lf > 0)
+        _endings.append (tr ("LF: %1").arg (_locale.toString (report.lf)));
+
+    if (report.crlf > 0)
+        _endings.append (tr ("CRLF: %1").arg (_locale.toString (report.crlf)));
+
+    if (report.cr > 0)
+        _endings.append (tr ("CR: %1").arg (_locale.toString (report.cr)));
+
+    if (_endings.isEmpty())
+        return tr ("None");
+
+    if (_endings.count() > 1)
+        return tr ("Mixed") + " (" + _endings.join (", ") + ")";
+
+    return _endings.first();
+}
+
+/*!
+ * \internal
+ * Returns the indentation style of the document. The width of the
+ * space indentation is the most frequent increase of the indentation.
+ */
+
+QString DocumentInfoDialog::indentation (const DocumentReport &report) const {
+    qint64 _total = report.tab_indented + report.space_indented + report.mixed_indented;
+
+    if (_total == 0)
+        return tr ("None");
+
+    QString _style;
+    if (report.tab_indented >= report.space_indented)
+        _style = tr ("Tabs");
+
+    else {
+        int _width = 0;
+        for (int i = 1; i < REPORT_INDENT_WIDTHS; ++i) {
+            if (report.indent_widths [i] > report.indent_widths [_width])
+                _width = i;
+        }
+
+        _style = _width > 0 ? tr ("%1 spaces").arg (_width) : tr ("Spaces");
+    }
+
+    //
+    // Tell the user when more than 10% of the lines use another style
+    //
+    qint64 _minority = report.mixed_indented + qMin (report.tab_indented,
+                                                     report.space_indented);
+    if (_minority * 10 > _total)
+        _style.append (" (" + tr ("mixed") + ")");
+
+    return _style;
+}
+
+/*!
+ * \internal
+ * Returns a HTML table with the line length histogram
+ */
+
+QString DocumentInfoDialog::histogram (const DocumentReport &report) const {
+    QLocale _locale;
+
+    qint64 _max = 1;
+    for (int i = 0; i < REPORT_HISTOGRAM_BUCKETS; ++i)
+        _max = qMax (_max, report.histogram [i]);
+
+    QString _html = "<table cellspacing=\"2\">";
+    for (int i = 0; i < REPORT_HISTOGRAM_BUCKETS; ++i) {
+        QString _label;
+        qint64 _limit = DocumentAnalyzer::histogramLimit (i);
+
+        if (i == 0)
+            _label = tr ("Empty");
+        else if (_limit < 0)
+            _label = QString ("> %1").arg (DocumentAnalyzer::histogramLimit (i - 1));
+        else
+            _label = QString ("%1 - %2").arg (DocumentAnalyzer::histogramLimit (i - 1) + 1)
+                     .arg (_limit);
+
+        int _width = (int) ((report.histogram [i] * HISTOGRAM_BAR_WIDTH) / _max);
+        _html.append (QString ("<tr><td>%1</td><td align=\"right\">%2</td>"
+                               "<td><tt>%3</tt></td></tr>")
+                      .arg (_label)
+                      .arg (_locale.toString (report.histogram [i]))
+                      .arg (QString (_width, QChar (0x2588))));
+    }
+
+    return _html + "</table>";
+}
+
+/*!
+ * \internal
+ * Returns a HTML table with the most frequent words of the document
+ */
+
+QString DocumentInfoDialog::topWords (const DocumentReport &report) const {
+    QLocale _locale;
+
+    if (report.top_words.isEmpty())
+        return "<p>" + tr ("None") + "</p>";
+
+    QString _html = "<table cellspacing=\"2\">";
+    for (int i = 0; i < report.top_words.count(); ++i) {
+        _html.append (QString ("<tr><td>%1.</td><td>%2</td><td align=\"right\">%3</td></tr>")
+                      .arg (i + 1)
+                      .arg (QString::fromUtf8 (report.top_words.at (i).first).toHtmlEscaped())
+                      .arg (_locale.toString (report.top_words.at (i).second)));
+    }
+
+    return _html + "</table>";
+}
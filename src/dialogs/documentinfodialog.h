@@ -0,0 +1,70 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef DOCUMENT_INFO_DIALOG_H
+#define DOCUMENT_INFO_DIALOG_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+class QLabel;
+class QPushButton;
+class QVBoxLayout;
+class QTextBrowser;
+class QProgressBar;
+class DocumentAnalyzer;
+struct DocumentReport;
+
+#include <QDialog>
+
+class DocumentInfoDialog : public QDialog {
+        Q_OBJECT
+
+    public:
+        DocumentInfoDialog (DocumentAnalyzer *analyzer,
+                            const QString &title,
+                            QWidget *parent = 0);
+
+    private slots:
+        void updateReport (void);
+
+    private:
+        QString formatSize (qint64 bytes) const;
+        QString lineEndings (const DocumentReport &report) const;
+        QString indentation (const DocumentReport &report) const;
+        QString histogram (const DocumentReport &report) const;
+        QString topWords (const DocumentReport &report) const;
+
+        DocumentAnalyzer *m_analyzer;
+
+        QVBoxLayout *ui_layout;
+        QLabel *ui_title_label;
+        QTextBrowser *ui_report;
+        QPushButton *ui_close_button;
+        QProgressBar *ui_progress_bar;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
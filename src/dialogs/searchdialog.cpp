@@ -28,6 +28,8 @@
 
 #include "editor.h"
 #include "window.h"
+#include "hex_viewer.h"
+#include "file_viewer.h"
 #include "searchdialog.h"
 
 /*!
@@ -157,7 +159,20 @@ bool SearchDialog::search (void) {
  */
 
 void SearchDialog::findNext (void) {
-    m_text_edit->findNext();
+    //
+    // Search the whole file, not only the part loaded in the editor
+    //
+    if (m_text_edit->viewer() != NULL)
+        m_text_edit->viewer()->findNext (ui_find_lineedit->text().toUtf8());
+
+    //
+    // Search bytes (or text) in binary files
+    //
+    else if (m_text_edit->hexViewer() != NULL)
+        m_text_edit->hexViewer()->findNext (HexViewer::parsePattern (ui_find_lineedit->text()));
+
+    else
+        m_text_edit->findNext();
 }
 
 /*!
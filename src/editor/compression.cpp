@@ -0,0 +1,634 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <limits.h>
+#include <string.h>
+
+#include <QFile>
+#include <QObject>
+
+#if HAVE_QT_ZLIB
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+
+#if HAVE_BZIP2
+#include <bzlib.h>
+#endif
+
+#if HAVE_XZ
+#include <lzma.h>
+#endif
+
+#if HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "compression.h"
+
+#define HEADER_SIZE 16
+#define BUFFER_SIZE 1048576
+
+/*!
+ * \class CompressionFormat
+ * \brief Describes a compression format that can be read and written
+ *
+ * Compressed files are recognised by the magic bytes at the start of the
+ * file, the \c FileLoader decompresses them while the document is loaded
+ * and the \c FileWriter compresses the document again when it is saved.
+ *
+ * Each format creates \c StreamCodec objects, which compress or decompress
+ * a stream of data in chunks (like the zlib API), so that a file never has
+ * to be decompressed to the disk or completely into memory.
+ *
+ * The gzip format (based on zlib) is always available. The bzip2, xz and
+ * Zstandard formats are enabled with the \c bzip2, \c xz and \c zstd
+ * qmake configuration flags. Other formats can be added at runtime with
+ * registerFormat().
+ */
+
+//
+// Size limit of the buffers given to the C libraries, which use 32-bit lengths
+//
+static inline unsigned int clampLength (qint64 length) {
+    return (unsigned int) qMin (length, (qint64) UINT_MAX);
+}
+
+//
+// gzip (zlib)
+//
+
+class GzipCodec : public StreamCodec {
+    public:
+        GzipCodec (bool compress) : m_ended (false), m_compress (compress) {
+            memset (&m_stream, 0, sizeof (m_stream));
+
+            if (m_compress)
+                m_result = deflateInit2 (&m_stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                         MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY);
+            else
+                m_result = inflateInit2 (&m_stream, MAX_WBITS + 16);
+        }
+
+        ~GzipCodec (void) {
+            if (m_compress)
+                deflateEnd (&m_stream);
+            else
+                inflateEnd (&m_stream);
+        }
+
+        Status process (const char **input, qint64 *input_length,
+                        char **output, qint64 *output_length, bool finish) {
+            if (m_result != Z_OK && m_result != Z_BUF_ERROR && m_result != Z_STREAM_END)
+                return Error;
+
+            //
+            // Rotated logs are often concatenated gzip files,
+            // so we continue with the next member of the file
+            //
+            if (m_ended) {
+                if (*input_length == 0)
+                    return finish ? StreamEnd : Ok;
+
+                m_ended = false;
+                m_result = inflateReset (&m_stream);
+
+                if (m_result != Z_OK)
+                    return Error;
+            }
+
+            m_stream.next_in = (Bytef *) *input;
+            m_stream.avail_in = clampLength (*input_length);
+            m_stream.next_out = (Bytef *) *output;
+            m_stream.avail_out = clampLength (*output_length);
+
+            uInt _avail_in = m_stream.avail_in;
+            uInt _avail_out = m_stream.avail_out;
+
+            if (m_compress)
+                m_result = deflate (&m_stream, finish ? Z_FINISH : Z_NO_FLUSH);
+            else
+                m_result = inflate (&m_stream, Z_NO_FLUSH);
+
+            *input += _avail_in - m_stream.avail_in;
+            *input_length -= _avail_in - m_stream.avail_in;
+            *output += _avail_out - m_stream.avail_out;
+            *output_length -= _avail_out - m_stream.avail_out;
+
+            if (m_result == Z_STREAM_END && !m_compress) {
+                m_ended = true;
+                return (finish && *input_length == 0) ? StreamEnd : Ok;
+            }
+
+            if (m_result == Z_STREAM_END)
+                return StreamEnd;
+
+            return (m_result == Z_OK || m_result == Z_BUF_ERROR) ? Ok : Error;
+        }
+
+        QString errorString (void) const {
+            if (m_stream.msg != NULL)
+                return QString::fromLatin1 (m_stream.msg);
+
+            return QObject::tr ("Invalid gzip data");
+        }
+
+    private:
+        int m_result;
+        bool m_ended;
+        bool m_compress;
+        z_stream m_stream;
+};
+
+class GzipFormat : public CompressionFormat {
+    public:
+        QString name (void) const {
+            return "gzip";
+        }
+
+        QString suffix (void) const {
+            return "gz";
+        }
+
+        bool matches (const QByteArray &header) const {
+            return header.startsWith ("\x1F\x8B");
+        }
+
+        StreamCodec *createDecoder (void) const {
+            return new GzipCodec (false);
+        }
+
+        StreamCodec *createEncoder (void) const {
+            return new GzipCodec (true);
+        }
+};
+
+//
+// bzip2
+//
+
+#if HAVE_BZIP2
+class Bzip2Codec : public StreamCodec {
+    public:
+        Bzip2Codec (bool compress) : m_ended (false), m_compress (compress) {
+            memset (&m_stream, 0, sizeof (m_stream));
+
+            if (m_compress)
+                m_result = BZ2_bzCompressInit (&m_stream, 9, 0, 0);
+            else
+                m_result = BZ2_bzDecompressInit (&m_stream, 0, 0);
+        }
+
+        ~Bzip2Codec (void) {
+            if (m_compress)
+                BZ2_bzCompressEnd (&m_stream);
+            else
+                BZ2_bzDecompressEnd (&m_stream);
+        }
+
+        Status process (const char **input, qint64 *input_length,
+                        char **output, qint64 *output_length, bool finish) {
+            if (m_result < 0)
+                return Error;
+
+            //
+            // Continue with the next stream of the file (pbzip2
+            // and other tools write multiple streams)
+            //
+            if (m_ended) {
+                if (*input_length == 0)
+                    return finish ? StreamEnd : Ok;
+
+                BZ2_bzDecompressEnd (&m_stream);
+                memset (&m_stream, 0, sizeof (m_stream));
+
+                m_ended = false;
+                m_result = BZ2_bzDecompressInit (&m_stream, 0, 0);
+
+                if (m_result != BZ_OK)
+                    return Error;
+            }
+
+            m_stream.next_in = (char *) *input;
+            m_stream.avail_in = clampLength (*input_length);
+            m_stream.next_out = *output;
+            m_stream.avail_out = clampLength (*output_length);
+
+            unsigned int _avail_in = m_stream.avail_in;
+            unsigned int _avail_out = m_stream.avail_out;
+
+            if (m_compress)
+                m_result = BZ2_bzCompress (&m_stream, finish ? BZ_FINISH : BZ_RUN);
+            else
+                m_result = BZ2_bzDecompress (&m_stream);
+
+            *input += _avail_in - m_stream.avail_in;
+            *input_length -= _avail_in - m_stream.avail_in;
+            *output += _avail_out - m_stream.avail_out;
+            *output_length -= _avail_out - m_stream.avail_out;
+
+            if (m_result == BZ_STREAM_END && !m_compress) {
+                m_ended = true;
+                return (finish && *input_length == 0) ? StreamEnd : Ok;
+            }
+
+            if (m_result == BZ_STREAM_END)
+                return StreamEnd;
+
+            return m_result >= 0 ? Ok : Error;
+        }
+
+        QString errorString (void) const {
+            return QObject::tr ("Invalid bzip2 data (error %1)").arg (m_result);
+        }
+
+    private:
+        int m_result;
+        bool m_ended;
+        bool m_compress;
+        bz_stream m_stream;
+};
+
+class Bzip2Format : public CompressionFormat {
+    public:
+        QString name (void) const {
+            return "bzip2";
+        }
+
+        QString suffix (void) const {
+            return "bz2";
+        }
+
+        //
+        // "BZh", the block size ('1' to '9') and the magic of the first
+        // block (or of the end of the stream, for empty files)
+        //
+        bool matches (const QByteArray &header) const {
+            if (header.size() < 10 || !header.startsWith ("BZh") ||
+                header.at (3) < '1' || header.at (3) > '9')
+                return false;
+
+            QByteArray _magic = header.mid (4, 6);
+            return _magic == "1AY&SY" || _magic == "\x17\x72\x45\x38\x50\x90";
+        }
+
+        StreamCodec *createDecoder (void) const {
+            return new Bzip2Codec (false);
+        }
+
+        StreamCodec *createEncoder (void) const {
+            return new Bzip2Codec (true);
+        }
+};
+#endif
+
+//
+// xz (liblzma)
+//
+
+#if HAVE_XZ
+class XzCodec : public StreamCodec {
+    public:
+        XzCodec (bool compress) {
+            lzma_stream _stream = LZMA_STREAM_INIT;
+            m_stream = _stream;
+
+            if (compress)
+                m_result = lzma_easy_encoder (&m_stream, 6, LZMA_CHECK_CRC64);
+            else
+                m_result = lzma_stream_decoder (&m_stream, UINT64_MAX, LZMA_CONCATENATED);
+        }
+
+        ~XzCodec (void) {
+            lzma_end (&m_stream);
+        }
+
+        Status process (const char **input, qint64 *input_length,
+                        char **output, qint64 *output_length, bool finish) {
+            if (m_result != LZMA_OK && m_result != LZMA_BUF_ERROR)
+                return Error;
+
+            m_stream.next_in = (const uint8_t *) *input;
+            m_stream.avail_in = (size_t) *input_length;
+            m_stream.next_out = (uint8_t *) *output;
+            m_stream.avail_out = (size_t) *output_length;
+
+            size_t _avail_in = m_stream.avail_in;
+            size_t _avail_out = m_stream.avail_out;
+
+            m_result = lzma_code (&m_stream, finish ? LZMA_FINISH : LZMA_RUN);
+
+            *input += _avail_in - m_stream.avail_in;
+            *input_length -= _avail_in - m_stream.avail_in;
+            *output += _avail_out - m_stream.avail_out;
+            *output_length -= _avail_out - m_stream.avail_out;
+
+            if (m_result == LZMA_STREAM_END)
+                return StreamEnd;
+
+            return (m_result == LZMA_OK || m_result == LZMA_BUF_ERROR) ? Ok : Error;
+        }
+
+        QString errorString (void) const {
+            return QObject::tr ("Invalid xz data (error %1)").arg ((int) m_result);
+        }
+
+    private:
+        lzma_ret m_result;
+        lzma_stream m_stream;
+};
+
+class XzFormat : public CompressionFormat {
+    public:
+        QString name (void) const {
+            return "xz";
+        }
+
+        QString suffix (void) const {
+            return "xz";
+        }
+
+        bool matches (const QByteArray &header) const {
+            return header.startsWith (QByteArray ("\xFD" "7zXZ\x00", 6));
+        }
+
+        StreamCodec *createDecoder (void) const {
+            return new XzCodec (false);
+        }
+
+        StreamCodec *createEncoder (void) const {
+            return new XzCodec (true);
+        }
+};
+#endif
+
+//
+// Zstandard
+//
+
+#if HAVE_ZSTD
+class ZstdCodec : public StreamCodec {
+    public:
+        ZstdCodec (bool compress) : m_result (0), m_ended (true), m_compress (compress) {
+            m_cstream = m_compress ? ZSTD_createCCtx() : NULL;
+            m_dstream = m_compress ? NULL : ZSTD_createDCtx();
+        }
+
+        ~ZstdCodec (void) {
+            ZSTD_freeCCtx (m_cstream);
+            ZSTD_freeDCtx (m_dstream);
+        }
+
+        Status process (const char **input, qint64 *input_length,
+                        char **output, qint64 *output_length, bool finish) {
+            if (ZSTD_isError (m_result))
+                return Error;
+
+            ZSTD_inBuffer _in = { *input, (size_t) *input_length, 0 };
+            ZSTD_outBuffer _out = { *output, (size_t) *output_length, 0 };
+
+            if (m_compress)
+                m_result = ZSTD_compressStream2 (m_cstream, &_out, &_in,
+                                                 finish ? ZSTD_e_end : ZSTD_e_continue);
+            else
+                m_result = ZSTD_decompressStream (m_dstream, &_out, &_in);
+
+            *input += _in.pos;
+            *input_length -= _in.pos;
+            *output += _out.pos;
+            *output_length -= _out.pos;
+
+            if (ZSTD_isError (m_result))
+                return Error;
+
+            //
+            // The encoder has flushed everything when it returns 0, the
+            // decoder returns 0 after each frame and the file may contain
+            // more frames
+            //
+            if (m_compress)
+                return (finish && m_result == 0) ? StreamEnd : Ok;
+
+            if (_in.pos > 0 || _out.pos > 0)
+                m_ended = m_result == 0;
+
+            return (finish && m_ended && *input_length == 0) ? StreamEnd : Ok;
+        }
+
+        QString errorString (void) const {
+            return QString::fromLatin1 (ZSTD_getErrorName (m_result));
+        }
+
+    private:
+        size_t m_result;
+        bool m_ended;
+        bool m_compress;
+        ZSTD_CCtx *m_cstream;
+        ZSTD_DCtx *m_dstream;
+};
+
+class ZstdFormat : public CompressionFormat {
+    public:
+        QString name (void) const {
+            return "zstd";
+        }
+
+        QString suffix (void) const {
+            return "zst";
+        }
+
+        bool matches (const QByteArray &header) const {
+            return header.startsWith ("\x28\xB5\x2F\xFD");
+        }
+
+        StreamCodec *createDecoder (void) const {
+            return new ZstdCodec (false);
+        }
+
+        StreamCodec *createEncoder (void) const {
+            return new ZstdCodec (true);
+        }
+};
+#endif
+
+//
+// Registry
+//
+
+/*!
+ * \internal
+ * Returns the list of registered formats, the built-in formats are
+ * registered the first time that the list is used
+ */
+
+static QList<CompressionFormat *> &registeredFormats (void) {
+    static QList<CompressionFormat *> _formats;
+
+    if (_formats.isEmpty()) {
+        _formats.append (new GzipFormat());
+#if HAVE_BZIP2
+        _formats.append (new Bzip2Format());
+#endif
+#if HAVE_XZ
+        _formats.append (new XzFormat());
+#endif
+#if HAVE_ZSTD
+        _formats.append (new ZstdFormat());
+#endif
+    }
+
+    return _formats;
+}
+
+/*!
+ * Adds the given \a {format} to the list of supported formats, the
+ * registry takes ownership of the format. This function must be called
+ * from the GUI thread before any file is loaded.
+ */
+
+void CompressionFormat::registerFormat (CompressionFormat *format) {
+    Q_ASSERT (format != NULL);
+    registeredFormats().append (format);
+}
+
+/*!
+ * Returns the list of supported formats
+ */
+
+QList<CompressionFormat *> CompressionFormat::formats (void) {
+    return registeredFormats();
+}
+
+/*!
+ * Returns the format with the given \a {name}, or \c NULL if the format
+ * is not supported
+ */
+
+CompressionFormat *CompressionFormat::find (const QString &name) {
+    if (name.isEmpty())
+        return NULL;
+
+    foreach (CompressionFormat *_format, registeredFormats()) {
+        if (_format->name() == name)
+            return _format;
+    }
+
+    return NULL;
+}
+
+/*!
+ * Returns the format used by the files with the suffix of the given
+ * \a {file} name (e.g. \c {gzip} for \c {notes.txt.gz}), or \c NULL if
+ * the suffix is not known
+ */
+
+CompressionFormat *CompressionFormat::findBySuffix (const QString &file) {
+    foreach (CompressionFormat *_format, registeredFormats()) {
+        if (file.endsWith ("." + _format->suffix(), Qt::CaseInsensitive))
+            return _format;
+    }
+
+    return NULL;
+}
+
+/*!
+ * Returns the format that matches the given \a {header} (the first bytes
+ * of a file, or the whole file), or \c NULL if the data is not compressed
+ */
+
+CompressionFormat *CompressionFormat::detect (const QByteArray &header) {
+    foreach (CompressionFormat *_format, registeredFormats()) {
+        if (_format->matches (header))
+            return _format;
+    }
+
+    return NULL;
+}
+
+/*!
+ * Peeks the first bytes of the given (open) \a {device} and returns its
+ * compression format, or \c NULL if the data is not compressed. The
+ * position of the device is not changed.
+ */
+
+CompressionFormat *CompressionFormat::detect (QIODevice *device) {
+    Q_ASSERT (device != NULL);
+    return detect (device->peek (HEADER_SIZE));
+}
+
+/*!
+ * Reads the first bytes of the given \a {file} and returns its compression
+ * format, or \c NULL if the file is not compressed
+ */
+
+CompressionFormat *CompressionFormat::detectFile (const QString &file) {
+    QFile _file (file);
+
+    if (!_file.open (QIODevice::ReadOnly))
+        return NULL;
+
+    return detect (&_file);
+}
+
+/*!
+ * Decompresses the given \a {data} at once and writes the result in
+ * \a {output}, returns \c {false} (and sets the \a {error} string) if the
+ * data is not valid.
+ */
+
+bool CompressionFormat::decompress (CompressionFormat *format,
+                                    const QByteArray &data,
+                                    QByteArray *output,
+                                    QString *error) {
+    Q_ASSERT (format != NULL);
+    Q_ASSERT (output != NULL);
+
+    StreamCodec *_codec = format->createDecoder();
+    QByteArray _buffer (BUFFER_SIZE, 0);
+
+    const char *_input = data.constData();
+    qint64 _input_length = data.size();
+    StreamCodec::Status _status = StreamCodec::Ok;
+
+    output->clear();
+
+    while (_status == StreamCodec::Ok) {
+        char *_output = _buffer.data();
+        qint64 _output_length = _buffer.size();
+
+        _status = _codec->process (&_input, &_input_length, &_output, &_output_length, true);
+        output->append (_buffer.constData(), _buffer.size() - (int) _output_length);
+
+        //
+        // No progress is possible, the data is truncated
+        //
+        if (_status == StreamCodec::Ok && _input_length == 0 && _output_length > 0)
+            break;
+    }
+
+    if (_status != StreamCodec::StreamEnd && error != NULL)
+        *error = _status == StreamCodec::Error ? _codec->errorString() :
+                 QObject::tr ("Unexpected end of compressed data");
+
+    delete _codec;
+    return _status == StreamCodec::StreamEnd;
+}
@@ -0,0 +1,81 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QList>
+#include <QString>
+#include <QByteArray>
+
+class QIODevice;
+
+class StreamCodec {
+    public:
+        enum Status {
+            Ok,
+            StreamEnd,
+            Error
+        };
+
+        virtual ~StreamCodec (void) {}
+
+        virtual Status process (const char **input,
+                                qint64 *input_length,
+                                char **output,
+                                qint64 *output_length,
+                                bool finish) = 0;
+
+        virtual QString errorString (void) const = 0;
+};
+
+class CompressionFormat {
+    public:
+        virtual ~CompressionFormat (void) {}
+
+        virtual QString name (void) const = 0;
+        virtual QString suffix (void) const = 0;
+        virtual bool matches (const QByteArray &header) const = 0;
+        virtual StreamCodec *createDecoder (void) const = 0;
+        virtual StreamCodec *createEncoder (void) const = 0;
+
+        static void registerFormat (CompressionFormat *format);
+        static QList<CompressionFormat *> formats (void);
+        static CompressionFormat *find (const QString &name);
+        static CompressionFormat *findBySuffix (const QString &file);
+        static CompressionFormat *detect (const QByteArray &header);
+        static CompressionFormat *detect (QIODevice *device);
+        static CompressionFormat *detectFile (const QString &file);
+        static bool decompress (CompressionFormat *format,
+                                const QByteArray &data,
+                                QByteArray *output,
+                                QString *error = 0);
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
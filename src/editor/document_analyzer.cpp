@@ -0,0 +1,687 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <limits.h>
+#include <string.h>
+
+#include <QFile>
+#include <QRunnable>
+#include <QMutexLocker>
+
+#include "utf8_validator.h"
+#include "document_stats.h"
+#include "document_analyzer.h"
+
+#define TOP_WORDS 20
+#define MAX_WORD_LENGTH 48
+#define PUBLISH_INTERVAL 100
+#define MAX_COPY_SIZE ((qint64) INT_MAX - 1024)
+#define CHUNK_SIZE (4 * 1024 * 1024)
+
+/*!
+ * \internal
+ * Upper limits (in characters) of the line length histogram buckets, the
+ * last bucket contains all the longer lines
+ */
+
+static const qint64 HISTOGRAM_LIMITS [REPORT_HISTOGRAM_BUCKETS] = {
+    0, 20, 40, 60, 80, 100, 120, 160, 200, 500, -1
+};
+
+/*!
+ * \struct DocumentReport
+ * \brief The statistics of a document, or of a chunk of a document
+ *
+ * The line numbers and the line ends are counted from the beginning of the
+ * chunk. The word frequencies are only used while the chunks are merged,
+ * the reports published by the \c DocumentAnalyzer only have the most
+ * frequent words.
+ */
+
+/*!
+ * Initializes an empty report
+ */
+
+DocumentReport::DocumentReport (void) :
+    bytes (0),
+    words (0),
+    characters (0),
+    cr (0),
+    lf (0),
+    crlf (0),
+    line_ends (0),
+    longest_line (0),
+    longest_length (0),
+    tab_indented (0),
+    space_indented (0),
+    mixed_indented (0),
+    ascii (true),
+    valid_utf8 (true) {
+    memset (histogram, 0, sizeof (histogram));
+    memset (indent_widths, 0, sizeof (indent_widths));
+}
+
+/*!
+ * \internal
+ * Returns \c true if the given byte is part of a word, the bytes of the
+ * multi-byte UTF-8 characters are considered letters
+ */
+
+static inline bool isWordByte (uchar byte) {
+    return (byte >= 'a' && byte <= 'z') || (byte >= 'A' && byte <= 'Z') ||
+           (byte >= '0' && byte <= '9') || byte == '_' || byte >= 0x80;
+}
+
+/*!
+ * \internal
+ * Adds the given word to the frequency table of the \a {report}. Numbers
+ * and very long words (such as base64 data) are ignored.
+ */
+
+static void addWord (DocumentReport *report, const uchar *word, int length) {
+    if (length > MAX_WORD_LENGTH)
+        return;
+
+    char _word [MAX_WORD_LENGTH];
+    bool _number = true;
+
+    for (int i = 0; i < length; ++i) {
+        uchar _byte = word[i];
+
+        if (_byte >= 'A' && _byte <= 'Z')
+            _byte += 'a' - 'A';
+
+        if (_byte < '0' || _byte > '9')
+            _number = false;
+
+        _word[i] = (char) _byte;
+    }
+
+    if (_number)
+        return;
+
+    //
+    // Only copy the word when it is not in the table yet
+    //
+    QHash<QByteArray, qint64>::iterator _it = report->word_frequencies.find
+            (QByteArray::fromRawData (_word, length));
+
+    if (_it != report->word_frequencies.end())
+        ++_it.value();
+
+    else
+        report->word_frequencies.insert (QByteArray (_word, length), 1);
+}
+
+/*!
+ * \internal
+ * Returns the \a {count} most frequent words of the given table, sorted by
+ * frequency and then alphabetically
+ */
+
+static QList<QPair<QByteArray, qint64> > topWords (const QHash<QByteArray, qint64>
+        &frequencies, int count) {
+    QList<QPair<QByteArray, qint64> > _top;
+
+    QHash<QByteArray, qint64>::const_iterator _it;
+    for (_it = frequencies.constBegin(); _it != frequencies.constEnd(); ++_it) {
+        if (_top.count() == count) {
+            const QPair<QByteArray, qint64> &_last = _top.last();
+
+            if (_it.value() < _last.second ||
+                    (_it.value() == _last.second && _it.key() > _last.first))
+                continue;
+        }
+
+        int i = _top.count();
+        while (i > 0 && (_top.at (i - 1).second < _it.value() ||
+                         (_top.at (i - 1).second == _it.value() &&
+                          _top.at (i - 1).first > _it.key())))
+            --i;
+
+        _top.insert (i, qMakePair (_it.key(), _it.value()));
+
+        if (_top.count() > count)
+            _top.removeLast();
+    }
+
+    return _top;
+}
+
+/*!
+ * \class DocumentChunkTask
+ * \brief Analyzes the chunks of a document in a thread of the pool
+ *
+ * Each task takes the next chunk that has not been analyzed yet until all
+ * the chunks are done, so the chunks are analyzed roughly in order.
+ */
+
+class DocumentChunkTask : public QRunnable {
+    public:
+        explicit DocumentChunkTask (DocumentAnalyzer *analyzer) :
+            m_analyzer (analyzer) {
+        }
+
+        void run (void) {
+            while (m_analyzer->analyzeNextChunk());
+        }
+
+    private:
+        DocumentAnalyzer *m_analyzer;
+};
+
+/*!
+ * \class DocumentAnalyzer
+ * \brief Computes the statistics of a document in the background
+ *
+ * The \c DocumentAnalyzer works on a snapshot of the document, which is
+ * either a copy of the text or the file mapped in memory, so the editor
+ * can be used while the document is analyzed.
+ *
+ * The snapshot is divided in chunks of about \c CHUNK_SIZE bytes, which
+ * always end after a line feed, so the lines (and the words and the
+ * characters) are never split between two chunks. The chunks are
+ * analyzed by a pool of threads, and the analyzer thread merges their
+ * reports in order. Every \c PUBLISH_INTERVAL milliseconds, the merged
+ * report is published and the \c progressChanged() signal is emitted,
+ * so the report can be displayed before the whole document is analyzed.
+ */
+
+/*!
+ * Initializes the analyzer, call \c setData() or \c setFile() and then
+ * \c start() to analyze a document
+ */
+
+DocumentAnalyzer::DocumentAnalyzer (QObject *parent) : QThread (parent),
+    m_data (""),
+    m_length (0),
+    m_file (NULL),
+    m_cancelled (0),
+    m_next_chunk (0),
+    m_merged (0),
+    m_complete (false) {
+    m_pool.setMaxThreadCount (qMax (1, QThread::idealThreadCount()));
+}
+
+/*!
+ * Stops the analysis and releases the snapshot of the document
+ */
+
+DocumentAnalyzer::~DocumentAnalyzer (void) {
+    cancel();
+    wait();
+    m_pool.waitForDone();
+
+    qDeleteAll (m_finished_chunks);
+
+    if (m_file != NULL) {
+        m_file->close();
+        delete m_file;
+    }
+}
+
+/*!
+ * Analyzes the given \a {data}, which is usually a copy of the text of
+ * the editor
+ */
+
+void DocumentAnalyzer::setData (const QByteArray &data) {
+    m_buffer = data;
+    m_data = m_buffer.constData();
+    m_length = m_buffer.length();
+}
+
+/*!
+ * Analyzes a copy of the given \a {data}. Returns \c false (and nothing
+ * is analyzed) if the data does not fit in a \c QByteArray.
+ */
+
+bool DocumentAnalyzer::setData (const char *data, qint64 length) {
+    if (length > MAX_COPY_SIZE) {
+        m_error_string = tr ("The document is too large to be analyzed");
+        return false;
+    }
+
+    setData (QByteArray (data, (int) length));
+    return true;
+}
+
+/*!
+ * Analyzes the given \a {file}, which is mapped in memory (or read if it
+ * cannot be mapped). Returns \c false if the file cannot be opened.
+ */
+
+bool DocumentAnalyzer::setFile (const QString &file) {
+    m_file = new QFile (file);
+
+    if (!m_file->open (QIODevice::ReadOnly)) {
+        m_error_string = m_file->errorString();
+        return false;
+    }
+
+    m_length = m_file->size();
+    if (m_length == 0)
+        return true;
+
+    m_data = reinterpret_cast<const char *> (m_file->map (0, m_length));
+
+    if (m_data == NULL) {
+        setData (m_file->readAll());
+
+        if (m_length != m_file->size()) {
+            m_error_string = m_file->errorString();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*!
+ * Sets the name of the \a {encoding} displayed in the report
+ */
+
+void DocumentAnalyzer::setEncoding (const QString &encoding) {
+    m_encoding = encoding;
+}
+
+/*!
+ * Returns the percentage of the document that is included in the report
+ */
+
+int DocumentAnalyzer::progress (void) const {
+    QMutexLocker _locker (&m_report_mutex);
+
+    if (m_complete)
+        return 100;
+
+    return m_length > 0 ? (int) ((m_merged * 100) / m_length) : 0;
+}
+
+/*!
+ * Returns \c true when the whole document has been analyzed
+ */
+
+bool DocumentAnalyzer::isComplete (void) const {
+    QMutexLocker _locker (&m_report_mutex);
+    return m_complete;
+}
+
+/*!
+ * Returns the name of the encoding of the document
+ */
+
+QString DocumentAnalyzer::encoding (void) const {
+    return m_encoding;
+}
+
+/*!
+ * Returns the error that occurred while reading the file
+ */
+
+QString DocumentAnalyzer::errorString (void) const {
+    return m_error_string;
+}
+
+/*!
+ * Returns the last published report, which may only include the
+ * beginning of the document
+ */
+
+DocumentReport DocumentAnalyzer::report (void) const {
+    QMutexLocker _locker (&m_report_mutex);
+    return m_report;
+}
+
+/*!
+ * Returns the histogram bucket of a line of the given \a {length}
+ */
+
+int DocumentAnalyzer::histogramBucket (qint64 length) {
+    for (int i = 0; i < REPORT_HISTOGRAM_BUCKETS - 1; ++i) {
+        if (length <= HISTOGRAM_LIMITS [i])
+            return i;
+    }
+
+    return REPORT_HISTOGRAM_BUCKETS - 1;
+}
+
+/*!
+ * Returns the maximum length of the lines of the given \a {bucket}, or -1
+ * for the last bucket
+ */
+
+qint64 DocumentAnalyzer::histogramLimit (int bucket) {
+    Q_ASSERT (bucket >= 0 && bucket < REPORT_HISTOGRAM_BUCKETS);
+    return HISTOGRAM_LIMITS [bucket];
+}
+
+/*!
+ * Analyzes a chunk of \a {length} bytes of \a {data} and writes the
+ * statistics into the given \a {report}. The chunk must not split a
+ * line, unless it is the end of the document.
+ */
+
+void DocumentAnalyzer::analyze (const char *data, qint64 length, DocumentReport *report) {
+    qint64 _line_ends = 0;
+    DocumentStats::count (data, length, &report->words, &report->characters, &_line_ends);
+
+    report->bytes = length;
+    report->ascii = Utf8Validator::isAscii (data, length);
+    report->valid_utf8 = report->ascii || Utf8Validator::validate (data, length);
+
+    const uchar *_data = reinterpret_cast<const uchar *> (data);
+
+    qint64 i = 0;
+    qint64 _line = 0;
+    qint64 _previous_indent = -1;
+
+    while (i < length) {
+        qint64 _start = i;
+
+        //
+        // Measure the indentation of the line
+        //
+        qint64 _tabs = 0;
+        qint64 _spaces = 0;
+        while (i < length && (_data[i] == ' ' || _data[i] == '\t')) {
+            if (_data[i] == ' ')
+                ++_spaces;
+            else
+                ++_tabs;
+
+            ++i;
+        }
+
+        bool _blank = true;
+        qint64 _word = -1;
+        qint64 _continuations = 0;
+
+        //
+        // Collect the words of the line
+        //
+        while (i < length && _data[i] != '\n' && _data[i] != '\r') {
+            uchar _byte = _data[i];
+
+            if ((_byte & 0xC0) == 0x80)
+                ++_continuations;
+
+            if (_byte != ' ' && _byte != '\t')
+                _blank = false;
+
+            if (isWordByte (_byte)) {
+                if (_word < 0)
+                    _word = i;
+            }
+
+            else if (_word >= 0) {
+                addWord (report, _data + _word, (int) (i - _word));
+                _word = -1;
+            }
+
+            ++i;
+        }
+
+        if (_word >= 0)
+            addWord (report, _data + _word, (int) (i - _word));
+
+        qint64 _length = i - _start - _continuations;
+
+        //
+        // Count the line end
+        //
+        if (i < length) {
+            if (_data[i] == '\r' && i + 1 < length && _data[i + 1] == '\n') {
+                ++report->crlf;
+                i += 2;
+            }
+
+            else if (_data[i] == '\r') {
+                ++report->cr;
+                ++i;
+            }
+
+            else {
+                ++report->lf;
+                ++i;
+            }
+        }
+
+        //
+        // Update the line length statistics
+        //
+        ++report->histogram [histogramBucket (_length)];
+
+        if (_length > report->longest_length) {
+            report->longest_length = _length;
+            report->longest_line = _line;
+        }
+
+        ++_line;
+
+        //
+        // Update the indentation statistics, the width of the indentation
+        // is the increase of the indentation between two space-indented lines
+        //
+        if (_blank)
+            continue;
+
+        if (_tabs > 0 && _spaces > 0)
+            ++report->mixed_indented;
+
+        else if (_tabs > 0)
+            ++report->tab_indented;
+
+        else if (_spaces > 0)
+            ++report->space_indented;
+
+        qint64 _indent = _tabs > 0 ? -1 : _spaces;
+        if (_indent > _previous_indent && _previous_indent >= 0 &&
+                _indent - _previous_indent < REPORT_INDENT_WIDTHS)
+            ++report->indent_widths [_indent - _previous_indent];
+
+        _previous_indent = _indent;
+    }
+
+    report->line_ends = report->cr + report->lf + report->crlf;
+}
+
+/*!
+ * Adds the report of the next \a {chunk} of the document to the given
+ * \a {report}
+ */
+
+void DocumentAnalyzer::merge (DocumentReport *report, const DocumentReport &chunk) {
+    report->bytes += chunk.bytes;
+    report->words += chunk.words;
+    report->characters += chunk.characters;
+
+    report->cr += chunk.cr;
+    report->lf += chunk.lf;
+    report->crlf += chunk.crlf;
+
+    if (chunk.longest_length > report->longest_length) {
+        report->longest_length = chunk.longest_length;
+        report->longest_line = report->line_ends + chunk.longest_line;
+    }
+
+    report->line_ends += chunk.line_ends;
+
+    report->tab_indented += chunk.tab_indented;
+    report->space_indented += chunk.space_indented;
+    report->mixed_indented += chunk.mixed_indented;
+
+    report->ascii = report->ascii && chunk.ascii;
+    report->valid_utf8 = report->valid_utf8 && chunk.valid_utf8;
+
+    for (int i = 0; i < REPORT_HISTOGRAM_BUCKETS; ++i)
+        report->histogram [i] += chunk.histogram [i];
+
+    for (int i = 0; i < REPORT_INDENT_WIDTHS; ++i)
+        report->indent_widths [i] += chunk.indent_widths [i];
+
+    if (report->word_frequencies.isEmpty()) {
+        report->word_frequencies = chunk.word_frequencies;
+        return;
+    }
+
+    QHash<QByteArray, qint64>::const_iterator _it;
+    for (_it = chunk.word_frequencies.constBegin();
+            _it != chunk.word_frequencies.constEnd(); ++_it)
+        report->word_frequencies [_it.key()] += _it.value();
+}
+
+/*!
+ * Stops the analysis, the report is not completed
+ */
+
+void DocumentAnalyzer::cancel (void) {
+    QMutexLocker _locker (&m_mutex);
+    m_cancelled.store (1);
+    m_condition.wakeAll();
+}
+
+/*!
+ * \internal
+ * Divides the document in chunks, starts the threads of the pool and
+ * merges the reports of the chunks in order
+ */
+
+void DocumentAnalyzer::run (void) {
+    //
+    // Divide the document in chunks that end after a line feed
+    //
+    m_chunks.clear();
+    m_chunks.append (0);
+
+    qint64 _offset = 0;
+    while (_offset < m_length) {
+        qint64 _end = _offset + CHUNK_SIZE;
+
+        if (_end >= m_length)
+            _end = m_length;
+
+        else {
+            const char *_lf = static_cast<const char *>
+                              (memchr (m_data + _end, '\n', m_length - _end));
+            _end = _lf != NULL ? (_lf - m_data) + 1 : m_length;
+        }
+
+        m_chunks.append (_end);
+        _offset = _end;
+    }
+
+    //
+    // Start the threads of the pool
+    //
+    int _count = m_chunks.count() - 1;
+    int _threads = qMin (_count, m_pool.maxThreadCount());
+
+    m_next_chunk.store (0);
+    for (int i = 0; i < _threads; ++i)
+        m_pool.start (new DocumentChunkTask (this));
+
+    //
+    // Merge the reports of the chunks in order, so the line numbers of the
+    // chunks can be converted to line numbers of the document
+    //
+    DocumentReport _report;
+    QElapsedTimer _timer;
+    _timer.start();
+
+    for (int i = 0; i < _count; ++i) {
+        m_mutex.lock();
+        while (!m_finished_chunks.contains (i) && m_cancelled.load() == 0)
+            m_condition.wait (&m_mutex, PUBLISH_INTERVAL);
+
+        DocumentReport *_chunk = m_finished_chunks.take (i);
+        m_mutex.unlock();
+
+        if (_chunk == NULL)
+            break;
+
+        merge (&_report, *_chunk);
+        delete _chunk;
+
+        if (_timer.elapsed() >= PUBLISH_INTERVAL) {
+            publish (_report, m_chunks.at (i + 1), false);
+            _timer.restart();
+        }
+    }
+
+    m_pool.waitForDone();
+
+    if (m_cancelled.load() != 0)
+        return;
+
+    //
+    // The empty line after the last line end was not counted
+    //
+    if (m_length == 0 || m_data [m_length - 1] == '\n' || m_data [m_length - 1] == '\r')
+        ++_report.histogram [0];
+
+    publish (_report, m_length, true);
+}
+
+/*!
+ * \internal
+ * Analyzes the next chunk in a thread of the pool, returns \c false when
+ * there are no chunks left
+ */
+
+bool DocumentAnalyzer::analyzeNextChunk (void) {
+    if (m_cancelled.load() != 0)
+        return false;
+
+    int _chunk = m_next_chunk.fetchAndAddRelaxed (1);
+    if (_chunk >= m_chunks.count() - 1)
+        return false;
+
+    qint64 _start = m_chunks.at (_chunk);
+    DocumentReport *_report = new DocumentReport;
+    analyze (m_data + _start, m_chunks.at (_chunk + 1) - _start, _report);
+
+    QMutexLocker _locker (&m_mutex);
+    m_finished_chunks.insert (_chunk, _report);
+    m_condition.wakeAll();
+
+    return true;
+}
+
+/*!
+ * \internal
+ * Publishes the given \a {report}, which includes the first \a {merged}
+ * bytes of the document
+ */
+
+void DocumentAnalyzer::publish (const DocumentReport &report, qint64 merged, bool complete) {
+    DocumentReport _report = report;
+    _report.top_words = topWords (report.word_frequencies, TOP_WORDS);
+    _report.word_frequencies.clear();
+
+    m_report_mutex.lock();
+    m_report = _report;
+    m_merged = merged;
+    m_complete = complete;
+    m_report_mutex.unlock();
+
+    emit progressChanged();
+}
@@ -0,0 +1,140 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef DOCUMENT_ANALYZER_H
+#define DOCUMENT_ANALYZER_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+class QFile;
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QVector>
+#include <QThread>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QWaitCondition>
+
+#define REPORT_HISTOGRAM_BUCKETS 11
+#define REPORT_INDENT_WIDTHS 9
+
+struct DocumentReport {
+    DocumentReport (void);
+
+    qint64 bytes;
+    qint64 words;
+    qint64 characters;
+
+    qint64 cr;
+    qint64 lf;
+    qint64 crlf;
+    qint64 line_ends;
+    qint64 longest_line;
+    qint64 longest_length;
+
+    qint64 tab_indented;
+    qint64 space_indented;
+    qint64 mixed_indented;
+
+    bool ascii;
+    bool valid_utf8;
+
+    qint64 histogram [REPORT_HISTOGRAM_BUCKETS];
+    qint64 indent_widths [REPORT_INDENT_WIDTHS];
+
+    QHash<QByteArray, qint64> word_frequencies;
+    QList<QPair<QByteArray, qint64> > top_words;
+};
+
+class DocumentAnalyzer : public QThread {
+        Q_OBJECT
+
+    public:
+        explicit DocumentAnalyzer (QObject *parent = 0);
+        ~DocumentAnalyzer (void);
+
+        void setData (const QByteArray &data);
+        bool setData (const char *data, qint64 length);
+        bool setFile (const QString &file);
+        void setEncoding (const QString &encoding);
+
+        int progress (void) const;
+        bool isComplete (void) const;
+        QString encoding (void) const;
+        QString errorString (void) const;
+        DocumentReport report (void) const;
+
+        static int histogramBucket (qint64 length);
+        static qint64 histogramLimit (int bucket);
+
+        static void analyze (const char *data, qint64 length, DocumentReport *report);
+        static void merge (DocumentReport *report, const DocumentReport &chunk);
+
+    public slots:
+        void cancel (void);
+
+    signals:
+        void progressChanged (void);
+
+    protected:
+        void run (void);
+
+    private:
+        friend class DocumentChunkTask;
+
+        bool analyzeNextChunk (void);
+        void publish (const DocumentReport &report, qint64 merged, bool complete);
+
+        const char *m_data;
+        qint64 m_length;
+        QByteArray m_buffer;
+        QFile *m_file;
+
+        QString m_encoding;
+        QString m_error_string;
+
+        QThreadPool m_pool;
+        QAtomicInt m_cancelled;
+        QAtomicInt m_next_chunk;
+        QVector<qint64> m_chunks;
+
+        QMutex m_mutex;
+        QWaitCondition m_condition;
+        QHash<int, DocumentReport *> m_finished_chunks;
+
+        mutable QMutex m_report_mutex;
+        DocumentReport m_report;
+        qint64 m_merged;
+        bool m_complete;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -0,0 +1,466 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include "simd.h"
+#include "document_stats.h"
+
+/*!
+ * \class DocumentStats
+ * \brief Keeps the word, line and character counts of a document
+ *
+ * The \c Editor does not count the whole document after each change.
+ * Before a change, it removes the lines affected by the change from the
+ * statistics with remove(), and after the change it adds the new text of
+ * those lines with add(). Words never span two lines, so the statistics
+ * stay exact and each change only costs the length of its lines.
+ *
+ * The text is UTF-8. A word is a sequence of characters that are not
+ * white space (the same definition as \c QChar::isSpace(), including
+ * the Unicode spaces), each code point counts as a character, and the
+ * line endings may be CR, LF or CR+LF.
+ *
+ * The text is counted directly from the buffer of Scintilla, in blocks
+ * of 32 (AVX2) or 16 (SSE2) bytes that are classified with SIMD
+ * instructions. The blocks that may contain a multi-byte space are
+ * counted by the scalar code, which is also used as a reference to
+ * verify the vectorised code (see countWith()).
+ */
+
+/*!
+ * \internal
+ * State of the counters while a text is counted, the state is kept
+ * between the vectorised blocks and the scalar code
+ */
+
+struct CountState {
+    qint64 words;
+    qint64 cr;
+    qint64 lf;
+    qint64 crlf;
+    qint64 continuations;
+    bool in_word;
+    bool last_cr;
+};
+
+/*!
+ * \internal
+ * Returns the length of the white space character that starts at the
+ * given \a {data}, or 0 if the character is not white space
+ */
+
+static inline int spaceLength (const uchar *data, qint64 length) {
+    uchar _byte = data[0];
+
+    if (_byte == ' ' || (_byte >= '\t' && _byte <= '\r'))
+        return 1;
+
+    if (_byte < 0xC2 || _byte > 0xE3 || length < 2)
+        return 0;
+
+    //
+    // U+0085 and U+00A0
+    //
+    if (_byte == 0xC2)
+        return (data[1] == 0x85 || data[1] == 0xA0) ? 2 : 0;
+
+    if (length < 3)
+        return 0;
+
+    //
+    // U+1680 and U+3000
+    //
+    if (_byte == 0xE1)
+        return (data[1] == 0x9A && data[2] == 0x80) ? 3 : 0;
+
+    if (_byte == 0xE3)
+        return (data[1] == 0x80 && data[2] == 0x80) ? 3 : 0;
+
+    //
+    // U+2000 to U+200A, U+2028, U+2029, U+202F and U+205F
+    //
+    if (_byte == 0xE2 && data[1] == 0x80)
+        return ((data[2] >= 0x80 && data[2] <= 0x8A) || data[2] == 0xA8 ||
+                data[2] == 0xA9 || data[2] == 0xAF) ? 3 : 0;
+
+    if (_byte == 0xE2 && data[1] == 0x81)
+        return data[2] == 0x9F ? 3 : 0;
+
+    return 0;
+}
+
+/*!
+ * \internal
+ * Counts the characters of \a {data} from the offset \a {from} until the
+ * offset \a {to} is reached. Returns the offset of the next character,
+ * which may be after \a {to} if the last character is a multi-byte space.
+ */
+
+static inline qint64 countRange (const uchar *data,
+                                 qint64 from,
+                                 qint64 to,
+                                 qint64 length,
+                                 CountState *state) {
+    qint64 i = from;
+
+    while (i < to) {
+        uchar _byte = data[i];
+
+        if ((_byte & 0xC0) == 0x80)
+            ++state->continuations;
+
+        if (_byte == '\n') {
+            ++state->lf;
+
+            if (state->last_cr)
+                ++state->crlf;
+        }
+
+        state->last_cr = _byte == '\r';
+
+        if (state->last_cr)
+            ++state->cr;
+
+        int _space = spaceLength (data + i, length - i);
+
+        if (_space > 0) {
+            state->in_word = false;
+            state->continuations += _space - 1;
+            i += _space;
+            continue;
+        }
+
+        if (!state->in_word) {
+            state->in_word = true;
+            ++state->words;
+        }
+
+        ++i;
+    }
+
+    return i;
+}
+
+#if SIMD_SSE2
+/*!
+ * \internal
+ * Returns a mask of the bytes of the \a {block} that may start a
+ * multi-byte space (C2 85, C2 A0, E1 9A, E2 80, E2 81 or E3 80), the
+ * \a {next} block starts at the second byte of the \a {block}
+ */
+
+static inline int spaceLeadsSse2 (__m128i block, __m128i next) {
+    __m128i _c2 = _mm_and_si128 (_mm_cmpeq_epi8 (block, _mm_set1_epi8 ((char) 0xC2)),
+                                 _mm_or_si128 (_mm_cmpeq_epi8 (next, _mm_set1_epi8 ((char) 0x85)),
+                                               _mm_cmpeq_epi8 (next, _mm_set1_epi8 ((char) 0xA0))));
+    __m128i _e1 = _mm_and_si128 (_mm_cmpeq_epi8 (block, _mm_set1_epi8 ((char) 0xE1)),
+                                 _mm_cmpeq_epi8 (next, _mm_set1_epi8 ((char) 0x9A)));
+    __m128i _e2 = _mm_and_si128 (_mm_cmpeq_epi8 (block, _mm_set1_epi8 ((char) 0xE2)),
+                                 _mm_cmpeq_epi8 (_mm_and_si128 (next, _mm_set1_epi8 ((char) 0xFE)),
+                                                 _mm_set1_epi8 ((char) 0x80)));
+    __m128i _e3 = _mm_and_si128 (_mm_cmpeq_epi8 (block, _mm_set1_epi8 ((char) 0xE3)),
+                                 _mm_cmpeq_epi8 (next, _mm_set1_epi8 ((char) 0x80)));
+
+    return _mm_movemask_epi8 (_mm_or_si128 (_mm_or_si128 (_c2, _e1), _mm_or_si128 (_e2, _e3)));
+}
+
+/*!
+ * \internal
+ * Counts the given text in blocks of 16 bytes, returns the offset of the
+ * first byte that was not counted
+ */
+
+static qint64 countSse2 (const uchar *data, qint64 length, CountState *state) {
+    const __m128i _tab = _mm_set1_epi8 ('\t');
+    const __m128i _four = _mm_set1_epi8 (4);
+    const __m128i _space = _mm_set1_epi8 (' ');
+    const __m128i _cr = _mm_set1_epi8 ('\r');
+    const __m128i _lf = _mm_set1_epi8 ('\n');
+    const __m128i _continuation = _mm_set1_epi8 ((char) 0xC0);
+
+    qint64 i = 0;
+
+    while (i + 17 <= length) {
+        __m128i _block = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (data + i));
+        unsigned int _cont_mask = 0;
+
+        //
+        // Blocks with non-ASCII characters may contain continuation bytes
+        // and multi-byte spaces, the spaces are counted by the scalar code
+        //
+        if (_mm_movemask_epi8 (_block) != 0) {
+            __m128i _next = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (data + i + 1));
+
+            if (spaceLeadsSse2 (_block, _next) != 0) {
+                i = countRange (data, i, i + 16, length, state);
+                continue;
+            }
+
+            _cont_mask = _mm_movemask_epi8 (_mm_cmplt_epi8 (_block, _continuation));
+        }
+
+        //
+        // Classify the bytes, white space is a space or a byte between
+        // the tab and the carriage return
+        //
+        __m128i _control = _mm_sub_epi8 (_block, _tab);
+        __m128i _blank = _mm_or_si128 (_mm_cmpeq_epi8 (_block, _space),
+                                       _mm_cmpeq_epi8 (_mm_min_epu8 (_control, _four), _control));
+
+        unsigned int _word = ~_mm_movemask_epi8 (_blank) & 0xFFFF;
+        unsigned int _cr_mask = _mm_movemask_epi8 (_mm_cmpeq_epi8 (_block, _cr));
+        unsigned int _lf_mask = _mm_movemask_epi8 (_mm_cmpeq_epi8 (_block, _lf));
+
+        state->words += popCount (_word & ~((_word << 1) | (state->in_word ? 1 : 0)));
+        state->cr += popCount (_cr_mask);
+        state->lf += popCount (_lf_mask);
+        state->crlf += popCount (_lf_mask & ((_cr_mask << 1) | (state->last_cr ? 1 : 0)));
+        state->continuations += popCount (_cont_mask);
+
+        state->in_word = (_word >> 15) & 1;
+        state->last_cr = (_cr_mask >> 15) & 1;
+
+        i += 16;
+    }
+
+    return i;
+}
+#endif
+
+#if SIMD_AVX2
+/*!
+ * \internal
+ * AVX2 version of spaceLeadsSse2(), returns \c {true} if any byte of the
+ * \a {block} may start a multi-byte space
+ */
+
+SIMD_TARGET_AVX2 static inline bool spaceLeadsAvx2 (__m256i block, __m256i next) {
+    __m256i _c2 = _mm256_and_si256 (_mm256_cmpeq_epi8 (block, _mm256_set1_epi8 ((char) 0xC2)),
+                                    _mm256_or_si256 (_mm256_cmpeq_epi8 (next, _mm256_set1_epi8 ((char) 0x85)),
+                                                     _mm256_cmpeq_epi8 (next, _mm256_set1_epi8 ((char) 0xA0))));
+    __m256i _e1 = _mm256_and_si256 (_mm256_cmpeq_epi8 (block, _mm256_set1_epi8 ((char) 0xE1)),
+                                    _mm256_cmpeq_epi8 (next, _mm256_set1_epi8 ((char) 0x9A)));
+    __m256i _e2 = _mm256_and_si256 (_mm256_cmpeq_epi8 (block, _mm256_set1_epi8 ((char) 0xE2)),
+                                    _mm256_cmpeq_epi8 (_mm256_and_si256 (next, _mm256_set1_epi8 ((char) 0xFE)),
+                                                       _mm256_set1_epi8 ((char) 0x80)));
+    __m256i _e3 = _mm256_and_si256 (_mm256_cmpeq_epi8 (block, _mm256_set1_epi8 ((char) 0xE3)),
+                                    _mm256_cmpeq_epi8 (next, _mm256_set1_epi8 ((char) 0x80)));
+
+    __m256i _leads = _mm256_or_si256 (_mm256_or_si256 (_c2, _e1), _mm256_or_si256 (_e2, _e3));
+    return !_mm256_testz_si256 (_leads, _leads);
+}
+
+/*!
+ * \internal
+ * Counts the given text in blocks of 32 bytes, returns the offset of the
+ * first byte that was not counted
+ */
+
+SIMD_TARGET_AVX2 static qint64 countAvx2 (const uchar *data, qint64 length, CountState *state) {
+    const __m256i _tab = _mm256_set1_epi8 ('\t');
+    const __m256i _four = _mm256_set1_epi8 (4);
+    const __m256i _space = _mm256_set1_epi8 (' ');
+    const __m256i _cr = _mm256_set1_epi8 ('\r');
+    const __m256i _lf = _mm256_set1_epi8 ('\n');
+    const __m256i _continuation = _mm256_set1_epi8 ((char) 0xC0);
+
+    qint64 i = 0;
+
+    while (i + 33 <= length) {
+        __m256i _block = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (data + i));
+        unsigned int _cont_mask = 0;
+
+        //
+        // Blocks with non-ASCII characters may contain continuation bytes
+        // and multi-byte spaces, the spaces are counted by the scalar code
+        //
+        if (_mm256_movemask_epi8 (_block) != 0) {
+            __m256i _next = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (data + i + 1));
+
+            if (spaceLeadsAvx2 (_block, _next)) {
+                i = countRange (data, i, i + 32, length, state);
+                continue;
+            }
+
+            _cont_mask = _mm256_movemask_epi8 (_mm256_cmpgt_epi8 (_continuation, _block));
+        }
+
+        //
+        // Classify the bytes, white space is a space or a byte between
+        // the tab and the carriage return
+        //
+        __m256i _control = _mm256_sub_epi8 (_block, _tab);
+        __m256i _blank = _mm256_or_si256 (_mm256_cmpeq_epi8 (_block, _space),
+                                          _mm256_cmpeq_epi8 (_mm256_min_epu8 (_control, _four), _control));
+
+        unsigned int _word = ~(unsigned int) _mm256_movemask_epi8 (_blank);
+        unsigned int _cr_mask = _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (_block, _cr));
+        unsigned int _lf_mask = _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (_block, _lf));
+
+        state->words += popCount (_word & ~((_word << 1) | (state->in_word ? 1 : 0)));
+        state->cr += popCount (_cr_mask);
+        state->lf += popCount (_lf_mask);
+        state->crlf += popCount (_lf_mask & ((_cr_mask << 1) | (state->last_cr ? 1 : 0)));
+        state->continuations += popCount (_cont_mask);
+
+        state->in_word = (_word >> 31) & 1;
+        state->last_cr = (_cr_mask >> 31) & 1;
+
+        i += 32;
+    }
+
+    return i;
+}
+#endif
+
+/*!
+ * Initializes the statistics of an empty document
+ */
+
+DocumentStats::DocumentStats (void) {
+    clear();
+}
+
+/*!
+ * Resets the statistics to the values of an empty document
+ */
+
+void DocumentStats::clear (void) {
+    m_words = 0;
+    m_line_ends = 0;
+    m_characters = 0;
+}
+
+/*!
+ * Returns the number of words of the document
+ */
+
+qint64 DocumentStats::words (void) const {
+    return m_words;
+}
+
+/*!
+ * Returns the number of lines of the document (an empty document
+ * has one line)
+ */
+
+qint64 DocumentStats::lines (void) const {
+    return m_line_ends + 1;
+}
+
+/*!
+ * Returns the number of characters (code points) of the document
+ */
+
+qint64 DocumentStats::characters (void) const {
+    return m_characters;
+}
+
+/*!
+ * Adds the statistics of the given text, which must start at the start of
+ * a line and end at the end of a line (or at the end of the document)
+ */
+
+void DocumentStats::add (const char *data, qint64 length) {
+    qint64 _words, _characters, _line_ends;
+    count (data, length, &_words, &_characters, &_line_ends);
+
+    m_words += _words;
+    m_line_ends += _line_ends;
+    m_characters += _characters;
+}
+
+/*!
+ * Removes the statistics of the given text, which must have been added
+ * before with add()
+ */
+
+void DocumentStats::remove (const char *data, qint64 length) {
+    qint64 _words, _characters, _line_ends;
+    count (data, length, &_words, &_characters, &_line_ends);
+
+    m_words -= _words;
+    m_line_ends -= _line_ends;
+    m_characters -= _characters;
+}
+
+/*!
+ * Counts the \a {words}, the \a {characters} and the \a {line_ends} of
+ * the given UTF-8 text, using the fastest implementation supported by
+ * the processor
+ */
+
+void DocumentStats::count (const char *data,
+                           qint64 length,
+                           qint64 *words,
+                           qint64 *characters,
+                           qint64 *line_ends) {
+    if (!countWith (Avx2, data, length, words, characters, line_ends) &&
+        !countWith (Sse2, data, length, words, characters, line_ends))
+        countWith (Scalar, data, length, words, characters, line_ends);
+}
+
+/*!
+ * Counts the given text with the given \a {implementation}, returns
+ * \c {false} (without counting anything) if the implementation is not
+ * supported by the compiler or the processor.
+ *
+ * The \c Scalar implementation counts the text byte by byte, it is used
+ * as a reference to verify the vectorised implementations.
+ */
+
+bool DocumentStats::countWith (Implementation implementation,
+                               const char *data,
+                               qint64 length,
+                               qint64 *words,
+                               qint64 *characters,
+                               qint64 *line_ends) {
+    const uchar *_data = reinterpret_cast<const uchar *> (data);
+    CountState _state = { 0, 0, 0, 0, 0, false, false };
+    qint64 i = 0;
+
+    if (implementation == Avx2) {
+#if SIMD_AVX2
+        if (!cpuSupportsAvx2())
+            return false;
+
+        i = countAvx2 (_data, length, &_state);
+#else
+        return false;
+#endif
+    }
+
+    else if (implementation == Sse2) {
+#if SIMD_SSE2
+        i = countSse2 (_data, length, &_state);
+#else
+        return false;
+#endif
+    }
+
+    if (i < length)
+        countRange (_data, i, length, length, &_state);
+
+    *words = _state.words;
+    *characters = length - _state.continuations;
+    *line_ends = _state.cr + _state.lf - _state.crlf;
+
+    return true;
+}
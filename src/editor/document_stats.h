@@ -0,0 +1,72 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef DOCUMENT_STATS_H
+#define DOCUMENT_STATS_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QtGlobal>
+
+class DocumentStats {
+    public:
+        enum Implementation {
+            Scalar,
+            Sse2,
+            Avx2
+        };
+
+        DocumentStats (void);
+
+        void clear (void);
+
+        qint64 words (void) const;
+        qint64 lines (void) const;
+        qint64 characters (void) const;
+
+        void add (const char *data, qint64 length);
+        void remove (const char *data, qint64 length);
+
+        static void count (const char *data,
+                           qint64 length,
+                           qint64 *words,
+                           qint64 *characters,
+                           qint64 *line_ends);
+        static bool countWith (Implementation implementation,
+                               const char *data,
+                               qint64 length,
+                               qint64 *words,
+                               qint64 *characters,
+                               qint64 *line_ends);
+
+    private:
+        qint64 m_words;
+        qint64 m_line_ends;
+        qint64 m_characters;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -0,0 +1,458 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QDir>
+#include <QFile>
+#include <QUuid>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QTextCodec>
+#include <QDataStream>
+#include <QStandardPaths>
+
+#include "compression.h"
+#include "edit_journal.h"
+#include "journal_writer.h"
+
+#define JOURNAL_MAGIC 0x54504A31
+#define JOURNAL_SUFFIX ".journal"
+
+#define RECORD_HEADER 'H'
+#define RECORD_SNAPSHOT 'S'
+#define RECORD_INSERT 'I'
+#define RECORD_DELETE 'D'
+
+/*!
+ * \class EditJournal
+ * \brief Records the changes of a document to recover them after a crash
+ *
+ * Each \c Editor has an \c EditJournal, which is started when the document
+ * is modified and discarded when the document is saved (or closed without
+ * saving). While the journal is active, the editor records each insertion
+ * and deletion of text.
+ *
+ * The records are only added to a memory buffer, the \c JournalWriter
+ * thread appends them to the journal file in batches, so editing the
+ * document never waits for the disk.
+ *
+ * The journal starts with a header that describes the base of the
+ * document (the saved file or a snapshot of the text). To keep the journal
+ * small, the editor periodically replaces the journal with a new snapshot
+ * of the document (see writeSnapshot()).
+ *
+ * When the application starts, the journals left by a crash are listed
+ * with journals() and converted back into documents with replay().
+ */
+
+/*!
+ * \internal
+ * Initializes the journal, the journal file is created when the journal
+ * is started
+ */
+
+EditJournal::EditJournal (QObject *parent) : QObject (parent),
+    m_active (false),
+    m_records (0),
+    m_rewrite (false),
+    m_remove (false),
+    m_has_snapshot (false) {
+    m_file = directory() + "/" +
+             QUuid::createUuid().toString().mid (1, 36) +
+             JOURNAL_SUFFIX;
+
+    JournalWriter::instance()->registerJournal (this);
+}
+
+/*!
+ * \internal
+ * Stops writing the journal, the journal file is kept unless discard()
+ * was called before (in that case, the writer removes the file)
+ */
+
+EditJournal::~EditJournal (void) {
+    JournalWriter::instance()->unregisterJournal (this);
+
+    if (m_remove)
+        JournalWriter::instance()->removeFile (m_file);
+}
+
+/*!
+ * Returns \c {true} if the journal is recording the changes of a document
+ */
+
+bool EditJournal::isActive (void) const {
+    return m_active;
+}
+
+/*!
+ * Returns the path of the journal file
+ */
+
+QString EditJournal::fileName (void) const {
+    return m_file;
+}
+
+/*!
+ * Returns the number of records written since the last snapshot, the
+ * editor uses this value to decide when to compact the journal
+ */
+
+int EditJournal::recordsSinceSnapshot (void) const {
+    return m_records;
+}
+
+/*!
+ * Starts the journal for the given saved \a {document}, the size and the
+ * modification date of the file are used to verify that the file was not
+ * changed before replaying the journal.
+ */
+
+void EditJournal::start (const QString &document,
+                         const QByteArray &encoding,
+                         qint64 base_size,
+                         const QDateTime &base_modified) {
+    setHeader (document, encoding, base_size, base_modified.toMSecsSinceEpoch());
+}
+
+/*!
+ * Starts the journal for a \a {document} that is not saved in a file (or
+ * that is different from its file), using the given text as its base
+ */
+
+void EditJournal::start (const QString &document,
+                         const QByteArray &encoding,
+                         const QByteArray &snapshot) {
+    setHeader (document, encoding, -1, -1);
+    writeSnapshot (snapshot);
+}
+
+/*!
+ * Records the insertion of the given \a {text} at the given \a {position}
+ */
+
+void EditJournal::recordInsert (qint64 position, const char *text, qint64 length) {
+    if (!m_active)
+        return;
+
+    QByteArray _record;
+    QDataStream _stream (&_record, QIODevice::WriteOnly);
+    _stream << (quint8) RECORD_INSERT << position;
+    _stream.writeBytes (text, (uint) length);
+
+    appendRecord (_record);
+}
+
+/*!
+ * Records the deletion of \a {length} bytes at the given \a {position}
+ */
+
+void EditJournal::recordDelete (qint64 position, qint64 length) {
+    if (!m_active)
+        return;
+
+    QByteArray _record;
+    QDataStream _stream (&_record, QIODevice::WriteOnly);
+    _stream << (quint8) RECORD_DELETE << position << length;
+
+    appendRecord (_record);
+}
+
+/*!
+ * Replaces the contents of the journal with the given \a {text}, the
+ * records written before the snapshot are no longer needed.
+ *
+ * The text is not copied, the \c JournalWriter thread serializes it
+ * directly to the journal file.
+ */
+
+void EditJournal::writeSnapshot (const QByteArray &text) {
+    if (!m_active)
+        return;
+
+    QMutexLocker _locker (&m_mutex);
+    m_records = 0;
+    m_rewrite = true;
+    m_has_snapshot = true;
+    m_snapshot = text;
+    m_pending.clear();
+}
+
+/*!
+ * Stops the journal and removes the journal file, this is called when
+ * the document is saved or when the user discards the changes
+ */
+
+void EditJournal::discard (void) {
+    if (!m_active)
+        return;
+
+    QMutexLocker _locker (&m_mutex);
+    m_active = false;
+    m_records = 0;
+    m_remove = true;
+    m_rewrite = false;
+    m_has_snapshot = false;
+    m_header.clear();
+    m_pending.clear();
+    m_snapshot.clear();
+}
+
+/*!
+ * Writes the pending records to the journal file, this function is called
+ * by the \c JournalWriter thread
+ */
+
+void EditJournal::flush (void) {
+    m_mutex.lock();
+    bool _remove = m_remove;
+    bool _rewrite = m_rewrite;
+    bool _has_snapshot = m_has_snapshot;
+    QByteArray _header = m_header;
+    QByteArray _pending = m_pending;
+    QByteArray _snapshot = m_snapshot;
+
+    m_remove = false;
+    m_rewrite = false;
+    m_has_snapshot = false;
+    m_pending.clear();
+    m_snapshot.clear();
+    m_mutex.unlock();
+
+    if (_remove)
+        QFile::remove (m_file);
+
+    //
+    // Replace the journal file with the header, the
+    // snapshot and the records written after it
+    //
+    if (_rewrite) {
+        QDir().mkpath (directory());
+
+        QSaveFile _file (m_file);
+        if (_file.open (QIODevice::WriteOnly)) {
+            _file.write (_header);
+
+            if (_has_snapshot) {
+                QDataStream _stream (&_file);
+                _stream << (quint8) RECORD_SNAPSHOT << _snapshot;
+            }
+
+            _file.write (_pending);
+            _file.commit();
+        }
+    }
+
+    //
+    // Append the new records to the journal file
+    //
+    else if (!_pending.isEmpty()) {
+        QFile _file (m_file);
+        if (_file.open (QIODevice::WriteOnly | QIODevice::Append)) {
+            _file.write (_pending);
+            _file.close();
+        }
+    }
+}
+
+/*!
+ * Returns the directory where the journals are saved
+ */
+
+QString EditJournal::directory (void) {
+    return QStandardPaths::writableLocation (QStandardPaths::DataLocation) + "/journals";
+}
+
+/*!
+ * Returns the paths of the journal files found in the journal directory
+ */
+
+QStringList EditJournal::journals (void) {
+    QDir _dir (directory());
+    QStringList _journals;
+
+    foreach (const QString &_file, _dir.entryList (QStringList ("*" JOURNAL_SUFFIX), QDir::Files))
+        _journals.append (_dir.absoluteFilePath (_file));
+
+    return _journals;
+}
+
+/*!
+ * Reads the given \a {journal} and rebuilds the document that it
+ * describes. The path of the document file (which may be empty) is written
+ * in \a {document}, the encoding in \a {encoding} and the text (in UTF-8)
+ * in \a {text}.
+ *
+ * Returns \c {false} if the journal cannot be replayed, for example, when
+ * the base file of the document was changed after the journal was written.
+ */
+
+bool EditJournal::replay (const QString &journal,
+                          QString *document,
+                          QByteArray *encoding,
+                          QByteArray *text) {
+    Q_ASSERT (document != NULL);
+    Q_ASSERT (encoding != NULL);
+    Q_ASSERT (text != NULL);
+
+    QFile _file (journal);
+    if (!_file.open (QIODevice::ReadOnly))
+        return false;
+
+    QDataStream _stream (&_file);
+
+    quint32 _magic;
+    quint8 _type;
+    qint64 _base_size;
+    qint64 _base_modified;
+
+    _stream >> _magic >> _type;
+    if (_magic != JOURNAL_MAGIC || _type != RECORD_HEADER)
+        return false;
+
+    _stream >> *document >> *encoding >> _base_size >> _base_modified;
+    if (_stream.status() != QDataStream::Ok)
+        return false;
+
+    bool _has_base = false;
+
+    //
+    // Read the saved file, if it was not changed
+    //
+    QFileInfo _info (*document);
+    if (_base_size >= 0 && _info.exists() && _info.size() == _base_size &&
+        _info.lastModified().toMSecsSinceEpoch() == _base_modified) {
+        QFile _base (*document);
+        QByteArray _data;
+        bool _readable = _base.open (QIODevice::ReadOnly);
+
+        if (_readable)
+            _data = _base.readAll();
+
+        //
+        // The editor keeps compressed files decompressed
+        //
+        CompressionFormat *_format = CompressionFormat::detect (_data);
+
+        if (_readable && _format != NULL) {
+            QByteArray _compressed = _data;
+            _readable = CompressionFormat::decompress (_format, _compressed, &_data);
+        }
+
+        if (_readable) {
+            QTextCodec *_codec = QTextCodec::codecForName (*encoding);
+
+            if (*encoding == "UTF-8" || _codec == NULL)
+                *text = _data;
+            else
+                *text = _codec->toUnicode (_data).toUtf8();
+
+            //
+            // The loader does not keep the byte order mark
+            //
+            if (text->startsWith ("\xEF\xBB\xBF"))
+                text->remove (0, 3);
+
+            _has_base = true;
+        }
+    }
+
+    //
+    // Apply each record, an incomplete record at the end
+    // of the file (written during the crash) is ignored
+    //
+    while (!_stream.atEnd()) {
+        qint64 _position;
+        qint64 _length;
+        QByteArray _data;
+
+        _stream >> _type;
+
+        if (_type == RECORD_SNAPSHOT) {
+            _stream >> _data;
+
+            if (_stream.status() == QDataStream::Ok) {
+                *text = _data;
+                _has_base = true;
+            }
+        }
+
+        else if (_type == RECORD_INSERT) {
+            _stream >> _position >> _data;
+
+            if (_stream.status() == QDataStream::Ok && _has_base &&
+                _position >= 0 && _position <= text->size())
+                text->insert ((int) _position, _data);
+        }
+
+        else if (_type == RECORD_DELETE) {
+            _stream >> _position >> _length;
+
+            if (_stream.status() == QDataStream::Ok && _has_base &&
+                _position >= 0 && _position + _length <= text->size())
+                text->remove ((int) _position, (int) _length);
+        }
+
+        else
+            break;
+
+        if (_stream.status() != QDataStream::Ok)
+            break;
+    }
+
+    return _has_base;
+}
+
+/*!
+ * \internal
+ * Activates the journal and creates the header record, the journal file
+ * is (re)written by the next flush
+ */
+
+void EditJournal::setHeader (const QString &document,
+                             const QByteArray &encoding,
+                             qint64 base_size,
+                             qint64 base_modified) {
+    QByteArray _header;
+    QDataStream _stream (&_header, QIODevice::WriteOnly);
+    _stream << (quint32) JOURNAL_MAGIC << (quint8) RECORD_HEADER
+            << document << encoding << base_size << base_modified;
+
+    QMutexLocker _locker (&m_mutex);
+    m_active = true;
+    m_records = 0;
+    m_remove = false;
+    m_rewrite = true;
+    m_has_snapshot = false;
+    m_header = _header;
+    m_pending.clear();
+    m_snapshot.clear();
+}
+
+/*!
+ * \internal
+ * Adds the given \a {record} to the buffer of pending records
+ */
+
+void EditJournal::appendRecord (const QByteArray &record) {
+    QMutexLocker _locker (&m_mutex);
+    m_pending.append (record);
+    ++m_records;
+}
@@ -0,0 +1,91 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef EDIT_JOURNAL_H
+#define EDIT_JOURNAL_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QMutex>
+#include <QObject>
+#include <QDateTime>
+#include <QByteArray>
+#include <QStringList>
+
+class EditJournal : public QObject {
+        Q_OBJECT
+
+    public:
+        explicit EditJournal (QObject *parent = 0);
+        ~EditJournal (void);
+
+        bool isActive (void) const;
+        QString fileName (void) const;
+        int recordsSinceSnapshot (void) const;
+
+        void start (const QString &document,
+                    const QByteArray &encoding,
+                    qint64 base_size,
+                    const QDateTime &base_modified);
+        void start (const QString &document,
+                    const QByteArray &encoding,
+                    const QByteArray &snapshot);
+
+        void recordInsert (qint64 position, const char *text, qint64 length);
+        void recordDelete (qint64 position, qint64 length);
+        void writeSnapshot (const QByteArray &text);
+        void discard (void);
+        void flush (void);
+
+        static QString directory (void);
+        static QStringList journals (void);
+        static bool replay (const QString &journal,
+                            QString *document,
+                            QByteArray *encoding,
+                            QByteArray *text);
+
+    private:
+        void setHeader (const QString &document,
+                        const QByteArray &encoding,
+                        qint64 base_size,
+                        qint64 base_modified);
+        void appendRecord (const QByteArray &record);
+
+        bool m_active;
+        QString m_file;
+        int m_records;
+
+        mutable QMutex m_mutex;
+        bool m_rewrite;
+        bool m_remove;
+        bool m_has_snapshot;
+        QByteArray m_header;
+        QByteArray m_pending;
+        QByteArray m_snapshot;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
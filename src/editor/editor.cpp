@@ -20,14 +20,22 @@
 //
 
 #include <math.h>
+#include <limits.h>
 #include <string.h>
 
 #include <QUrl>
 #include <QIcon>
-#include <QMutex>
-#include <QSettings>
+#include <QTimer>
+#include <QFileInfo>
+#include <QScrollBar>
+#include <QTextCodec>
+#include <QTextDecoder>
+#include <QFileSystemWatcher>
+#include <QEventLoop>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QInputDialog>
+#include <QLineEdit>
 #include <QFontDialog>
 #include <QApplication>
 #include <QPrintDialog>
@@ -40,11 +48,34 @@
 #include "editor.h"
 #include "defaults.h"
 #include "platform.h"
+#include "file_loader.h"
+#include "file_writer.h"
+#include "compression.h"
+#include "file_viewer.h"
+#include "hex_viewer.h"
+#include "file_reloader.h"
+#include "edit_journal.h"
+#include "format_detector.h"
 #include "lexer_database.h"
+#include "language_detector.h"
+#include "settings_registry.h"
+#include "update_scheduler.h"
+#include "document_analyzer.h"
+#include "documentinfodialog.h"
 
 #define KILOBYTE 1024
 #define MEGABYTE 1048576
 
+#define ASYNC_SAVE_THRESHOLD (8 * MEGABYTE)
+#define FOLLOW_CHUNK_SIZE (4 * MEGABYTE)
+#define MAX_SNAPSHOT_SIZE ((qint64) INT_MAX - KILOBYTE)
+#define JOURNAL_COMPACT_INTERVAL 30000
+#define JOURNAL_COMPACT_RECORDS 10000
+#define IDLE_STYLING_SIZE (512 * KILOBYTE)
+#define DOCUMENT_CACHE_SIZE (256 * KILOBYTE)
+#define WRAP_POSITION_CACHE 4096
+#define DEFAULT_POSITION_CACHE 1024
+
 /*!
  * \internal
  * Initializes and configures the editor
@@ -53,7 +84,29 @@
 Editor::Editor (QWidget *parent) : QsciScintilla (parent) {
     setAttribute (Qt::WA_DeleteOnClose);
 
+    m_loader = NULL;
+    m_viewer = NULL;
+    m_hex_viewer = NULL;
+    m_force_text = false;
+    m_read_only = false;
+    m_large_file = false;
+    m_bom = false;
+    m_encoding = "UTF-8";
+    m_follow = false;
+    m_file_size = 0;
+    m_follow_max_lines = 0;
+    m_follow_decoder = NULL;
+    m_event_mask = SC_MODEVENTMASKALL;
     m_theme = new Theme (this);
+    m_reloader = NULL;
+    m_reload_pending = false;
+    m_saving = false;
+    m_change_pending = false;
+    m_watcher = new QFileSystemWatcher (this);
+    m_journal = new EditJournal (this);
+    m_journal_enabled = settings()->journalEnabled();
+    m_journal_skip_change = false;
+    m_changing = false;
 
     setUtf8 (true);
     setIndentationWidth (4);
@@ -64,8 +117,37 @@ Editor::Editor (QWidget *parent) : QsciScintilla (parent) {
     setFolding (QsciScintilla::BoxedTreeFoldStyle, 1);
     setBraceMatching (QsciScintilla::SloppyBraceMatch);
 
-    connect (this, SIGNAL (textChanged()), this, SLOT (updateLineNumbers()));
-    connect (this, SIGNAL (settingsChanged()), this, SLOT (updateSettings()));
+    UpdateScheduler::instance()->connectUpdate (this, SIGNAL (textChanged()),
+                                                this, SLOT (updateLineNumbers()));
+
+    connect (m_watcher, SIGNAL (fileChanged (QString)), this, SLOT (onFileChanged()));
+
+    //
+    // Record the changes of the document in the crash-recovery journal
+    //
+    QTimer *_compact_timer = new QTimer (this);
+    _compact_timer->start (JOURNAL_COMPACT_INTERVAL);
+    connect (_compact_timer, SIGNAL (timeout()), this, SLOT (compactJournal()));
+    connect (this, SIGNAL (modificationChanged (bool)), this, SLOT (onModificationChanged (bool)));
+    connect (this, SIGNAL (SCN_MODIFIED (int, int, const char *, int, int, int, int, int, int, int)),
+             this, SLOT (onModified (int, int, const char *, int, int, int, int, int, int, int)));
+}
+
+/*!
+ * \internal
+ * Stops the file loader before destroying the editor
+ */
+
+Editor::~Editor (void) {
+    if (m_loader != NULL) {
+        m_loader->cancel();
+        m_loader->wait();
+    }
+
+    if (m_reloader != NULL)
+        m_reloader->wait();
+
+    delete m_follow_decoder;
 }
 
 /*!
@@ -80,10 +162,14 @@ Editor::Editor (QWidget *parent) : QsciScintilla (parent) {
  * \endlist
  *
  * Returns \c {false} when, the user wants to continue working
- * on the document by clicking the "Cancel" button
+ * on the document by clicking the "Cancel" button, or while the
+ * document is being saved
  */
 
 bool Editor::maybeSave (void) {
+    if (m_saving)
+        return false;
+
     if (!isModified())
         return true;
 
@@ -124,13 +210,48 @@ bool Editor::maybeSave (void) {
 }
 
 /*!
- * Returns the number of words in the document
+ * Returns the number of words in the document, the value is updated
+ * incrementally when the document changes
  */
 
 int Editor::wordCount (void) {
-    return text().split
-           (QRegExp ("(\\s|\\n|\\r)+"),
-            QString::SkipEmptyParts).count();
+    return (int) qMin (m_stats.words(), (qint64) INT_MAX);
+}
+
+/*!
+ * Returns the number of characters (Unicode code points) in the document
+ */
+
+qint64 Editor::characterCount (void) const {
+    return m_stats.characters();
+}
+
+/*!
+ * Returns \c {true} if the editor disabled its most expensive features
+ * (syntax highlighting, word wrapping, folding, etc.) because the current
+ * document is too large.
+ */
+
+bool Editor::isLargeFile (void) const {
+    return m_large_file;
+}
+
+/*!
+ * Returns the \c FileViewer used to display the current document, or
+ * \c NULL if the document was loaded completely in the editor
+ */
+
+FileViewer *Editor::viewer (void) const {
+    return m_viewer;
+}
+
+/*!
+ * Returns the \c HexViewer used to display the current (binary) document,
+ * or \c NULL if the document is displayed as text
+ */
+
+HexViewer *Editor::hexViewer (void) const {
+    return m_hex_viewer;
 }
 
 /*!
@@ -148,7 +269,8 @@ bool Editor::titleIsShit (void) {
 
 QString Editor::calculateSize (void) {
     QString _units;
-    float _length = length();
+    float _length = m_viewer != NULL ? m_viewer->fileSize() :
+                    m_hex_viewer != NULL ? m_hex_viewer->fileSize() : length();
 
     if (_length < KILOBYTE)
         _units = " " + tr ("bytes");
@@ -166,6 +288,80 @@ QString Editor::calculateSize (void) {
     return QString::number (floorf (_length * 100 + 0.5) / 100) + _units;
 }
 
+/*!
+ * Returns the name of the encoding used to read and write the document
+ */
+
+QString Editor::encoding (void) const {
+    return QString::fromLatin1 (m_encoding);
+}
+
+/*!
+ * Returns \c {true} if the document file starts with a byte order mark
+ */
+
+bool Editor::hasBom (void) const {
+    return m_bom;
+}
+
+/*!
+ * Returns the name of the compression format of the document file, or an
+ * empty string if the file is not compressed
+ */
+
+QString Editor::compression (void) const {
+    return m_compression;
+}
+
+/*!
+ * Returns \c {true} if the editor is following the changes of the file
+ */
+
+bool Editor::isFollowing (void) const {
+    return m_follow;
+}
+
+/*!
+ * Stops the crash-recovery journal of the document and removes its file,
+ * this must be called when the user closes the document without saving it
+ */
+
+void Editor::discardJournal (void) {
+    m_journal->discard();
+}
+
+/*!
+ * Replaces the document with the given \a {text}, which was recovered
+ * from the journal of a previous session. The document stays modified,
+ * so that the user can save it.
+ */
+
+void Editor::recoverDocument (const QString &file,
+                              const QByteArray &encoding,
+                              const QByteArray &text) {
+    bool _journal_enabled = m_journal_enabled;
+    m_journal_enabled = false;
+
+    if (!file.isEmpty()) {
+        CompressionFormat *_format = CompressionFormat::detectFile (file);
+
+        m_compression = _format != NULL ? _format->name() : QString();
+        m_file_size = QFileInfo (file).size();
+        configureDocument (file);
+    }
+
+    m_encoding = encoding;
+    SendScintilla (SCI_CLEARALL);
+    SendScintilla (SCI_APPENDTEXT, (unsigned long) text.size(), text.constData());
+    SendScintilla (SCI_EMPTYUNDOBUFFER);
+
+    m_journal_enabled = _journal_enabled;
+    if (m_journal_enabled)
+        m_journal->start (file, encoding, text);
+
+    emit updateTitle();
+}
+
 /*!
  * Returns the document title
  */
@@ -224,11 +420,36 @@ void Editor::resetZoom (void) {
 }
 
 /*!
- * Shows a message box with information about the
- * current document
+ * Shows a dialog with information about the current document, which
+ * is computed in the background from a snapshot of the document.
+ *
+ * If the document has not been changed since it was read or written,
+ * the analyzer maps the file instead, so that large documents are not
+ * copied in the GUI thread.
  */
 
 void Editor::documentInfo (void) {
+    DocumentAnalyzer *_analyzer = new DocumentAnalyzer();
+    _analyzer->setEncoding (encoding());
+
+    //
+    // The viewers only have a part of the file in the editor, so the file
+    // is analyzed instead of the text
+    //
+    qint64 _length = SendScintilla (SCI_GETLENGTH);
+
+    if (m_viewer != NULL || m_hex_viewer != NULL || matchesFile (_length))
+        _analyzer->setFile (m_document_title);
+
+    else {
+        const char *_data = static_cast<const char *>
+                            (SendScintillaPtrResult (SCI_GETCHARACTERPOINTER));
+
+        _analyzer->setData (_data, _length);
+    }
+
+    DocumentInfoDialog *_dialog = new DocumentInfoDialog (_analyzer, m_document_title, this);
+    _dialog->show();
 }
 
 /*!
@@ -237,44 +458,134 @@ void Editor::documentInfo (void) {
 
 void Editor::updateSettings (void) {
     //
-    // Load the saved font
+    // Check if the user enabled/disabled the large file mode
     //
-    m_font.setBold (settings()->value ("font-bold", false).toBool());
-    m_font.setItalic (settings()->value ("font-italic", false).toBool());
-    m_font.setUnderline (settings()->value ("font-underline", false).toBool());
-    m_font.setPointSize (settings()->value ("font-size", DEFAULT_FONT_SIZE).toInt());
-    m_font.setFamily (settings()->value ("font-family", DEFAULT_FONT_FAMILY).toString());
+    if (!isLoading())
+        updateLargeFileMode (length(), lines());
 
     //
-    // Enable/disable word wrapping based on the saved settings
+    // Load the saved font, it is applied with the lexer
     //
-    setWordWrap (settings()->value ("wordwrap-enabled", SETTINGS_WORD_WRAP_ENABLED).toBool());
+    loadFont();
 
     //
-    // Update the colors of the text editor
+    // Update word wrapping, caret line & line numbers
     //
-    theme()->readTheme (settings()->value ("color-scheme", DEFAULT_THEME).toString());
-    setMarginsBackgroundColor (theme()->lineNumbersBackground());
-    setMarginsForegroundColor (theme()->lineNumbersForeground());
-    setCaretLineBackgroundColor (theme()->currentLineBackground());
+    updateWordWrap();
+    updateCaretLine();
+    updateLineNumberSettings();
 
     //
-    // Update caret line & line numbers
+    // Disable the features that need to scan the whole document
+    // when working with large files
     //
-    setCaretLineVisible (settings()->value ("hc-line-enabled", SETTINGS_CARET_LINE).toBool());
-    m_line_numbers = settings()->value ("line-numbers-enabled", SETTINGS_LINE_NUMBERS).toBool();
+    setIndentationGuides (!m_large_file);
+    setBraceMatching (m_large_file ? NoBraceMatch : SloppyBraceMatch);
+    setFolding (m_large_file ? NoFoldStyle : BoxedTreeFoldStyle, 1);
 
     //
-    // Enable/Disable line numbers
+    // Update the colors and re-load the current lexer
     //
-    setMarginWidth (0, m_line_numbers ? QString ("00%1").arg (lines()) : 0);
+    updateTheme();
+}
+
+/*!
+ * Re-applies the settings identified by the given \a {keys}, which were
+ * changed by the user
+ */
 
+void Editor::applySettings (const QList<int> &keys) {
     //
-    // Re-load the current lexer
+    // All the settings are re-applied if the large file mode changes
     //
+    if (keys.contains (SettingsRegistry::LargeFileMode) ||
+            keys.contains (SettingsRegistry::LargeFileSize) ||
+            keys.contains (SettingsRegistry::LargeFileLines)) {
+        if (!isLoading() && updateLargeFileMode (length(), lines())) {
+            updateSettings();
+            return;
+        }
+    }
+
+    if (keys.contains (SettingsRegistry::FontFamily) ||
+            keys.contains (SettingsRegistry::FontSize) ||
+            keys.contains (SettingsRegistry::FontBold) ||
+            keys.contains (SettingsRegistry::FontItalic) ||
+            keys.contains (SettingsRegistry::FontUnderline))
+        updateFont();
+
+    if (keys.contains (SettingsRegistry::ColorScheme))
+        updateTheme();
+
+    if (keys.contains (SettingsRegistry::WordWrap))
+        updateWordWrap();
+
+    if (keys.contains (SettingsRegistry::CaretLine))
+        updateCaretLine();
+
+    if (keys.contains (SettingsRegistry::LineNumbers))
+        updateLineNumberSettings();
+}
+
+/*!
+ * \internal
+ * Applies the saved font to the current lexer
+ */
+
+void Editor::updateFont (void) {
+    loadFont();
+
+    if (lexer() != NULL) {
+        lexer()->setFont (m_font, -1);
+        lexer()->setDefaultFont (m_font);
+    }
+}
+
+/*!
+ * \internal
+ * Reads the saved color scheme, updates the colors of the text editor and
+ * re-loads the lexer with the new colors
+ */
+
+void Editor::updateTheme (void) {
+    theme()->readTheme (settings()->colorScheme());
+    setMarginsBackgroundColor (theme()->lineNumbersBackground());
+    setMarginsForegroundColor (theme()->lineNumbersForeground());
+    setCaretLineBackgroundColor (theme()->currentLineBackground());
+
     updateLexer();
 }
 
+/*!
+ * \internal
+ * Enables or disables word wrapping based on the saved settings, large
+ * files are never wrapped
+ */
+
+void Editor::updateWordWrap (void) {
+    setWordWrap (!m_large_file && settings()->wordWrap());
+    updateBackgroundWork();
+}
+
+/*!
+ * \internal
+ * Shows or hides the caret line based on the saved settings
+ */
+
+void Editor::updateCaretLine (void) {
+    setCaretLineVisible (!m_large_file && settings()->caretLine());
+}
+
+/*!
+ * \internal
+ * Enables or disables the line numbers based on the saved settings
+ */
+
+void Editor::updateLineNumberSettings (void) {
+    m_line_numbers = settings()->lineNumbers();
+    updateLineNumbers();
+}
+
 /*!
  * Saves the current document directly or shows a SaveAs dialog based
  * on the document title.
@@ -298,7 +609,51 @@ bool Editor::saveAs (void) {
  */
 
 void Editor::goToLine (void) {
-    // Todo
+    bool _ok;
+
+    //
+    // Binary files are navigated by offset
+    //
+    if (m_hex_viewer != NULL) {
+        QString _text = QInputDialog::getText (this,
+                                               tr ("Go to offset"),
+                                               tr ("Offset (decimal, or hexadecimal with 0x):"),
+                                               QLineEdit::Normal,
+                                               "0x", &_ok);
+        if (!_ok)
+            return;
+
+        if (!m_hex_viewer->goToOffset (_text.trimmed().toLongLong (&_ok, 0)) || !_ok)
+            QMessageBox::information (this,
+                                      tr ("Go to offset"),
+                                      tr ("The offset %1 is not inside the file.").arg (_text));
+
+        return;
+    }
+
+    int _lines = m_viewer != NULL ? (int) qMin (m_viewer->lineCount(), (qint64) INT_MAX) : lines();
+    int _line = QInputDialog::getInt (this,
+                                      tr ("Go to line"),
+                                      tr ("Line number:"),
+                                      1, 1, _lines, 1, &_ok);
+
+    if (!_ok)
+        return;
+
+    //
+    // Let the viewer load the line
+    //
+    if (m_viewer != NULL) {
+        if (!m_viewer->goToLine (_line - 1))
+            QMessageBox::information (this,
+                                      tr ("Go to line"),
+                                      tr ("The line %1 has not been indexed yet.").arg (_line));
+    }
+
+    else {
+        setCursorPosition (_line - 1, 0);
+        ensureLineVisible (_line - 1);
+    }
 }
 
 /*!
@@ -346,13 +701,11 @@ void Editor::selectFonts (void) {
         // Fonts cannot be saved directly, so we need to save
         // each of the possible values of the font.
         //
-        settings()->setValue ("font-bold", m_font.bold());
-        settings()->setValue ("font-italic", m_font.italic());
-        settings()->setValue ("font-family", m_font.family());
-        settings()->setValue ("font-size", m_font.pointSize());
-        settings()->setValue ("font-underline", m_font.underline());
-
-        emit settingsChanged();
+        settings()->setFontBold (m_font.bold());
+        settings()->setFontItalic (m_font.italic());
+        settings()->setFontFamily (m_font.family());
+        settings()->setFontSize (m_font.pointSize());
+        settings()->setFontUnderline (m_font.underline());
     }
 }
 
@@ -366,98 +719,1258 @@ void Editor::setWordWrap (bool ww) {
 }
 
 /*!
- * Loads the given \a {file} in the text editor
+ * Loads the given \a {file} in the text editor.
+ *
+ * The file is read by a \c FileLoader in a separate thread and each chunk
+ * is appended to the document as soon as it arrives, so the user can read
+ * and scroll the first lines of the document while the rest of the file
+ * is loaded. The document is read-only until the operation finishes.
  */
 
 void Editor::readFile (const QString &file) {
-    qApp->setOverrideCursor (Qt::WaitCursor);
+    if (file.isEmpty())
+        return;
 
-    if (!file.isEmpty()) {
-        QMutex _mutex;
-        QFile _file (file);
+    cancelLoad();
+    closeViewer();
+    closeHexViewer();
+    setFollowMode (false);
 
-        if (_file.open (QIODevice::ReadOnly)) {
-            _mutex.lock();
-            setText (QString::fromUtf8 (_file.readAll()));
-            configureDocument (file);
+    bool _force_text = m_force_text;
+    bool _compressed = CompressionFormat::detectFile (file) != NULL;
 
-            _file.close();
-            _mutex.unlock();
-        }
+    m_force_text = false;
 
-        else {
-            QMessageBox::warning (this,
-                                  tr ("Read error"),
-                                  tr ("Cannot open file \"%1\"!\n%2")
-                                  .arg (file)
-                                  .arg (_file.errorString()));
-        }
+    //
+    // Display binary files in the hex viewer, converting
+    // them to text would damage them
+    //
+    bool _hex_view = settings()->hexViewBinary();
+
+    if (_hex_view && !_force_text && !_compressed && HexViewer::isBinaryFile (file)) {
+        openHexViewer (file);
+        return;
+    }
+
+    //
+    // Do not load huge files into memory, use the viewer instead (the
+    // viewer cannot display compressed files)
+    //
+    qint64 _viewer_size = settings()->viewerModeSize() * MEGABYTE;
+
+    if (QFileInfo (file).size() >= _viewer_size && !_compressed) {
+        openViewer (file);
+        return;
     }
 
-    qApp->restoreOverrideCursor();
+    //
+    // Prepare the editor to receive the file
+    //
+    m_read_only = isReadOnly();
+    m_event_mask = SendScintilla (SCI_GETMODEVENTMASK);
+
+    SendScintilla (SCI_SETMODEVENTMASK, 0UL);
+    SendScintilla (SCI_SETUNDOCOLLECTION, false);
+    SendScintilla (SCI_CLEARALL);
+    SendScintilla (SCI_SETREADONLY, true);
+
+    m_document_title = file;
+    emit updateTitle();
+
+    //
+    // Read the file in another thread
+    //
+    m_loader = new FileLoader (file, this);
+    connect (m_loader, SIGNAL (chunkRead (QByteArray)), this, SLOT (onChunkRead (QByteArray)));
+    connect (m_loader, SIGNAL (restarted()),            this, SLOT (onLoadRestarted()));
+    connect (m_loader, SIGNAL (progress (int)),         this, SIGNAL (loadProgress (int)));
+    connect (m_loader, SIGNAL (finished()),             this, SLOT (onLoadFinished()));
+
+    //
+    // Decide if we should use the large file mode
+    // before appending any text to the editor
+    //
+    if (updateLargeFileMode (QFileInfo (file).size(), 0))
+        updateSettings();
+
+    emit loadStarted();
+    m_loader->start();
 }
 
 /*!
- * Writes the contents of the document in the given \a {file}.
+ * Stops loading the current file (if any).
+ *
+ * The part of the file that was already loaded stays in the editor, but the
+ * document is detached from the file, so that the incomplete document
+ * cannot overwrite the original file by accident.
  */
 
-bool Editor::writeFile (const QString &file) {
-    if (!file.isEmpty()) {
-        QFile _file (file);
-        QMutex _mutex;
+void Editor::cancelLoad (void) {
+    if (m_viewer != NULL) {
+        m_viewer->stopIndexing();
+        m_viewer->stopSearching();
+    }
 
-        if (_file.open (QIODevice::WriteOnly)) {
-            qApp->setOverrideCursor (Qt::WaitCursor);
+    if (m_hex_viewer != NULL)
+        m_hex_viewer->stopSearching();
 
-            _mutex.lock();
-            configureDocument (file);
-            _file.write (text().toUtf8());
-            _file.close();
-            _mutex.unlock();
+    if (m_loader == NULL)
+        return;
 
-            qApp->restoreOverrideCursor();
-            return true;
-        }
+    m_loader->cancel();
+    m_loader->wait();
+    m_loader->deleteLater();
+    m_loader = NULL;
 
-        else {
-            QMessageBox _message;
-            _message.setParent (this);
-            _message.setIcon (QMessageBox::Warning);
-            _message.setWindowTitle (tr ("Write error"));
-            _message.setWindowModality (Qt::WindowModal);
-            _message.setWindowIcon (QIcon (":/icons/dummy.png"));
-            _message.setStandardButtons (QMessageBox::Yes | QMessageBox::No | QMessageBox::Discard);
-            _message.setText ("<b>" + tr ("Cannot write data to file (%1)").arg (_file.errorString()) + "</b>");
-            _message.setInformativeText (
-                tr ("Do you want to save the document under a different name?"));
+    restoreAfterLoad();
 
-            int _return = _message.exec();
+    m_document_title = "";
+    setModified (0);
 
-            if (_return == QMessageBox::Yes)
-                return saveAs();
+    emit updateTitle();
+    emit loadFinished();
+}
 
-            else if (_return == QMessageBox::Discard)
-                return true;
-        }
+/*!
+ * Returns \c {true} if the editor is loading a file
+ */
+
+bool Editor::isLoading (void) const {
+    return m_loader != NULL;
+}
+
+/*!
+ * Returns \c {true} if the document is being written to its file
+ */
+
+bool Editor::isSaving (void) const {
+    return m_saving;
+}
+
+/*!
+ * \internal
+ * Appends the given chunk of the file to the document
+ */
+
+void Editor::onChunkRead (const QByteArray &data) {
+    if (m_loader == NULL || sender() != m_loader)
+        return;
+
+    SendScintilla (SCI_SETREADONLY, false);
+    SendScintilla (SCI_APPENDTEXT, (unsigned long) data.size(), data.constData());
+    SendScintilla (SCI_SETREADONLY, true);
+
+    m_loader->chunkConsumed();
+}
+
+/*!
+ * \internal
+ * Removes the loaded text when the file loader finds out that the file
+ * uses another encoding and starts reading the file again
+ */
+
+void Editor::onLoadRestarted (void) {
+    if (m_loader == NULL || sender() != m_loader)
+        return;
+
+    SendScintilla (SCI_SETREADONLY, false);
+    SendScintilla (SCI_CLEARALL);
+    SendScintilla (SCI_SETREADONLY, true);
+}
+
+/*!
+ * \internal
+ * Restores the state of the editor after the file was loaded
+ * and configures the document for the new file
+ */
+
+void Editor::onLoadFinished (void) {
+    if (m_loader == NULL || sender() != m_loader)
+        return;
+
+    FileLoader *_loader = m_loader;
+    m_loader = NULL;
+
+    restoreAfterLoad();
+
+    if (_loader->errorString().isEmpty()) {
+        m_bom = _loader->hasBom();
+        m_encoding = _loader->encoding();
+        m_compression = _loader->compression();
+        m_file_size = _loader->size();
+        applyFormat (_loader->format());
+
+        if (updateLargeFileMode (length(), lines()))
+            updateSettings();
+
+        configureDocument (_loader->fileName());
     }
 
-    return false;
+    else {
+        m_document_title = "";
+        setModified (0);
+        emit updateTitle();
+
+        QMessageBox::warning (this,
+                              tr ("Read error"),
+                              tr ("Cannot open file \"%1\"!\n%2")
+                              .arg (_loader->fileName())
+                              .arg (_loader->errorString()));
+    }
+
+    _loader->deleteLater();
+    emit loadFinished();
 }
 
 /*!
- * Changes the lexer of the text editor based on its
- * document title.
+ * Replaces all the line endings of the document with the line ending
+ * of the given \a {mode} (a \c QsciScintilla::EolMode value).
+ *
+ * The document is converted in a single pass and replaced at once, so
+ * the operation can be reverted with a single undo step.
  */
 
-void Editor::updateLexer (void) {
-    QsciLexer *_lexer = lexerDatabase()->getLexer (documentTitle(), theme());
+void Editor::convertLineEndings (int mode) {
+    if (isReadOnly() || isLoading() || m_viewer != NULL || m_hex_viewer != NULL)
+        return;
 
-    _lexer->setFont (m_font, -1);
-    _lexer->setDefaultFont (m_font);
+    EolMode _mode = static_cast<EolMode> (mode);
+    setEolMode (_mode);
 
-    setMarginOptions (MoNone);
+    qint64 _length = SendScintilla (SCI_GETLENGTH);
+    const char *_data = static_cast<const char *>
+                        (SendScintillaPtrResult (SCI_GETCHARACTERPOINTER));
 
-    setLexer (_lexer);
+    QByteArray _converted = FormatDetector::convertEols (_data, _length, _mode);
+
+    if (_converted.size() == _length && memcmp (_converted.constData(), _data, _length) == 0)
+        return;
+
+    //
+    // Keep the cursor and the scroll position, the
+    // number of lines does not change
+    //
+    int _line, _index;
+    getCursorPosition (&_line, &_index);
+    int _first_line = firstVisibleLine();
+
+    beginUndoAction();
+    SendScintilla (SCI_SETTARGETSTART, 0UL);
+    SendScintilla (SCI_SETTARGETEND, (unsigned long) _length);
+    SendScintilla (SCI_REPLACETARGET, (unsigned long) _converted.size(), _converted.constData());
+    endUndoAction();
+
+    setCursorPosition (_line, _index);
+    setFirstVisibleLine (_first_line);
+}
+
+/*!
+ * Enables or disables the follow mode.
+ *
+ * In follow mode, the editor watches the document file and appends the
+ * data written at the end of the file without reloading it (like the
+ * \c {tail -f} command). This is useful to monitor log files.
+ */
+
+void Editor::setFollowMode (bool enabled) {
+    if (titleIsShit() || isLoading() || m_viewer != NULL || m_hex_viewer != NULL ||
+        !m_compression.isEmpty())
+        enabled = false;
+
+    if (m_follow == enabled) {
+        emit followModeChanged (m_follow);
+        return;
+    }
+
+    m_follow = enabled;
+
+    delete m_follow_decoder;
+    m_follow_decoder = NULL;
+
+    if (m_follow) {
+        m_follow_max_lines = settings()->followMaxLines();
+
+        //
+        // The journal can no longer use the file as its base
+        //
+        if (m_journal->isActive())
+            startJournal();
+
+        //
+        // The appended data uses the encoding of the file
+        //
+        QTextCodec *_codec = QTextCodec::codecForName (m_encoding);
+        if (m_encoding != "UTF-8" && _codec != NULL)
+            m_follow_decoder = _codec->makeDecoder (QTextCodec::IgnoreHeader);
+
+        followFile();
+        SendScintilla (SCI_SETFIRSTVISIBLELINE, SendScintilla (SCI_VISIBLEFROMDOCLINE, lines()));
+    }
+
+    emit followModeChanged (m_follow);
+}
+
+/*!
+ * Displays the document file in the hex viewer, or as text if \a {enabled}
+ * is set to \c {false}. The file is opened again, so the user is asked to
+ * save the document first.
+ *
+ * Binary files are displayed in the hex viewer automatically, but the user
+ * can still open them as text.
+ */
+
+void Editor::setHexMode (bool enabled) {
+    if (titleIsShit() || (m_hex_viewer != NULL) == enabled) {
+        emit hexModeChanged (m_hex_viewer != NULL);
+        return;
+    }
+
+    if (enabled && (!maybeSave() || titleIsShit())) {
+        emit hexModeChanged (false);
+        return;
+    }
+
+    QString _file = documentTitle();
+
+    if (enabled) {
+        cancelLoad();
+        closeViewer();
+        setFollowMode (false);
+        openHexViewer (_file);
+    }
+
+    else {
+        m_force_text = true;
+        readFile (_file);
+    }
+}
+
+/*!
+ * \internal
+ * Called when the document file is modified by another program.
+ *
+ * In follow mode, only the appended data is read. Otherwise, the file is
+ * read again and compared with the document (unless the change was caused
+ * by the editor itself).
+ */
+
+void Editor::onFileChanged (void) {
+    if (titleIsShit() || isLoading() || m_viewer != NULL || m_hex_viewer != NULL)
+        return;
+
+    //
+    // The document is being written by another thread,
+    // check the file again when the save is finished
+    //
+    if (m_saving) {
+        m_change_pending = true;
+        return;
+    }
+
+    //
+    // Some programs replace the file instead of writing it,
+    // in that case the watcher stops watching the file
+    //
+    QFileInfo _info (m_document_title);
+    if (!m_watcher->files().contains (m_document_title) && _info.exists())
+        m_watcher->addPath (m_document_title);
+
+    if (m_follow) {
+        followFile();
+        return;
+    }
+
+    if (!_info.exists())
+        return;
+
+    if (_info.size() != m_file_size || _info.lastModified() != m_file_modified)
+        reloadFile();
+}
+
+/*!
+ * \internal
+ * Reads the document file in another thread and compares it with a copy
+ * of the document, the result is applied in onReloadFinished().
+ *
+ * Documents that do not fit in a \c QByteArray cannot be copied, so they
+ * are not reloaded.
+ */
+
+void Editor::reloadFile (void) {
+    if (m_saving) {
+        m_change_pending = true;
+        return;
+    }
+
+    if (m_reloader != NULL) {
+        m_reload_pending = true;
+        return;
+    }
+
+    qint64 _length = SendScintilla (SCI_GETLENGTH);
+    const char *_data = static_cast<const char *>
+                        (SendScintillaPtrResult (SCI_GETCHARACTERPOINTER));
+
+    m_reload_pending = false;
+    if (_length > MAX_SNAPSHOT_SIZE)
+        return;
+
+    m_reloader = new FileReloader (m_document_title, QByteArray (_data, (int) _length), this);
+    connect (m_reloader, SIGNAL (finished()), this, SLOT (onReloadFinished()));
+    m_reloader->start();
+}
+
+/*!
+ * \internal
+ * Applies the changes of the document file to the document.
+ *
+ * If the document has unsaved changes, the user is asked if the document
+ * should be reloaded. The reload is registered as a single undo action, so
+ * the previous text can always be recovered.
+ */
+
+void Editor::onReloadFinished (void) {
+    if (m_reloader == NULL || sender() != m_reloader)
+        return;
+
+    FileReloader *_reloader = m_reloader;
+    m_reloader = NULL;
+    _reloader->deleteLater();
+
+    if (!_reloader->errorString().isEmpty() || _reloader->fileName() != m_document_title)
+        return;
+
+    if (m_saving) {
+        m_change_pending = true;
+        return;
+    }
+
+    //
+    // The file or the document changed while the reloader was
+    // working, so we need to compare them again
+    //
+    qint64 _length = SendScintilla (SCI_GETLENGTH);
+    const char *_data = static_cast<const char *>
+                        (SendScintillaPtrResult (SCI_GETCHARACTERPOINTER));
+
+    QByteArray _buffer = _reloader->buffer();
+    if (m_reload_pending || _buffer.size() != _length ||
+        memcmp (_buffer.constData(), _data, _length) != 0) {
+        reloadFile();
+        return;
+    }
+
+    m_file_size = _reloader->fileSize();
+    m_file_modified = _reloader->lastModified();
+
+    //
+    // The changed file can no longer be the base of the journal
+    //
+    if (m_journal->isActive())
+        snapshotJournal();
+
+    QList<TextEdit> _edits = _reloader->edits();
+    if (_edits.isEmpty())
+        return;
+
+    //
+    // Ask the user what to do with the unsaved changes
+    //
+    if (isModified()) {
+        QMessageBox _message;
+        _message.setParent (this);
+        _message.setIcon (QMessageBox::Warning);
+        _message.setWindowTitle (tr ("File changed"));
+        _message.setWindowModality (Qt::WindowModal);
+        _message.setWindowIcon (QIcon (":/icons/dummy.png"));
+        _message.setStandardButtons (QMessageBox::Yes | QMessageBox::No);
+        _message.setDefaultButton (QMessageBox::No);
+        _message.setText ("<b>" + tr ("The file has been modified by another program") + "</b>");
+        _message.setInformativeText (
+            tr ("Do you want to reload the file? You can undo the reload "
+                "to recover your unsaved changes."));
+
+        if (_message.exec() != QMessageBox::Yes)
+            return;
+    }
+
+    m_bom = _reloader->hasBom();
+    m_encoding = _reloader->encoding();
+    m_compression = _reloader->compression();
+
+    applyEdits (_edits);
+    SendScintilla (SCI_SETSAVEPOINT);
+}
+
+/*!
+ * \internal
+ * Applies the given \a {edits} to the document as a single undo action.
+ *
+ * The edits are applied from the last one to the first one, so that the
+ * position of each edit is not affected by the previous edits. Scintilla
+ * moves the cursor, the markers and the folds of the unchanged lines.
+ *
+ * Nothing is done while the document is being saved, because the writer
+ * thread is reading the document buffer.
+ */
+
+void Editor::applyEdits (const QList<TextEdit> &edits) {
+    if (m_saving)
+        return;
+
+    bool _read_only = isReadOnly();
+    SendScintilla (SCI_SETREADONLY, false);
+
+    beginUndoAction();
+
+    for (int i = edits.count() - 1; i >= 0; --i) {
+        const TextEdit &_edit = edits.at (i);
+
+        SendScintilla (SCI_SETTARGETSTART, (unsigned long) _edit.position);
+        SendScintilla (SCI_SETTARGETEND, (unsigned long) (_edit.position + _edit.length));
+        SendScintilla (SCI_REPLACETARGET, (unsigned long) _edit.text.size(), _edit.text.constData());
+    }
+
+    endUndoAction();
+
+    SendScintilla (SCI_SETREADONLY, _read_only);
+}
+
+/*!
+ * \internal
+ * Starts the journal when the document is modified, and discards it when
+ * the document is saved
+ */
+
+void Editor::onModificationChanged (bool modified) {
+    if (!m_journal_enabled || m_viewer != NULL || m_hex_viewer != NULL)
+        return;
+
+    if (modified)
+        startJournal();
+
+    else
+        m_journal->discard();
+}
+
+/*!
+ * \internal
+ * Records the insertions and deletions of text in the journal, this only
+ * copies the change to a memory buffer (the journal file is written by
+ * another thread)
+ */
+
+void Editor::onModified (int position, int type, const char *text, int length,
+                         int lines_added, int line, int fold_now, int fold_prev,
+                         int token, int annotation_lines) {
+    Q_UNUSED (line);
+    Q_UNUSED (token);
+    Q_UNUSED (fold_now);
+    Q_UNUSED (fold_prev);
+    Q_UNUSED (lines_added);
+    Q_UNUSED (annotation_lines);
+
+    //
+    // Remember that the document is being changed, see startJournal(),
+    // and remove the lines that will change from the statistics
+    //
+    if (type & (SC_MOD_BEFOREINSERT | SC_MOD_BEFOREDELETE)) {
+        m_changing = true;
+        updateStatistics (position, (type & SC_MOD_BEFOREDELETE) ? length : 0, false);
+        return;
+    }
+
+    if (!(type & (SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT)))
+        return;
+
+    updateStatistics (position, (type & SC_MOD_INSERTTEXT) ? length : 0, true);
+
+    bool _skip = m_journal_skip_change;
+    m_journal_skip_change = false;
+    m_changing = false;
+
+    //
+    // The change is already included in the snapshot
+    //
+    if (!m_journal->isActive() || _skip)
+        return;
+
+    if (type & SC_MOD_INSERTTEXT)
+        m_journal->recordInsert (position, text, length);
+
+    else if (type & SC_MOD_DELETETEXT)
+        m_journal->recordDelete (position, length);
+}
+
+/*!
+ * \internal
+ * Counts the words, lines and characters of the whole document, this is
+ * only needed when the document was changed without notifications
+ */
+
+void Editor::recountStatistics (void) {
+    qint64 _length = SendScintilla (SCI_GETLENGTH);
+    const char *_data = static_cast<const char *>
+                        (SendScintillaPtrResult (SCI_GETCHARACTERPOINTER));
+
+    m_stats.clear();
+    m_stats.add (_data, _length);
+}
+
+/*!
+ * \internal
+ * Adds (or removes, if \a {add} is \c {false}) the statistics of the lines
+ * around the range of \a {length} bytes that starts at \a {position}.
+ *
+ * The range is extended from the line before the \a {position} (which may
+ * end with a CR that is joined with a LF) to the end of the last line of
+ * the range. Before and after a change, this covers the same unchanged
+ * text around the change, so removing the lines before the change and
+ * adding them after the change keeps the statistics exact.
+ */
+
+void Editor::updateStatistics (long position, long length, bool add) {
+    long _first = SendScintilla (SCI_LINEFROMPOSITION, (unsigned long) qMax (0L, position - 1));
+    long _last = SendScintilla (SCI_LINEFROMPOSITION, (unsigned long) (position + length));
+
+    long _start = SendScintilla (SCI_POSITIONFROMLINE, (unsigned long) _first);
+    long _end = _last + 1 < SendScintilla (SCI_GETLINECOUNT) ?
+                SendScintilla (SCI_POSITIONFROMLINE, (unsigned long) (_last + 1)) :
+                SendScintilla (SCI_GETLENGTH);
+
+    if (_end <= _start)
+        return;
+
+    QByteArray _text ((int) (_end - _start), 0);
+    SendScintilla (SCI_GETTEXTRANGE, _start, _end, _text.data());
+
+    if (add)
+        m_stats.add (_text.constData(), _text.size());
+    else
+        m_stats.remove (_text.constData(), _text.size());
+}
+
+/*!
+ * \internal
+ * Replaces the journal with a snapshot of the document when it has too
+ * many records, so that it can be replayed quickly.
+ *
+ * Copying the document would pause the editor when the document is
+ * larger than the large file threshold, so those journals are never
+ * compacted (they are replayed from their base instead).
+ */
+
+void Editor::compactJournal (void) {
+    if (!m_journal->isActive() || m_journal->recordsSinceSnapshot() < JOURNAL_COMPACT_RECORDS)
+        return;
+
+    if (SendScintilla (SCI_GETLENGTH) >= settings()->largeFileSize() * MEGABYTE)
+        return;
+
+    snapshotJournal();
+}
+
+/*!
+ * \internal
+ * Replaces the journal with a snapshot of the document, documents that do
+ * not fit in a \c QByteArray are not copied
+ */
+
+void Editor::snapshotJournal (void) {
+    qint64 _length = SendScintilla (SCI_GETLENGTH);
+    if (_length > MAX_SNAPSHOT_SIZE)
+        return;
+
+    const char *_data = static_cast<const char *>
+                        (SendScintillaPtrResult (SCI_GETCHARACTERPOINTER));
+
+    m_journal->writeSnapshot (QByteArray (_data, (int) _length));
+}
+
+/*!
+ * \internal
+ * Starts the journal of the document, the base of the journal is the
+ * document file or (for new documents) a snapshot of the document.
+ *
+ * When the user types, Scintilla reports that the document was modified
+ * after changing the text but before notifying the change, in that case
+ * the snapshot already contains the change and it must not be recorded.
+ * New documents that do not fit in a \c QByteArray have no journal.
+ *
+ * Followed files keep growing (and their first lines may be trimmed), so
+ * they can never be used as the base of the journal.
+ */
+
+void Editor::startJournal (void) {
+    if (!titleIsShit() && !m_follow && QFileInfo (m_document_title).exists()) {
+        m_journal->start (m_document_title, m_encoding, m_file_size, m_file_modified);
+        return;
+    }
+
+    qint64 _length = SendScintilla (SCI_GETLENGTH);
+    const char *_data = static_cast<const char *>
+                        (SendScintillaPtrResult (SCI_GETCHARACTERPOINTER));
+
+    if (_length > MAX_SNAPSHOT_SIZE)
+        return;
+
+    m_journal_skip_change = m_changing;
+    m_journal->start (m_document_title, m_encoding, QByteArray (_data, (int) _length));
+}
+
+/*!
+ * \internal
+ * Watches the given \a {file} for changes made by other programs
+ */
+
+void Editor::watchFile (const QString &file) {
+    if (!m_watcher->files().isEmpty())
+        m_watcher->removePaths (m_watcher->files());
+
+    QFileInfo _info (file);
+    m_file_modified = _info.lastModified();
+
+    if (!file.isEmpty() && _info.exists())
+        m_watcher->addPath (file);
+}
+
+/*!
+ * \internal
+ * Returns \c {true} if the document file has exactly the same bytes as
+ * the document (whose size is \a {length}), which is the case when the
+ * document was not changed since the file was read or written and the
+ * file uses UTF-8 without a BOM and without compression
+ */
+
+bool Editor::matchesFile (qint64 length) {
+    if (titleIsShit() || isModified() || isLoading() || m_bom ||
+        m_encoding != "UTF-8" || !m_compression.isEmpty())
+        return false;
+
+    QFileInfo _info (m_document_title);
+    return _info.size() == length && _info.lastModified() == m_file_modified;
+}
+
+/*!
+ * \internal
+ * Reads the data that was appended to the document file since the last
+ * time that the file was read, at most \c FOLLOW_CHUNK_SIZE bytes are read
+ * at once (the rest is read in the next iterations of the event loop).
+ */
+
+void Editor::followFile (void) {
+    if (!m_follow)
+        return;
+
+    if (m_saving) {
+        m_change_pending = true;
+        return;
+    }
+
+    QFile _file (m_document_title);
+    if (!_file.open (QIODevice::ReadOnly))
+        return;
+
+    //
+    // The file was truncated (e.g. by a log rotation), so
+    // we need to read it again from the start
+    //
+    qint64 _size = _file.size();
+    if (_size < m_file_size) {
+        bool _read_only = isReadOnly();
+
+        SendScintilla (SCI_SETREADONLY, false);
+        SendScintilla (SCI_SETUNDOCOLLECTION, false);
+        SendScintilla (SCI_CLEARALL);
+        SendScintilla (SCI_EMPTYUNDOBUFFER);
+        SendScintilla (SCI_SETUNDOCOLLECTION, true);
+        SendScintilla (SCI_SETREADONLY, _read_only);
+
+        setModified (0);
+        m_file_size = 0;
+    }
+
+    if (_size == m_file_size || !_file.seek (m_file_size))
+        return;
+
+    QByteArray _data = _file.read (qMin (_size - m_file_size, (qint64) FOLLOW_CHUNK_SIZE));
+    m_file_size += _data.size();
+    m_file_modified = QFileInfo (_file).lastModified();
+
+    if (m_follow_decoder != NULL)
+        _data = m_follow_decoder->toUnicode (_data).toUtf8();
+
+    appendFollowedText (_data);
+
+    if (m_file_size < _size)
+        QTimer::singleShot (0, this, SLOT (followFile()));
+}
+
+/*!
+ * \internal
+ * Appends the given \a {data} to the document without registering an undo
+ * action and without marking the document as modified.
+ *
+ * If the user is looking at the end of the document, the editor scrolls
+ * to show the new lines, otherwise the scroll position is not changed.
+ * Nothing is appended while the document is being saved.
+ */
+
+void Editor::appendFollowedText (const QByteArray &data) {
+    if (data.isEmpty() || m_saving)
+        return;
+
+    bool _modified = isModified();
+    bool _read_only = isReadOnly();
+    bool _at_end = verticalScrollBar()->value() >= verticalScrollBar()->maximum();
+
+    SendScintilla (SCI_SETREADONLY, false);
+    SendScintilla (SCI_SETUNDOCOLLECTION, false);
+    SendScintilla (SCI_APPENDTEXT, (unsigned long) data.size(), data.constData());
+    SendScintilla (SCI_SETUNDOCOLLECTION, true);
+    SendScintilla (SCI_SETREADONLY, _read_only);
+
+    trimFollowedLines();
+
+    if (!_modified)
+        SendScintilla (SCI_SETSAVEPOINT);
+
+    if (_at_end)
+        SendScintilla (SCI_SETFIRSTVISIBLELINE, SendScintilla (SCI_VISIBLEFROMDOCLINE, lines()));
+
+    if (updateLargeFileMode (length(), lines()))
+        updateSettings();
+}
+
+/*!
+ * \internal
+ * Removes the first lines of the document when it has more lines than
+ * the limit set by the user, so that the memory used by the document
+ * does not grow forever while following a file.
+ *
+ * The undo history is cleared, because the removed text would change the
+ * position of every undo action.
+ */
+
+void Editor::trimFollowedLines (void) {
+    if (m_follow_max_lines <= 0 || lines() <= m_follow_max_lines)
+        return;
+
+    bool _read_only = isReadOnly();
+    long _end = SendScintilla (SCI_POSITIONFROMLINE, lines() - m_follow_max_lines);
+
+    SendScintilla (SCI_SETREADONLY, false);
+    SendScintilla (SCI_SETUNDOCOLLECTION, false);
+    SendScintilla (SCI_DELETERANGE, 0UL, _end);
+    SendScintilla (SCI_EMPTYUNDOBUFFER);
+    SendScintilla (SCI_SETUNDOCOLLECTION, true);
+    SendScintilla (SCI_SETREADONLY, _read_only);
+}
+
+/*!
+ * \internal
+ * Displays the given \a {file} with a read-only \c FileViewer, which only
+ * keeps a small part of the file in memory
+ */
+
+void Editor::openViewer (const QString &file) {
+    m_viewer = new FileViewer (file, this);
+    connect (m_viewer, SIGNAL (indexProgress (int)), this, SIGNAL (loadProgress (int)));
+    connect (m_viewer, SIGNAL (indexFinished()),     this, SIGNAL (loadFinished()));
+    connect (m_viewer, SIGNAL (searchStarted()),     this, SIGNAL (loadStarted()));
+    connect (m_viewer, SIGNAL (searchProgress (int)), this, SIGNAL (loadProgress (int)));
+    connect (m_viewer, SIGNAL (searchFinished()),    this, SIGNAL (loadFinished()));
+
+    if (updateLargeFileMode (QFileInfo (file).size(), 0))
+        updateSettings();
+
+    if (!m_viewer->open()) {
+        QMessageBox::warning (this,
+                              tr ("Read error"),
+                              tr ("Cannot open file \"%1\"!\n%2")
+                              .arg (file)
+                              .arg (m_viewer->errorString()));
+
+        closeViewer();
+        return;
+    }
+
+    configureDocument (file);
+    emit loadStarted();
+}
+
+/*!
+ * \internal
+ * Destroys the current \c FileViewer (if any) and makes the
+ * document editable again
+ */
+
+void Editor::closeViewer (void) {
+    if (m_viewer == NULL)
+        return;
+
+    delete m_viewer;
+    m_viewer = NULL;
+
+    SendScintilla (SCI_SETREADONLY, false);
+    SendScintilla (SCI_SETUNDOCOLLECTION, true);
+    SendScintilla (SCI_CLEARALL);
+    SendScintilla (SCI_EMPTYUNDOBUFFER);
+}
+
+/*!
+ * \internal
+ * Displays the given (binary) \a {file} with a read-only \c HexViewer
+ */
+
+void Editor::openHexViewer (const QString &file) {
+    m_hex_viewer = new HexViewer (file, this);
+    connect (m_hex_viewer, SIGNAL (searchStarted()),     this, SIGNAL (loadStarted()));
+    connect (m_hex_viewer, SIGNAL (searchProgress (int)), this, SIGNAL (loadProgress (int)));
+    connect (m_hex_viewer, SIGNAL (searchFinished()),    this, SIGNAL (loadFinished()));
+
+    if (updateLargeFileMode (QFileInfo (file).size(), 0))
+        updateSettings();
+
+    if (!m_hex_viewer->open()) {
+        QMessageBox::warning (this,
+                              tr ("Read error"),
+                              tr ("Cannot open file \"%1\"!\n%2")
+                              .arg (file)
+                              .arg (m_hex_viewer->errorString()));
+
+        closeHexViewer();
+        return;
+    }
+
+    configureDocument (file);
+    emit hexModeChanged (true);
+}
+
+/*!
+ * \internal
+ * Destroys the current \c HexViewer (if any) and makes the document
+ * editable again
+ */
+
+void Editor::closeHexViewer (void) {
+    if (m_hex_viewer == NULL)
+        return;
+
+    delete m_hex_viewer;
+    m_hex_viewer = NULL;
+
+    SendScintilla (SCI_SETREADONLY, false);
+    SendScintilla (SCI_SETUNDOCOLLECTION, true);
+    SendScintilla (SCI_CLEARALL);
+    SendScintilla (SCI_EMPTYUNDOBUFFER);
+
+    emit hexModeChanged (false);
+}
+
+/*!
+ * \internal
+ * Re-enables the features that were disabled while loading a file
+ */
+
+void Editor::restoreAfterLoad (void) {
+    SendScintilla (SCI_SETREADONLY, m_read_only);
+    SendScintilla (SCI_SETUNDOCOLLECTION, true);
+    SendScintilla (SCI_EMPTYUNDOBUFFER);
+    SendScintilla (SCI_SETMODEVENTMASK, (unsigned long) m_event_mask);
+
+    //
+    // The loaded text was not reported to the statistics
+    //
+    recountStatistics();
+
+    emit textChanged();
+}
+
+/*!
+ * \internal
+ * Configures the EOL mode and the indentation of the editor to match
+ * the line endings and indentation detected in the loaded file
+ */
+
+void Editor::applyFormat (const FormatDetector &format) {
+    setEolMode (format.eolMode (eolMode()));
+
+    if (format.hasIndentation()) {
+        setIndentationsUseTabs (format.indentationUsesTabs());
+
+        if (!format.indentationUsesTabs() && format.indentationWidth() > 0)
+            setIndentationWidth (format.indentationWidth());
+    }
+}
+
+/*!
+ * Writes the contents of the document in the given \a {file}.
+ *
+ * The data is written directly from the buffer of Scintilla (without
+ * creating any copies of the document) to a temporary file, which replaces
+ * the original file once all the data has been written. Large documents
+ * are written in a separate thread.
+ */
+
+bool Editor::writeFile (const QString &file) {
+    //
+    // The viewers only have a part of the file in memory
+    //
+    if (m_viewer != NULL || m_hex_viewer != NULL) {
+        QMessageBox::information (this,
+                                  tr ("Write error"),
+                                  tr ("Documents opened in viewer mode cannot be saved."));
+        return false;
+    }
+
+    //
+    // The window may be closed (and the document saved again) while a
+    // large document is written, never write the same document twice
+    //
+    if (m_saving)
+        return false;
+
+    if (!file.isEmpty() && !isLoading()) {
+        qApp->setOverrideCursor (Qt::WaitCursor);
+
+        //
+        // Get a pointer to the document buffer and ensure that
+        // the buffer is not modified while we write it, the file
+        // watcher and the reloader wait until the save is finished
+        //
+        bool _read_only = isReadOnly();
+        SendScintilla (SCI_SETREADONLY, true);
+        m_saving = true;
+
+        qint64 _length = SendScintilla (SCI_GETLENGTH);
+        const char *_data = static_cast<const char *>
+                            (SendScintillaPtrResult (SCI_GETCHARACTERPOINTER));
+
+        //
+        // Keep the compression of the file, or use the
+        // compression given by the suffix of a new file
+        //
+        QString _compression = m_compression;
+
+        if (file != m_document_title) {
+            CompressionFormat *_format = CompressionFormat::findBySuffix (file);
+            _compression = _format != NULL ? _format->name() : QString();
+        }
+
+        FileWriter _writer (file, _data, _length);
+        _writer.setEncoding (m_encoding, m_bom);
+        _writer.setCompression (_compression);
+        _writer.setSyncDirectory (settings()->saveFsync());
+
+        //
+        // Write small documents directly, use a separate thread
+        // for large documents and keep painting the window meanwhile
+        //
+        if (_length < ASYNC_SAVE_THRESHOLD)
+            _writer.write();
+
+        else {
+            QEventLoop _loop;
+            connect (&_writer, SIGNAL (finished()), &_loop, SLOT (quit()));
+
+            _writer.start();
+            _loop.exec (QEventLoop::ExcludeUserInputEvents);
+            _writer.wait();
+        }
+
+        m_saving = false;
+        SendScintilla (SCI_SETREADONLY, _read_only);
+        qApp->restoreOverrideCursor();
+
+        if (_writer.succeeded()) {
+            m_compression = _compression;
+            m_file_size = QFileInfo (file).size();
+            configureDocument (file);
+        }
+
+        //
+        // Check the changes of the file that were ignored
+        // while the document was being written
+        //
+        if (m_change_pending) {
+            m_change_pending = false;
+            QTimer::singleShot (0, this, SLOT (onFileChanged()));
+        }
+
+        if (_writer.succeeded())
+            return true;
+
+        else {
+            QMessageBox _message;
+            _message.setParent (this);
+            _message.setIcon (QMessageBox::Warning);
+            _message.setWindowTitle (tr ("Write error"));
+            _message.setWindowModality (Qt::WindowModal);
+            _message.setWindowIcon (QIcon (":/icons/dummy.png"));
+            _message.setStandardButtons (QMessageBox::Yes | QMessageBox::No | QMessageBox::Discard);
+            _message.setText ("<b>" + tr ("Cannot write data to file (%1)").arg (_writer.errorString()) + "</b>");
+            _message.setInformativeText (
+                tr ("Do you want to save the document under a different name?"));
+
+            int _return = _message.exec();
+
+            if (_return == QMessageBox::Yes)
+                return saveAs();
+
+            else if (_return == QMessageBox::Discard)
+                return true;
+        }
+    }
+
+    return false;
+}
+
+/*!
+ * \internal
+ * Enables or disables the large file mode for a document of the given
+ * \a {size} (in bytes) and number of \a {lines}, based on the limits
+ * defined by the user.
+ *
+ * Returns \c {true} if the mode was changed.
+ */
+
+bool Editor::updateLargeFileMode (qint64 size, int lines) {
+    bool _enabled = settings()->largeFileMode();
+    qint64 _max_size = settings()->largeFileSize() * MEGABYTE;
+    int _max_lines = settings()->largeFileLines();
+
+    bool _large_file = m_viewer != NULL || m_hex_viewer != NULL ||
+                       (_enabled && (size >= _max_size || lines >= _max_lines));
+
+    if (_large_file != m_large_file) {
+        m_large_file = _large_file;
+        emit largeFileModeChanged (m_large_file);
+        return true;
+    }
+
+    return false;
+}
+
+/*!
+ * \internal
+ * Reads the saved font, fonts cannot be saved directly so each of its
+ * properties is saved separately
+ */
+
+void Editor::loadFont (void) {
+    m_font.setBold (settings()->fontBold());
+    m_font.setItalic (settings()->fontItalic());
+    m_font.setUnderline (settings()->fontUnderline());
+    m_font.setPointSize (settings()->fontSize());
+    m_font.setFamily (settings()->fontFamily());
+}
+
+/*!
+ * Changes the lexer of the text editor based on its
+ * document title.
+ */
+
+void Editor::updateLexer (void) {
+    //
+    // Configure the background styling before the new lexer asks
+    // Scintilla to style the document again
+    //
+    updateBackgroundWork();
+
+    //
+    // Use the plain text lexer for large files
+    //
+    QString _name = m_large_file ? QString ("") : documentTitle();
+
+    //
+    // Use the lexer of the compressed file (e.g. "main.c.gz")
+    //
+    CompressionFormat *_format = CompressionFormat::find (m_compression);
+    if (_format != NULL && _name.endsWith ("." + _format->suffix(), Qt::CaseInsensitive))
+        _name.chop (_format->suffix().length() + 1);
+
+    //
+    // Give the start of the document to the database, it is used to
+    // guess the language of files without a known name or extension
+    //
+    QByteArray _head;
+    if (!m_large_file) {
+        long _length = qMin ((long) SendScintilla (SCI_GETLENGTH),
+                             (long) LANGUAGE_SAMPLE_SIZE);
+        _head.resize ((int) _length);
+        SendScintilla (SCI_GETTEXTRANGE, 0L, _length, _head.data());
+    }
+
+    //
+    // Keep the current lexer if the language did not change, we only
+    // need to update its colors and fonts
+    //
+    QsciLexer *_current = lexer();
+    QString _language = lexerDatabase()->languageForFile (_name, _head);
+    if (_current != NULL && lexerDatabase()->languageOf (_current) == _language) {
+        lexerDatabase()->applyTheme (_current, theme());
+        _current->setFont (m_font, -1);
+        _current->setDefaultFont (m_font);
+
+        setLexer (_current);
+        return;
+    }
+
+    QsciLexer *_lexer = lexerDatabase()->lexerForLanguage (_language, theme(), this);
+
+    _lexer->setFont (m_font, -1);
+    _lexer->setDefaultFont (m_font);
+
+    setMarginOptions (MoNone);
+
+    setLexer (_lexer);
+
+    //
+    // Destroy the previous lexer, it is not used by anyone else
+    //
+    if (_current != NULL)
+        _current->deleteLater();
+}
+
+/*!
+ * \internal
+ * Configures how Scintilla styles, lays out and wraps the document, so
+ * that the cost of scrolling and typing does not depend on its size.
+ *
+ * Only the visible lines are styled and wrapped when they are painted,
+ * Scintilla processes the rest of the document in short slices while the
+ * application is idle, and any user input is handled before the next
+ * slice. In detail:
+ *
+ * - Documents bigger than \c IDLE_STYLING_SIZE are styled in the
+ *   background (before and after the visible lines), instead of styling
+ *   everything up to the visible lines at once
+ * - The layout of every line is cached for documents smaller than
+ *   \c DOCUMENT_CACHE_SIZE, only the visible page is cached for bigger
+ *   documents and only the caret line in large file mode
+ * - A bigger position cache is used while word wrap is enabled, so that
+ *   the background wrapping measures each text segment only once
+ */
+
+void Editor::updateBackgroundWork (void) {
+    long _length = SendScintilla (SCI_GETLENGTH);
+
+    int _cache = SC_CACHE_PAGE;
+    if (m_large_file)
+        _cache = SC_CACHE_CARET;
+
+    else if (_length < DOCUMENT_CACHE_SIZE)
+        _cache = SC_CACHE_DOCUMENT;
+
+    SendScintilla (SCI_SETLAYOUTCACHE, _cache);
+    SendScintilla (SCI_SETPOSITIONCACHE, wrapMode() == WrapNone ?
+                   DEFAULT_POSITION_CACHE : WRAP_POSITION_CACHE);
+
+#if QSCINTILLA_VERSION >= 0x020a00
+    SendScintilla (SCI_SETIDLESTYLING, _length > IDLE_STYLING_SIZE ?
+                   SC_IDLESTYLING_ALL : SC_IDLESTYLING_NONE);
+#endif
 }
 
 /*!
@@ -490,6 +2003,7 @@ void Editor::onMarginClicked (void) {
 
 void Editor::configureDocument (const QString &file) {
     m_document_title = file;
+    watchFile (file);
 
     updateLexer();
     setModified (0);
@@ -500,8 +2014,8 @@ void Editor::configureDocument (const QString &file) {
  * Allows the class to access the application settings
  */
 
-QSettings *Editor::settings (void) const {
-    return new QSettings (APP_COMPANY, APP_NAME);
+SettingsRegistry *Editor::settings (void) const {
+    return SettingsRegistry::instance();
 }
 
 /*!
@@ -517,5 +2031,5 @@ Theme *Editor::theme (void) {
  */
 
 LexerDatabase *Editor::lexerDatabase (void) const {
-    return new LexerDatabase();
+    return LexerDatabase::instance();
 }
@@ -27,32 +27,66 @@ extern "C++" {
 #endif
 
 class Theme;
-class QSettings;
+struct TextEdit;
+class QTextDecoder;
+class SettingsRegistry;
+class FileLoader;
+class FileViewer;
+class HexViewer;
+class FileReloader;
+class EditJournal;
+class FormatDetector;
 class LexerDatabase;
+class QFileSystemWatcher;
 
+#include <QDateTime>
 #include <Qsci/qsciscintilla.h>
 
+#include "document_stats.h"
+
 class Editor : public QsciScintilla {
         Q_OBJECT
 
     public:
         explicit Editor (QWidget *parent = 0);
+        ~Editor (void);
 
         bool maybeSave (void);
+        bool isLoading (void) const;
+        bool isSaving (void) const;
+        bool isLargeFile (void) const;
+        bool isFollowing (void) const;
+        FileViewer *viewer (void) const;
+        HexViewer *hexViewer (void) const;
         int wordCount (void);
+        qint64 characterCount (void) const;
         bool titleIsShit (void);
         QString calculateSize (void);
+        QString encoding (void) const;
+        bool hasBom (void) const;
+        QString compression (void) const;
         QString documentTitle (void) const;
 
+        void discardJournal (void);
+        void recoverDocument (const QString &file,
+                              const QByteArray &encoding,
+                              const QByteArray &text);
+
     signals:
         void updateTitle (void);
-        void settingsChanged (void);
+        void loadStarted (void);
+        void loadFinished (void);
+        void loadProgress (int percent);
+        void largeFileModeChanged (bool enabled);
+        void followModeChanged (bool enabled);
+        void hexModeChanged (bool enabled);
 
     public slots:
         void exportPdf (void);
         void resetZoom (void);
         void documentInfo (void);
         void updateSettings (void);
+        void applySettings (const QList<int> &keys);
         bool save (void);
         bool saveAs (void);
         void goToLine (void);
@@ -63,21 +97,86 @@ class Editor : public QsciScintilla {
         void setWordWrap (bool ww);
         void readFile (const QString &file);
         bool writeFile (const QString &file);
+        void cancelLoad (void);
+        void convertLineEndings (int mode);
+        void setFollowMode (bool enabled);
+        void setHexMode (bool enabled);
 
     private slots:
         void updateLexer (void);
         void updateLineNumbers (void);
         void onMarginClicked (void);
         void configureDocument (const QString &file);
+        void onChunkRead (const QByteArray &data);
+        void onLoadRestarted (void);
+        void onLoadFinished (void);
+        void onFileChanged (void);
+        void followFile (void);
+        void reloadFile (void);
+        void onReloadFinished (void);
+        void onModificationChanged (bool modified);
+        void onModified (int position, int type, const char *text, int length,
+                         int lines_added, int line, int fold_now, int fold_prev,
+                         int token, int annotation_lines);
+        void compactJournal (void);
 
     private:
+        void restoreAfterLoad (void);
+        void applyFormat (const FormatDetector &format);
+        void appendFollowedText (const QByteArray &data);
+        void trimFollowedLines (void);
+        void watchFile (const QString &file);
+        bool matchesFile (qint64 length);
+        void applyEdits (const QList<TextEdit> &edits);
+        void startJournal (void);
+        void snapshotJournal (void);
+        void recountStatistics (void);
+        void updateStatistics (long position, long length, bool add);
+        void openViewer (const QString &file);
+        void closeViewer (void);
+        void openHexViewer (const QString &file);
+        void closeHexViewer (void);
+        bool updateLargeFileMode (qint64 size, int lines);
+        void loadFont (void);
+        void updateFont (void);
+        void updateTheme (void);
+        void updateWordWrap (void);
+        void updateCaretLine (void);
+        void updateLineNumberSettings (void);
+        void updateBackgroundWork (void);
+
         Theme *theme (void);
-        QSettings *settings (void) const;
+        SettingsRegistry *settings (void) const;
         LexerDatabase *lexerDatabase (void) const;
 
         QFont m_font;
         Theme *m_theme;
+        bool m_read_only;
+        bool m_large_file;
+        bool m_bom;
+        QByteArray m_encoding;
+        QString m_compression;
+        bool m_follow;
+        qint64 m_file_size;
+        int m_follow_max_lines;
+        QTextDecoder *m_follow_decoder;
+        QFileSystemWatcher *m_watcher;
+        FileReloader *m_reloader;
+        bool m_reload_pending;
+        bool m_saving;
+        bool m_change_pending;
+        QDateTime m_file_modified;
+        EditJournal *m_journal;
+        bool m_journal_enabled;
+        bool m_journal_skip_change;
+        bool m_changing;
+        DocumentStats m_stats;
+        long m_event_mask;
         bool m_line_numbers;
+        FileLoader *m_loader;
+        FileViewer *m_viewer;
+        HexViewer *m_hex_viewer;
+        bool m_force_text;
         QString m_document_title;
 };
 
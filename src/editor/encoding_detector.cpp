@@ -0,0 +1,359 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <string.h>
+#include <QTextCodec>
+#include <QTextDecoder>
+
+#include "encoding_detector.h"
+
+#define SAMPLE_SIZE 4096
+#define WIDE_ZERO_RATIO 0.7
+#define WIDE_NONZERO_RATIO 0.1
+#define BINARY_CONTROL_RATIO 0.1
+
+/*!
+ * \class EncodingDetector
+ * \brief Detects the encoding of a file and converts it to UTF-8
+ *
+ * The \c EncodingDetector is used by the \c FileLoader to find the encoding
+ * of a file while it is being read, without doing an extra pass over the
+ * data:
+ *
+ * - The first chunk is checked for a byte order mark (BOM)
+ * - If there is no BOM, the distribution of zero bytes in the first
+ *   \c SAMPLE_SIZE bytes is used to detect UTF-16 and UTF-32 files
+ * - Otherwise, the file is assumed to be UTF-8 and each chunk is validated
+ *   with the \c Utf8Validator. If the validation fails, the detector
+ *   switches to the fallback (legacy) encoding.
+ *
+ * UTF-8 chunks are returned without copying them, other encodings are
+ * converted to UTF-8 (which is the encoding used by the editor).
+ */
+
+/*!
+ * \internal
+ * Initializes the detector
+ */
+
+EncodingDetector::EncodingDetector (void) : m_decoder (NULL) {
+    reset();
+}
+
+/*!
+ * \internal
+ * Deletes the text decoder (if any)
+ */
+
+EncodingDetector::~EncodingDetector (void) {
+    delete m_decoder;
+}
+
+/*!
+ * Prepares the detector to read a new file
+ */
+
+void EncodingDetector::reset (void) {
+    m_bom = false;
+    m_first = true;
+    m_forced = false;
+    m_validator.reset();
+    setEncoding ("UTF-8");
+}
+
+/*!
+ * Returns \c {true} if the file starts with a byte order mark
+ */
+
+bool EncodingDetector::hasBom (void) const {
+    return m_bom;
+}
+
+/*!
+ * Returns the name of the detected encoding
+ */
+
+QByteArray EncodingDetector::encoding (void) const {
+    return m_encoding;
+}
+
+/*!
+ * Converts the given chunk of \a {data} to UTF-8 and writes the result in
+ * \a {output}. The chunks must be given in the same order as the file.
+ *
+ * Returns \c {false} if the file must be read again from the start, this
+ * happens when the file looked like UTF-8 until an invalid sequence was
+ * found. In that case, the detector switches to the fallback encoding and
+ * the caller should clear the document and give the chunks again.
+ */
+
+bool EncodingDetector::convert (const QByteArray &data, QByteArray *output) {
+    Q_ASSERT (output != NULL);
+
+    QByteArray _data = data;
+
+    //
+    // Detect the encoding with the first chunk, unless the encoding
+    // was forced after a failed UTF-8 validation
+    //
+    if (m_first && !m_forced) {
+        int _bom_length = 0;
+        QByteArray _encoding = detectBom (data.constData(), data.size(), &_bom_length);
+
+        m_first = false;
+
+        if (!_encoding.isEmpty()) {
+            m_bom = true;
+            _data = data.mid (_bom_length);
+            setEncoding (_encoding);
+        }
+
+        else {
+            _encoding = detectWideEncoding (data.constData(), data.size());
+            setEncoding (_encoding.isEmpty() ? QByteArray ("UTF-8") : _encoding);
+        }
+    }
+
+    //
+    // Validate UTF-8 data, no conversion is needed
+    //
+    if (m_decoder == NULL) {
+        bool _was_ascii = m_validator.isAscii();
+
+        if (m_validator.feed (_data.constData(), _data.size())) {
+            *output = _data;
+            return true;
+        }
+
+        //
+        // The data that was given to the editor is not affected by the
+        // new encoding, so we can continue with the next chunk
+        //
+        setEncoding (fallbackEncoding());
+
+        if (!_was_ascii || m_bom) {
+            m_bom = false;
+            m_forced = true;
+            return false;
+        }
+    }
+
+    *output = m_decoder->toUnicode (_data).toUtf8();
+    return true;
+}
+
+/*!
+ * Must be called after the last chunk, returns \c {false} if the file must
+ * be read again (e.g. the file ends with an incomplete UTF-8 sequence).
+ */
+
+bool EncodingDetector::finish (void) {
+    if (m_decoder != NULL || m_validator.finish())
+        return true;
+
+    setEncoding (fallbackEncoding());
+
+    m_bom = false;
+    m_forced = true;
+    return false;
+}
+
+/*!
+ * Returns the byte order mark used by the given \a {encoding}, the returned
+ * array is empty for encodings that do not have a BOM
+ */
+
+QByteArray EncodingDetector::bom (const QByteArray &encoding) {
+    if (encoding == "UTF-8")
+        return QByteArray ("\xEF\xBB\xBF", 3);
+
+    else if (encoding == "UTF-16LE")
+        return QByteArray ("\xFF\xFE", 2);
+
+    else if (encoding == "UTF-16BE")
+        return QByteArray ("\xFE\xFF", 2);
+
+    else if (encoding == "UTF-32LE")
+        return QByteArray ("\xFF\xFE\x00\x00", 4);
+
+    else if (encoding == "UTF-32BE")
+        return QByteArray ("\x00\x00\xFE\xFF", 4);
+
+    return QByteArray();
+}
+
+/*!
+ * Returns the encoding used when a file is not valid UTF-8, which is the
+ * encoding of the system locale (or Windows-1252 if the locale uses UTF-8)
+ */
+
+QByteArray EncodingDetector::fallbackEncoding (void) {
+    QTextCodec *_codec = QTextCodec::codecForLocale();
+
+    if (_codec == NULL || _codec->mibEnum() == 106)
+        return "windows-1252";
+
+    return _codec->name();
+}
+
+/*!
+ * Returns the encoding that corresponds to the byte order mark at the
+ * start of the given \a {data}, the length of the BOM is written in
+ * \a {bom_length}. Returns an empty array if there is no BOM.
+ */
+
+QByteArray EncodingDetector::detectBom (const char *data, qint64 length, int *bom_length) {
+    const uchar *_data = reinterpret_cast<const uchar *> (data);
+
+    //
+    // UTF-32 must be checked first, because its little-endian
+    // BOM starts with the UTF-16 little-endian BOM
+    //
+    static const struct {
+        const char *encoding;
+        const char *bom;
+        int length;
+    } _boms[] = {
+        { "UTF-32LE", "\xFF\xFE\x00\x00", 4 },
+        { "UTF-32BE", "\x00\x00\xFE\xFF", 4 },
+        { "UTF-8",    "\xEF\xBB\xBF",     3 },
+        { "UTF-16LE", "\xFF\xFE",         2 },
+        { "UTF-16BE", "\xFE\xFF",         2 },
+    };
+
+    for (uint i = 0; i < sizeof (_boms) / sizeof (_boms[0]); ++i) {
+        if (length < _boms[i].length)
+            continue;
+
+        if (memcmp (_data, _boms[i].bom, _boms[i].length) == 0) {
+            if (bom_length != NULL)
+                *bom_length = _boms[i].length;
+
+            return _boms[i].encoding;
+        }
+    }
+
+    return QByteArray();
+}
+
+/*!
+ * Detects UTF-16 and UTF-32 files that do not have a BOM.
+ *
+ * Text written in those encodings has many zero bytes, and they appear at
+ * predictable positions (for example, ASCII text in UTF-16LE has a zero
+ * byte at every odd position). Returns an empty array if the data does not
+ * look like UTF-16 or UTF-32.
+ */
+
+QByteArray EncodingDetector::detectWideEncoding (const char *data, qint64 length) {
+    qint64 _length = qMin (length, (qint64) SAMPLE_SIZE) & ~3;
+    if (_length < 4)
+        return QByteArray();
+
+    qint64 _zeros[4] = { 0, 0, 0, 0 };
+    for (qint64 i = 0; i < _length; ++i) {
+        if (data[i] == 0)
+            ++_zeros[i & 3];
+    }
+
+    qreal _count = _length / 4;
+    qreal _ratio[4];
+    for (int i = 0; i < 4; ++i)
+        _ratio[i] = _zeros[i] / _count;
+
+    //
+    // UTF-32 (the two high bytes are always zero for BMP characters)
+    //
+    if (_ratio[2] > WIDE_ZERO_RATIO && _ratio[3] > WIDE_ZERO_RATIO && _ratio[0] < WIDE_NONZERO_RATIO)
+        return "UTF-32LE";
+
+    if (_ratio[0] > WIDE_ZERO_RATIO && _ratio[1] > WIDE_ZERO_RATIO && _ratio[3] < WIDE_NONZERO_RATIO)
+        return "UTF-32BE";
+
+    //
+    // UTF-16
+    //
+    qreal _even = (_ratio[0] + _ratio[2]) / 2;
+    qreal _odd = (_ratio[1] + _ratio[3]) / 2;
+
+    if (_odd > WIDE_ZERO_RATIO && _even < WIDE_NONZERO_RATIO)
+        return "UTF-16LE";
+
+    if (_even > WIDE_ZERO_RATIO && _odd < WIDE_NONZERO_RATIO)
+        return "UTF-16BE";
+
+    return QByteArray();
+}
+
+/*!
+ * Returns \c {true} if the given sample of a file does not seem to be
+ * text in any supported encoding.
+ *
+ * Text never contains null bytes (unless it is UTF-16 or UTF-32, which
+ * are detected first) and contains few control characters.
+ */
+
+bool EncodingDetector::isBinary (const char *data, qint64 length) {
+    if (length <= 0)
+        return false;
+
+    if (!detectBom (data, length, NULL).isEmpty() || !detectWideEncoding (data, length).isEmpty())
+        return false;
+
+    if (memchr (data, 0, length) != NULL)
+        return true;
+
+    qint64 _control = 0;
+    const uchar *_data = reinterpret_cast<const uchar *> (data);
+
+    for (qint64 i = 0; i < length; ++i) {
+        uchar _byte = _data[i];
+
+        if (_byte < 0x20 && _byte != '\t' && _byte != '\n' && _byte != '\r' &&
+            _byte != '\f' && _byte != '\b' && _byte != 0x1B)
+            ++_control;
+    }
+
+    return _control > length * BINARY_CONTROL_RATIO;
+}
+
+/*!
+ * \internal
+ * Changes the current encoding and creates a decoder for it, UTF-8 does
+ * not need a decoder because the data is only validated.
+ */
+
+void EncodingDetector::setEncoding (const QByteArray &encoding) {
+    delete m_decoder;
+    m_decoder = NULL;
+    m_encoding = encoding;
+
+    if (encoding == "UTF-8")
+        return;
+
+    QTextCodec *_codec = QTextCodec::codecForName (encoding);
+    if (_codec == NULL) {
+        m_encoding = "ISO-8859-1";
+        _codec = QTextCodec::codecForName (m_encoding);
+    }
+
+    m_decoder = _codec->makeDecoder (QTextCodec::IgnoreHeader);
+}
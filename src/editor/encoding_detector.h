@@ -0,0 +1,68 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef ENCODING_DETECTOR_H
+#define ENCODING_DETECTOR_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+class QTextDecoder;
+
+#include <QByteArray>
+
+#include "utf8_validator.h"
+
+class EncodingDetector {
+    public:
+        EncodingDetector (void);
+        ~EncodingDetector (void);
+
+        void reset (void);
+        bool hasBom (void) const;
+        QByteArray encoding (void) const;
+
+        bool convert (const QByteArray &data, QByteArray *output);
+        bool finish (void);
+
+        static QByteArray bom (const QByteArray &encoding);
+        static QByteArray fallbackEncoding (void);
+        static QByteArray detectBom (const char *data, qint64 length, int *bom_length);
+        static QByteArray detectWideEncoding (const char *data, qint64 length);
+        static bool isBinary (const char *data, qint64 length);
+
+    private:
+        void setEncoding (const QByteArray &encoding);
+
+        bool m_bom;
+        bool m_first;
+        bool m_forced;
+        QByteArray m_encoding;
+        QTextDecoder *m_decoder;
+        Utf8Validator m_validator;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
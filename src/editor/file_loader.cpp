@@ -0,0 +1,455 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include "file_loader.h"
+
+#define PAGE_SIZE_HINT 4096
+#define LOAD_CHUNK_SIZE 1048576
+#define COMPRESSED_CHUNK_SIZE 262144
+#define MAX_CHUNKS_IN_FLIGHT 4
+#define SLOT_WAIT_TIMEOUT 100
+
+/*!
+ * \class FileLoader
+ * \brief Reads files in a separate thread
+ *
+ * The \c FileLoader class reads a file in bounded chunks from a worker
+ * thread and hands each chunk to the \c Editor through the chunkRead()
+ * signal, this allows the editor to display the first lines of a document
+ * while the rest of the file is still being read.
+ *
+ * The encoding of the file is detected while the chunks are read (see the
+ * \c EncodingDetector class), and each chunk is converted to UTF-8 before
+ * it is given to the editor. If the file turns out not to be UTF-8 after
+ * some chunks have been emitted, the restarted() signal is emitted and the
+ * file is read again with the fallback encoding.
+ *
+ * The line endings and the indentation of the file are detected while the
+ * converted chunks are emitted (see the \c FormatDetector class).
+ *
+ * Compressed files (see the \c CompressionFormat class) are recognised by
+ * their magic bytes and decompressed in this thread, the decompressed data
+ * is emitted in chunks so that the whole file is never held in memory.
+ *
+ * Only \c MAX_CHUNKS_IN_FLIGHT chunks can be waiting to be appended to the
+ * editor at the same time, the receiver must call chunkConsumed() after
+ * processing each chunk so that the loader can continue reading.
+ */
+
+/*!
+ * \internal
+ * Initializes the loader, the file is opened when the thread is started
+ */
+
+FileLoader::FileLoader (const QString &file, QObject *parent) : QThread (parent),
+    m_file (file),
+    m_size (0),
+    m_data (NULL),
+    m_slots (MAX_CHUNKS_IN_FLIGHT),
+    m_cancelled (0),
+    m_compression (NULL) {
+}
+
+/*!
+ * \internal
+ * Releases the memory map (if any) and closes the file
+ */
+
+FileLoader::~FileLoader (void) {
+    if (m_data != NULL)
+        m_file.unmap (m_data);
+
+    m_file.close();
+}
+
+/*!
+ * Returns the size of the file in bytes
+ */
+
+qint64 FileLoader::size (void) const {
+    return m_size;
+}
+
+/*!
+ * Returns \c {true} if cancel() has been called
+ */
+
+bool FileLoader::isCancelled (void) const {
+    return m_cancelled.load() != 0;
+}
+
+/*!
+ * Returns the path of the file being read
+ */
+
+QString FileLoader::fileName (void) const {
+    return m_file.fileName();
+}
+
+/*!
+ * Returns the error string of the last failed operation, the string is
+ * empty if the file was read successfully
+ */
+
+QString FileLoader::errorString (void) const {
+    return m_error;
+}
+
+/*!
+ * Returns the name of the encoding of the file, the value is only
+ * meaningful after the thread has finished
+ */
+
+QByteArray FileLoader::encoding (void) const {
+    return m_detector.encoding();
+}
+
+/*!
+ * Returns \c {true} if the file starts with a byte order mark
+ */
+
+bool FileLoader::hasBom (void) const {
+    return m_detector.hasBom();
+}
+
+/*!
+ * Returns the name of the compression format of the file, or an empty
+ * string if the file is not compressed
+ */
+
+QString FileLoader::compression (void) const {
+    return m_compression != NULL ? m_compression->name() : QString();
+}
+
+/*!
+ * Returns the line endings and indentation detected in the file, the
+ * value is only meaningful after the thread has finished
+ */
+
+const FormatDetector &FileLoader::format (void) const {
+    return m_format;
+}
+
+/*!
+ * Stops reading the file as soon as possible
+ */
+
+void FileLoader::cancel (void) {
+    m_cancelled.store (1);
+    m_slots.release();
+}
+
+/*!
+ * Informs the loader that a chunk has been appended to the document,
+ * this function can be called from any thread.
+ */
+
+void FileLoader::chunkConsumed (void) {
+    m_slots.release();
+}
+
+/*!
+ * \internal
+ * Opens the file and reads it through a memory map, if the file cannot
+ * be mapped (e.g. pipes or sockets), then the file is read sequentially.
+ * Compressed files are always read sequentially.
+ */
+
+void FileLoader::run (void) {
+    if (!m_file.open (QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return;
+    }
+
+    m_size = m_file.size();
+    m_compression = CompressionFormat::detect (&m_file);
+
+    if (m_compression != NULL)
+        readCompressed();
+
+    else if (!readMapped())
+        readSequential();
+}
+
+/*!
+ * \internal
+ * Maps the whole file into memory and emits each chunk without copying it.
+ *
+ * The mapped pages are read by this thread before emitting the chunk, so
+ * that the disk access does not happen in the GUI thread.
+ */
+
+bool FileLoader::readMapped (void) {
+    if (m_size <= 0 || m_file.isSequential())
+        return false;
+
+    m_data = m_file.map (0, m_size);
+    if (m_data == NULL)
+        return false;
+
+    bool _restart = true;
+
+    //
+    // The loop runs a second time if the encoding detector
+    // finds out that the file is not UTF-8
+    //
+    while (_restart) {
+        _restart = false;
+
+        for (qint64 _offset = 0; _offset < m_size; _offset += LOAD_CHUNK_SIZE) {
+            qint64 _length = qMin ((qint64) LOAD_CHUNK_SIZE, m_size - _offset);
+            const char *_chunk = reinterpret_cast<const char *> (m_data + _offset);
+
+            touchPages (m_data + _offset, _length);
+
+            if (!waitForSlot())
+                return true;
+
+            if (!emitChunk (QByteArray::fromRawData (_chunk, (int) _length),
+                            _offset + _length)) {
+                _restart = true;
+                break;
+            }
+        }
+
+        if (!_restart && !isCancelled() && !m_detector.finish())
+            _restart = true;
+
+        if (_restart)
+            restart();
+    }
+
+    return true;
+}
+
+/*!
+ * \internal
+ * Reads the file using the standard \c QIODevice API, this is used when
+ * the file cannot be mapped into memory.
+ */
+
+bool FileLoader::readSequential (void) {
+    qint64 _offset = 0;
+
+    while (!m_file.atEnd()) {
+        QByteArray _chunk = m_file.read (LOAD_CHUNK_SIZE);
+
+        if (_chunk.isEmpty()) {
+            if (m_file.error() != QFile::NoError)
+                m_error = m_file.errorString();
+
+            break;
+        }
+
+        if (!waitForSlot())
+            break;
+
+        _offset += _chunk.size();
+
+        //
+        // Read the file again with the new encoding, if the file
+        // cannot be rewound, the new encoding is only used for
+        // the rest of the file
+        //
+        if (!emitChunk (_chunk, _offset)) {
+            if (m_file.seek (0)) {
+                _offset = 0;
+                restart();
+            }
+
+            else {
+                waitForSlot();
+                emitChunk (_chunk, _offset);
+            }
+        }
+    }
+
+    if (m_error.isEmpty() && !isCancelled() && !m_detector.finish() && m_file.seek (0)) {
+        restart();
+        return readSequential();
+    }
+
+    return m_error.isEmpty();
+}
+
+/*!
+ * \internal
+ * Reads the compressed file in small chunks, decompresses each chunk and
+ * emits the decompressed data in chunks of \c LOAD_CHUNK_SIZE bytes.
+ *
+ * If the file must be read again with another encoding, the file is
+ * rewound and decompressed again from the start.
+ */
+
+bool FileLoader::readCompressed (void) {
+    bool _restart = true;
+    QByteArray _output (LOAD_CHUNK_SIZE, 0);
+
+    while (_restart) {
+        _restart = false;
+
+        qint64 _offset = 0;
+        bool _finish = false;
+        QByteArray _input;
+        const char *_in = NULL;
+        qint64 _in_length = 0;
+
+        StreamCodec *_codec = m_compression->createDecoder();
+        StreamCodec::Status _status = StreamCodec::Ok;
+
+        while (_status == StreamCodec::Ok && !isCancelled()) {
+            if (_in_length == 0 && !_finish) {
+                _input = m_file.read (COMPRESSED_CHUNK_SIZE);
+
+                if (_input.isEmpty() && m_file.error() != QFile::NoError) {
+                    m_error = m_file.errorString();
+                    break;
+                }
+
+                _offset += _input.size();
+                _finish = _input.isEmpty() || m_file.atEnd();
+
+                _in = _input.constData();
+                _in_length = _input.size();
+            }
+
+            char *_out = _output.data();
+            qint64 _out_length = _output.size();
+
+            _status = _codec->process (&_in, &_in_length, &_out, &_out_length, _finish);
+
+            if (_status == StreamCodec::Error) {
+                m_error = _codec->errorString();
+                break;
+            }
+
+            qint64 _produced = _output.size() - _out_length;
+
+            if (_produced > 0) {
+                if (!waitForSlot())
+                    break;
+
+                QByteArray _chunk (_output.constData(), (int) _produced);
+
+                //
+                // Decompress the file again with the new encoding, if the
+                // file cannot be rewound, the new encoding is only used
+                // for the rest of the file
+                //
+                if (!emitChunk (_chunk, _offset)) {
+                    if (m_file.seek (0)) {
+                        _restart = true;
+                        break;
+                    }
+
+                    waitForSlot();
+                    emitChunk (_chunk, _offset);
+                }
+            }
+
+            //
+            // The whole file has been read, but the decoder
+            // could not fill the output buffer
+            //
+            if (_status == StreamCodec::Ok && _finish && _in_length == 0 && _out_length > 0) {
+                m_error = tr ("Unexpected end of compressed data");
+                break;
+            }
+        }
+
+        delete _codec;
+
+        if (!_restart && m_error.isEmpty() && !isCancelled() && !m_detector.finish())
+            _restart = m_file.seek (0);
+
+        if (_restart)
+            restart();
+    }
+
+    return m_error.isEmpty();
+}
+
+/*!
+ * \internal
+ * Blocks until the receiver has consumed enough chunks.
+ * Returns \c {false} if the loader was cancelled while waiting.
+ */
+
+bool FileLoader::waitForSlot (void) {
+    while (!m_slots.tryAcquire (1, SLOT_WAIT_TIMEOUT)) {
+        if (isCancelled())
+            return false;
+    }
+
+    return !isCancelled();
+}
+
+/*!
+ * \internal
+ * Reads one byte of each page of the given memory region, which forces
+ * the operating system to load the region from the disk.
+ */
+
+void FileLoader::touchPages (const uchar *data, qint64 length) {
+    volatile uchar _sink = 0;
+
+    for (qint64 i = 0; i < length; i += PAGE_SIZE_HINT)
+        _sink ^= data[i];
+
+    Q_UNUSED (_sink);
+}
+
+/*!
+ * \internal
+ * Clears the statistics of the file and tells the receiver that the file
+ * will be read again from the start
+ */
+
+void FileLoader::restart (void) {
+    m_format.reset();
+    emit restarted();
+}
+
+/*!
+ * \internal
+ * Converts the given chunk to UTF-8, emits it and reports the progress of
+ * the operation.
+ *
+ * Returns \c {false} if the file must be read again with another encoding,
+ * in that case the chunk is not emitted.
+ */
+
+bool FileLoader::emitChunk (const QByteArray &data, qint64 offset) {
+    QByteArray _output;
+
+    if (!m_detector.convert (data, &_output)) {
+        m_slots.release();
+        return false;
+    }
+
+    m_format.feed (_output.constData(), _output.size());
+    emit chunkRead (_output);
+
+    if (m_size > 0)
+        emit progress ((int) (offset * 100 / m_size));
+
+    return true;
+}
@@ -0,0 +1,91 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef FILE_LOADER_H
+#define FILE_LOADER_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QFile>
+#include <QThread>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QSemaphore>
+
+#include "compression.h"
+#include "format_detector.h"
+#include "encoding_detector.h"
+
+class FileLoader : public QThread {
+        Q_OBJECT
+
+    public:
+        explicit FileLoader (const QString &file, QObject *parent = 0);
+        ~FileLoader (void);
+
+        qint64 size (void) const;
+        bool isCancelled (void) const;
+        QString fileName (void) const;
+        QString errorString (void) const;
+        QByteArray encoding (void) const;
+        bool hasBom (void) const;
+        QString compression (void) const;
+        const FormatDetector &format (void) const;
+
+    signals:
+        void progress (int percent);
+        void chunkRead (const QByteArray &data);
+        void restarted (void);
+
+    public slots:
+        void cancel (void);
+        void chunkConsumed (void);
+
+    protected:
+        void run (void);
+
+    private:
+        bool readMapped (void);
+        bool readSequential (void);
+        bool readCompressed (void);
+        void restart (void);
+        bool waitForSlot (void);
+        void touchPages (const uchar *data, qint64 length);
+        bool emitChunk (const QByteArray &data, qint64 offset);
+
+        QFile m_file;
+        qint64 m_size;
+        uchar *m_data;
+        QString m_error;
+        QSemaphore m_slots;
+        QAtomicInt m_cancelled;
+        CompressionFormat *m_compression;
+        FormatDetector m_format;
+        EncodingDetector m_detector;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -0,0 +1,182 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QFile>
+#include <QFileInfo>
+
+#include "compression.h"
+#include "file_reloader.h"
+#include "encoding_detector.h"
+
+/*!
+ * \class FileReloader
+ * \brief Reads a modified file and compares it with the document
+ *
+ * The \c FileReloader reads a file that was changed by another program in
+ * a separate thread, converts it to UTF-8 and compares it with a copy of
+ * the document buffer (see the \c TextDiff class).
+ *
+ * The \c Editor applies the resulting edits to the document, so that only
+ * the changed lines are replaced. This keeps the cursor position, the
+ * folds, the markers and the undo history of the document.
+ */
+
+/*!
+ * \internal
+ * Initializes the reloader with a copy of the document \a {buffer}
+ */
+
+FileReloader::FileReloader (const QString &file,
+                            const QByteArray &buffer,
+                            QObject *parent) : QThread (parent),
+    m_bom (false),
+    m_file (file),
+    m_file_size (0),
+    m_buffer (buffer),
+    m_encoding ("UTF-8") {
+}
+
+/*!
+ * Returns \c {true} if the new file starts with a byte order mark
+ */
+
+bool FileReloader::hasBom (void) const {
+    return m_bom;
+}
+
+/*!
+ * Returns the name of the compression format of the new file, or an
+ * empty string if the file is not compressed
+ */
+
+QString FileReloader::compression (void) const {
+    return m_compression;
+}
+
+/*!
+ * Returns the size of the file (in bytes) when it was read
+ */
+
+qint64 FileReloader::fileSize (void) const {
+    return m_file_size;
+}
+
+/*!
+ * Returns the path of the file
+ */
+
+QString FileReloader::fileName (void) const {
+    return m_file;
+}
+
+/*!
+ * Returns the error string of the operation, the string is empty if the
+ * file was read successfully
+ */
+
+QString FileReloader::errorString (void) const {
+    return m_error;
+}
+
+/*!
+ * Returns the encoding of the new file
+ */
+
+QByteArray FileReloader::encoding (void) const {
+    return m_encoding;
+}
+
+/*!
+ * Returns the copy of the document that was compared with the file
+ */
+
+QByteArray FileReloader::buffer (void) const {
+    return m_buffer;
+}
+
+/*!
+ * Returns the modification date of the file when it was read
+ */
+
+QDateTime FileReloader::lastModified (void) const {
+    return m_last_modified;
+}
+
+/*!
+ * Returns the edits that transform the document into the new file
+ */
+
+QList<TextEdit> FileReloader::edits (void) const {
+    return m_edits;
+}
+
+/*!
+ * \internal
+ * Reads the file, converts it to UTF-8 and compares it with the document
+ */
+
+void FileReloader::run (void) {
+    QFile _file (m_file);
+    QFileInfo _info (m_file);
+
+    m_file_size = _info.size();
+    m_last_modified = _info.lastModified();
+
+    if (!_file.open (QIODevice::ReadOnly)) {
+        m_error = _file.errorString();
+        return;
+    }
+
+    QByteArray _data = _file.readAll();
+    if (_file.error() != QFile::NoError) {
+        m_error = _file.errorString();
+        return;
+    }
+
+    //
+    // Decompress the file (if needed)
+    //
+    CompressionFormat *_format = CompressionFormat::detect (_data);
+
+    if (_format != NULL) {
+        QByteArray _decompressed;
+
+        if (!CompressionFormat::decompress (_format, _data, &_decompressed, &m_error))
+            return;
+
+        _data = _decompressed;
+        m_compression = _format->name();
+    }
+
+    //
+    // Convert the file to UTF-8, the second call uses the
+    // fallback encoding if the file is not valid UTF-8
+    //
+    QByteArray _text;
+    EncodingDetector _detector;
+
+    if (!_detector.convert (_data, &_text) || !_detector.finish())
+        _detector.convert (_data, &_text);
+
+    m_bom = _detector.hasBom();
+    m_encoding = _detector.encoding();
+    m_edits = TextDiff::compute (m_buffer, _text);
+}
@@ -0,0 +1,71 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef FILE_RELOADER_H
+#define FILE_RELOADER_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QThread>
+#include <QDateTime>
+
+#include "text_diff.h"
+
+class FileReloader : public QThread {
+        Q_OBJECT
+
+    public:
+        explicit FileReloader (const QString &file,
+                               const QByteArray &buffer,
+                               QObject *parent = 0);
+
+        bool hasBom (void) const;
+        qint64 fileSize (void) const;
+        QString fileName (void) const;
+        QString errorString (void) const;
+        QByteArray encoding (void) const;
+        QString compression (void) const;
+        QByteArray buffer (void) const;
+        QDateTime lastModified (void) const;
+        QList<TextEdit> edits (void) const;
+
+    protected:
+        void run (void);
+
+    private:
+        bool m_bom;
+        QString m_file;
+        QString m_error;
+        qint64 m_file_size;
+        QByteArray m_buffer;
+        QByteArray m_encoding;
+        QString m_compression;
+        QDateTime m_last_modified;
+        QList<TextEdit> m_edits;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
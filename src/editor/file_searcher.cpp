@@ -0,0 +1,109 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QFile>
+
+#include "file_searcher.h"
+
+#define SEARCH_SLICE_SIZE 16777216
+
+/*!
+ * \class FileSearcher
+ * \brief Searches a pattern in a file in a separate thread
+ *
+ * The \c FileSearcher looks for the first match of a pattern after a
+ * given offset of a file, so that the viewers can search files that are
+ * much bigger than the part that they display without blocking the UI.
+ *
+ * The file is mapped in slices of \c SEARCH_SLICE_SIZE bytes, and the
+ * slices overlap so that matches between two slices are also found. The
+ * offset of the match is reported with the found() signal, which is
+ * delivered in the thread of the receiver.
+ */
+
+/*!
+ * \internal
+ * Initializes the searcher, the search starts when the thread is started
+ */
+
+FileSearcher::FileSearcher (const QString &file, const QByteArray &pattern,
+                            qint64 from, QObject *parent) : QThread (parent),
+    m_file (file),
+    m_from (qMax (from, (qint64) 0)),
+    m_pattern (pattern),
+    m_cancelled (0) {
+    Q_ASSERT (!pattern.isEmpty());
+}
+
+/*!
+ * Returns the pattern that is searched
+ */
+
+QByteArray FileSearcher::pattern (void) const {
+    return m_pattern;
+}
+
+/*!
+ * Stops the search as soon as possible
+ */
+
+void FileSearcher::cancel (void) {
+    m_cancelled.store (1);
+}
+
+/*!
+ * \internal
+ * Searches the file slice by slice and emits found() with the offset
+ * of the first match
+ */
+
+void FileSearcher::run (void) {
+    QFile _file (m_file);
+
+    if (!_file.open (QIODevice::ReadOnly))
+        return;
+
+    qint64 _size = _file.size();
+    qint64 _overlap = m_pattern.size() - 1;
+
+    for (qint64 _start = m_from; _start < _size; _start += SEARCH_SLICE_SIZE) {
+        if (m_cancelled.load() != 0)
+            return;
+
+        qint64 _length = qMin ((qint64) SEARCH_SLICE_SIZE + _overlap, _size - _start);
+        uchar *_slice = _file.map (_start, _length);
+
+        if (_slice == NULL)
+            return;
+
+        QByteArray _data = QByteArray::fromRawData (reinterpret_cast<const char *> (_slice),
+                                                    (int) _length);
+        int _index = _data.indexOf (m_pattern);
+        _file.unmap (_slice);
+
+        if (_index >= 0) {
+            emit found (_start + _index);
+            return;
+        }
+
+        emit progress ((int) ((_start + _length - m_from) * 100 / (_size - m_from)));
+    }
+}
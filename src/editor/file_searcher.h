@@ -0,0 +1,63 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef FILE_SEARCHER_H
+#define FILE_SEARCHER_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QByteArray>
+
+class FileSearcher : public QThread {
+        Q_OBJECT
+
+    public:
+        explicit FileSearcher (const QString &file, const QByteArray &pattern,
+                               qint64 from, QObject *parent = 0);
+
+        QByteArray pattern (void) const;
+
+    signals:
+        void progress (int percent);
+        void found (qint64 offset);
+
+    public slots:
+        void cancel (void);
+
+    protected:
+        void run (void);
+
+    private:
+        QString m_file;
+        qint64 m_from;
+        QByteArray m_pattern;
+        QAtomicInt m_cancelled;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
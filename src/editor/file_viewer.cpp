@@ -0,0 +1,568 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <string.h>
+
+#include <QScrollBar>
+
+#include "editor.h"
+#include "file_searcher.h"
+#include "file_viewer.h"
+#include "line_indexer.h"
+
+#define WINDOW_SIZE 8388608
+#define MAX_LINE_SEARCH 1048576
+#define PAGE_MARGIN_LINES 64
+
+/*!
+ * \class FileViewer
+ * \brief Displays huge files in the \c Editor with bounded memory
+ *
+ * The \c FileViewer only keeps a window of \c WINDOW_SIZE bytes of the
+ * file in the \c Editor. When the user scrolls near the start or the end
+ * of the window, the viewer loads the previous or the next part of the
+ * file, keeping the same lines on the screen.
+ *
+ * A \c LineIndexer scans the file in the background, which allows the
+ * viewer to jump to any line of the file and to report the current
+ * (absolute) line number. Searches run in a \c FileSearcher, so that
+ * the UI stays responsive while the rest of the file is scanned.
+ *
+ * The viewer is read-only, because the file never exists completely in
+ * the memory of the application.
+ */
+
+/*!
+ * \internal
+ * Initializes the viewer, the file is opened with open()
+ */
+
+FileViewer::FileViewer (const QString &file, Editor *editor) : QObject (editor),
+    m_file (file),
+    m_size (0),
+    m_paging (false),
+    m_editor (editor),
+    m_first_line (0),
+    m_window_end (0),
+    m_window_start (0),
+    m_indexer (NULL),
+    m_searcher (NULL) {
+    Q_ASSERT (editor != NULL);
+}
+
+/*!
+ * \internal
+ * Stops the indexer and the search before destroying the viewer
+ */
+
+FileViewer::~FileViewer (void) {
+    stopIndexing();
+    stopSearching();
+}
+
+/*!
+ * Opens the file, loads the first window and starts indexing the file.
+ * Returns \c {false} if the file cannot be opened.
+ */
+
+bool FileViewer::open (void) {
+    if (!m_file.open (QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+
+    if (!loadWindow (0, 0))
+        return false;
+
+    m_indexer = new LineIndexer (m_file.fileName(), this);
+    connect (m_indexer, SIGNAL (progress (int)), this, SIGNAL (indexProgress (int)));
+    connect (m_indexer, SIGNAL (finished()),     this, SIGNAL (indexFinished()));
+    m_indexer->start (QThread::LowPriority);
+
+    connect (m_editor->verticalScrollBar(), SIGNAL (valueChanged (int)), this, SLOT (onScroll()));
+
+    return true;
+}
+
+/*!
+ * Returns the error string of the last failed operation
+ */
+
+QString FileViewer::errorString (void) const {
+    return m_error;
+}
+
+/*!
+ * Returns the size of the file in bytes
+ */
+
+qint64 FileViewer::fileSize (void) const {
+    return m_size;
+}
+
+/*!
+ * Returns the number of lines of the file that have been indexed so far
+ */
+
+qint64 FileViewer::lineCount (void) const {
+    return m_indexer != NULL ? m_indexer->lineCount() : 0;
+}
+
+/*!
+ * Returns the absolute line number of the cursor, or -1 if it is not
+ * known yet
+ */
+
+qint64 FileViewer::currentLine (void) const {
+    if (m_first_line < 0)
+        return -1;
+
+    int _line, _index;
+    m_editor->getCursorPosition (&_line, &_index);
+
+    return m_first_line + _line;
+}
+
+/*!
+ * Returns \c {true} while the file is being indexed
+ */
+
+bool FileViewer::isIndexing (void) const {
+    return m_indexer != NULL && m_indexer->isRunning();
+}
+
+/*!
+ * Moves the cursor to the given (zero-based) \a {line} of the file,
+ * loading a new window if necessary.
+ *
+ * Returns \c {false} if the line is beyond the indexed part of the file.
+ */
+
+bool FileViewer::goToLine (qint64 line) {
+    //
+    // The line is already loaded
+    //
+    if (m_first_line >= 0 && line >= m_first_line &&
+            line < m_first_line + m_editor->lines() - 1) {
+        m_editor->setCursorPosition ((int) (line - m_first_line), 0);
+        m_editor->ensureLineVisible ((int) (line - m_first_line));
+        return true;
+    }
+
+    //
+    // Find the line in the file and load it
+    //
+    qint64 _offset = offsetOfLine (line);
+
+    if (_offset < 0 || !loadWindow (_offset, line))
+        return false;
+
+    m_editor->setCursorPosition (0, 0);
+    return true;
+}
+
+/*!
+ * Starts searching the given \a {pattern} in the file, after the current
+ * selection. The search runs in a separate thread and the next match is
+ * selected when it is found.
+ *
+ * Returns \c {false} if the search cannot be started.
+ */
+
+bool FileViewer::findNext (const QByteArray &pattern) {
+    if (pattern.isEmpty())
+        return false;
+
+    stopSearching();
+
+    long _cursor = m_editor->SendScintilla (QsciScintillaBase::SCI_GETSELECTIONEND);
+
+    m_searcher = new FileSearcher (m_file.fileName(), pattern, m_window_start + _cursor, this);
+    connect (m_searcher, SIGNAL (progress (int)),  this, SIGNAL (searchProgress (int)));
+    connect (m_searcher, SIGNAL (found (qint64)),  this, SLOT (onMatchFound (qint64)));
+    connect (m_searcher, SIGNAL (finished()),      this, SLOT (onSearchFinished()));
+
+    emit searchStarted();
+    m_searcher->start (QThread::LowPriority);
+
+    return true;
+}
+
+/*!
+ * Stops indexing the file
+ */
+
+void FileViewer::stopIndexing (void) {
+    if (m_indexer != NULL) {
+        m_indexer->cancel();
+        m_indexer->wait();
+    }
+}
+
+/*!
+ * Stops the current search (if any)
+ */
+
+void FileViewer::stopSearching (void) {
+    if (m_searcher == NULL)
+        return;
+
+    //
+    // The searcher may have queued signals that have not been
+    // delivered yet, so we delete it with the event loop
+    //
+    m_searcher->cancel();
+    m_searcher->wait();
+    m_searcher->deleteLater();
+    m_searcher = NULL;
+
+    emit searchFinished();
+}
+
+/*!
+ * \internal
+ * Loads the window that contains the match found at the given \a {offset}
+ * and selects the match
+ */
+
+void FileViewer::onMatchFound (qint64 offset) {
+    if (sender() != m_searcher)
+        return;
+
+    int _length = m_searcher->pattern().size();
+
+    if (offset < m_window_start || offset + _length > m_window_end) {
+        qint64 _line_start = lineStart (offset);
+
+        if (!loadWindow (_line_start, lineOfOffset (_line_start)))
+            return;
+    }
+
+    long _position = (long) (offset - m_window_start);
+    m_editor->SendScintilla (QsciScintillaBase::SCI_SETSEL, _position, _position + _length);
+}
+
+/*!
+ * \internal
+ * Destroys the searcher when the search is over
+ */
+
+void FileViewer::onSearchFinished (void) {
+    if (sender() != m_searcher)
+        return;
+
+    m_searcher->deleteLater();
+    m_searcher = NULL;
+
+    emit searchFinished();
+}
+
+/*!
+ * \internal
+ * Loads the next or the previous window of the file when the user
+ * scrolls near the end or the start of the current window
+ */
+
+void FileViewer::onScroll (void) {
+    if (m_paging)
+        return;
+
+    m_paging = true;
+
+    int _first = (int) m_editor->SendScintilla (QsciScintillaBase::SCI_GETFIRSTVISIBLELINE);
+    int _visible = (int) m_editor->SendScintilla (QsciScintillaBase::SCI_LINESONSCREEN);
+
+    if (_first + _visible >= m_editor->lines() - PAGE_MARGIN_LINES)
+        pageForward();
+
+    else if (_first <= PAGE_MARGIN_LINES)
+        pageBackward();
+
+    m_paging = false;
+}
+
+/*!
+ * \internal
+ * Replaces the contents of the editor with the window of the file that
+ * starts at the given \a {offset}, which must be the start of a line.
+ * The window is extended to the end of its last line.
+ */
+
+bool FileViewer::loadWindow (qint64 offset, qint64 first_line) {
+    qint64 _end = qMin (offset + WINDOW_SIZE, m_size);
+    qint64 _length = qMin (_end - offset + MAX_LINE_SEARCH, m_size - offset);
+
+    uchar *_data = NULL;
+
+    if (_length > 0) {
+        _data = m_file.map (offset, _length);
+
+        if (_data == NULL) {
+            m_error = m_file.errorString();
+            return false;
+        }
+    }
+
+    //
+    // Extend the window to the end of the line
+    //
+    if (_data != NULL && _end < m_size) {
+        const char *_feed = static_cast<const char *> (
+                                memchr (_data + (_end - offset), '\n', _length - (_end - offset)));
+
+        if (_feed != NULL)
+            _end = offset + (_feed - reinterpret_cast<const char *> (_data)) + 1;
+    }
+
+    //
+    // Replace the contents of the editor
+    //
+    bool _paging = m_paging;
+    m_paging = true;
+
+    m_editor->SendScintilla (QsciScintillaBase::SCI_SETREADONLY, false);
+    m_editor->SendScintilla (QsciScintillaBase::SCI_SETUNDOCOLLECTION, false);
+    m_editor->SendScintilla (QsciScintillaBase::SCI_CLEARALL);
+
+    if (_data != NULL)
+        m_editor->SendScintilla (QsciScintillaBase::SCI_APPENDTEXT,
+                                 (unsigned long) (_end - offset),
+                                 reinterpret_cast<const char *> (_data));
+
+    m_editor->SendScintilla (QsciScintillaBase::SCI_SETREADONLY, true);
+    m_editor->SendScintilla (QsciScintillaBase::SCI_SETSAVEPOINT);
+
+    m_paging = _paging;
+
+    if (_data != NULL)
+        m_file.unmap (_data);
+
+    m_window_start = offset;
+    m_window_end = _end;
+    m_first_line = first_line;
+
+    return true;
+}
+
+/*!
+ * \internal
+ * Loads the window that starts a few screens before the end of the
+ * current window, keeping the same lines on the screen.
+ *
+ * When the window has too few lines for that (e.g. minified files), the
+ * next window starts in the middle of the current one instead.
+ */
+
+bool FileViewer::pageForward (void) {
+    if (m_window_end >= m_size)
+        return false;
+
+    int _first = (int) m_editor->SendScintilla (QsciScintillaBase::SCI_GETFIRSTVISIBLELINE);
+    int _visible = (int) m_editor->SendScintilla (QsciScintillaBase::SCI_LINESONSCREEN);
+    int _line = qMax (0, _first - _visible - PAGE_MARGIN_LINES);
+
+    long _cursor = m_editor->SendScintilla (QsciScintillaBase::SCI_GETCURRENTPOS);
+    long _top = m_editor->SendScintilla (QsciScintillaBase::SCI_POSITIONFROMLINE, _first);
+
+    qint64 _cursor_offset = m_window_start + _cursor;
+    qint64 _top_offset = m_window_start + _top;
+    qint64 _offset = 0;
+    qint64 _first_line = -1;
+
+    if (_line > 0) {
+        _offset = m_window_start + m_editor->SendScintilla (QsciScintillaBase::SCI_POSITIONFROMLINE, _line);
+
+        if (m_first_line >= 0)
+            _first_line = m_first_line + _line;
+    }
+
+    else {
+        qint64 _middle = m_window_start + (m_window_end - m_window_start) / 2;
+
+        _offset = lineStart (_middle);
+        if (_offset <= m_window_start)
+            _offset = _middle;
+
+        if (m_first_line >= 0)
+            _first_line = m_first_line + countLines (m_window_start, _offset);
+    }
+
+    if (!loadWindow (_offset, _first_line))
+        return false;
+
+    long _new_top = (long) qMax ((qint64) 0, _top_offset - _offset);
+    m_editor->SendScintilla (QsciScintillaBase::SCI_GOTOPOS, (long) qMax ((qint64) 0, _cursor_offset - _offset));
+    m_editor->SendScintilla (QsciScintillaBase::SCI_SETFIRSTVISIBLELINE,
+                             m_editor->SendScintilla (QsciScintillaBase::SCI_LINEFROMPOSITION, _new_top));
+
+    return true;
+}
+
+/*!
+ * \internal
+ * Loads the window that ends a few screens after the start of the
+ * current window, keeping the same lines on the screen
+ */
+
+bool FileViewer::pageBackward (void) {
+    if (m_window_start <= 0)
+        return false;
+
+    int _first = (int) m_editor->SendScintilla (QsciScintillaBase::SCI_GETFIRSTVISIBLELINE);
+    long _cursor = m_editor->SendScintilla (QsciScintillaBase::SCI_GETCURRENTPOS);
+
+    qint64 _cursor_offset = m_window_start + _cursor;
+    qint64 _offset = lineStart (qMax ((qint64) 0, m_window_start - WINDOW_SIZE / 2));
+    qint64 _lines = countLines (_offset, m_window_start);
+    qint64 _first_line = m_first_line >= 0 ? m_first_line - _lines : lineOfOffset (_offset);
+
+    if (!loadWindow (_offset, _first_line))
+        return false;
+
+    m_editor->SendScintilla (QsciScintillaBase::SCI_GOTOPOS, (long) (_cursor_offset - _offset));
+    m_editor->SendScintilla (QsciScintillaBase::SCI_SETFIRSTVISIBLELINE, (long) (_first + _lines));
+
+    return true;
+}
+
+/*!
+ * \internal
+ * Returns the offset of the start of the line that contains the given
+ * \a {offset}. Lines longer than \c MAX_LINE_SEARCH are split.
+ */
+
+qint64 FileViewer::lineStart (qint64 offset) {
+    qint64 _from = qMax ((qint64) 0, offset - MAX_LINE_SEARCH);
+    qint64 _length = offset - _from;
+
+    if (_length <= 0)
+        return offset;
+
+    uchar *_data = m_file.map (_from, _length);
+    if (_data == NULL)
+        return offset;
+
+    qint64 _start = _from == 0 ? 0 : offset;
+
+    for (qint64 i = _length - 1; i >= 0; --i) {
+        if (_data[i] == '\n') {
+            _start = _from + i + 1;
+            break;
+        }
+    }
+
+    m_file.unmap (_data);
+    return _start;
+}
+
+/*!
+ * \internal
+ * Returns the (zero-based) line number of the line that starts at the
+ * given \a {offset}, or -1 if the file has not been indexed that far
+ */
+
+qint64 FileViewer::lineOfOffset (qint64 offset) {
+    qint64 _point_line, _point_offset;
+
+    if (m_indexer == NULL)
+        return offset == 0 ? 0 : -1;
+
+    if (!m_indexer->findOffset (offset, &_point_line, &_point_offset))
+        return -1;
+
+    return _point_line + countLines (_point_offset, offset);
+}
+
+/*!
+ * \internal
+ * Returns the offset of the given (zero-based) \a {line}, or -1 if the
+ * file has not been indexed that far
+ */
+
+qint64 FileViewer::offsetOfLine (qint64 line) {
+    qint64 _point_line, _point_offset;
+
+    if (m_indexer == NULL || !m_indexer->findLine (line, &_point_line, &_point_offset))
+        return -1;
+
+    return skipLines (_point_offset, line - _point_line);
+}
+
+/*!
+ * \internal
+ * Returns the number of line feeds between the offsets \a {from} and \a {to}
+ */
+
+qint64 FileViewer::countLines (qint64 from, qint64 to) {
+    qint64 _lines = 0;
+
+    for (qint64 _start = from; _start < to; _start += SEARCH_SLICE_SIZE) {
+        qint64 _length = qMin ((qint64) SEARCH_SLICE_SIZE, to - _start);
+        uchar *_data = m_file.map (_start, _length);
+
+        if (_data == NULL)
+            break;
+
+        _lines += LineIndexer::countLines (reinterpret_cast<const char *> (_data), _length);
+        m_file.unmap (_data);
+    }
+
+    return _lines;
+}
+
+/*!
+ * \internal
+ * Returns the offset of the line that is \a {lines} lines after the line
+ * that starts at \a {from}, or -1 if the file ends before that line
+ */
+
+qint64 FileViewer::skipLines (qint64 from, qint64 lines) {
+    for (qint64 _start = from; lines > 0 && _start < m_size; _start += SEARCH_SLICE_SIZE) {
+        qint64 _length = qMin ((qint64) SEARCH_SLICE_SIZE, m_size - _start);
+        uchar *_data = m_file.map (_start, _length);
+
+        if (_data == NULL)
+            return -1;
+
+        const char *_begin = reinterpret_cast<const char *> (_data);
+        const char *_cursor = _begin;
+        const char *_end = _begin + _length;
+
+        while (lines > 0 && _cursor < _end) {
+            _cursor = static_cast<const char *> (memchr (_cursor, '\n', _end - _cursor));
+
+            if (_cursor == NULL)
+                break;
+
+            ++_cursor;
+            --lines;
+        }
+
+        m_file.unmap (_data);
+
+        if (lines == 0)
+            return _start + (_cursor - _begin);
+    }
+
+    return lines == 0 ? from : -1;
+}
@@ -0,0 +1,97 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef FILE_VIEWER_H
+#define FILE_VIEWER_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+class Editor;
+class LineIndexer;
+class FileSearcher;
+
+#include <QFile>
+#include <QObject>
+
+class FileViewer : public QObject {
+        Q_OBJECT
+
+    public:
+        explicit FileViewer (const QString &file, Editor *editor);
+        ~FileViewer (void);
+
+        bool open (void);
+        QString errorString (void) const;
+
+        qint64 fileSize (void) const;
+        qint64 lineCount (void) const;
+        qint64 currentLine (void) const;
+        bool isIndexing (void) const;
+
+        bool goToLine (qint64 line);
+        bool findNext (const QByteArray &pattern);
+
+    signals:
+        void indexProgress (int percent);
+        void indexFinished (void);
+        void searchStarted (void);
+        void searchProgress (int percent);
+        void searchFinished (void);
+
+    public slots:
+        void stopIndexing (void);
+        void stopSearching (void);
+
+    private slots:
+        void onScroll (void);
+        void onMatchFound (qint64 offset);
+        void onSearchFinished (void);
+
+    private:
+        bool loadWindow (qint64 offset, qint64 first_line);
+        bool pageForward (void);
+        bool pageBackward (void);
+
+        qint64 lineStart (qint64 offset);
+        qint64 lineOfOffset (qint64 offset);
+        qint64 offsetOfLine (qint64 line);
+        qint64 countLines (qint64 from, qint64 to);
+        qint64 skipLines (qint64 from, qint64 lines);
+
+        QFile m_file;
+        qint64 m_size;
+        bool m_paging;
+        Editor *m_editor;
+        QString m_error;
+        qint64 m_first_line;
+        qint64 m_window_end;
+        qint64 m_window_start;
+        LineIndexer *m_indexer;
+        FileSearcher *m_searcher;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
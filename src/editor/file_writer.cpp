@@ -0,0 +1,321 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextCodec>
+#include <QTextEncoder>
+
+#include "platform.h"
+#include "compression.h"
+#include "file_writer.h"
+#include "encoding_detector.h"
+
+#if !WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define WRITE_CHUNK_SIZE 1048576
+#define WRITE_BUFFER_SIZE 65536
+
+/*!
+ * \class FileWriter
+ * \brief Writes a document to the disk atomically
+ *
+ * The \c FileWriter class writes a memory buffer (usually the buffer of
+ * the Scintilla document) to a \c QSaveFile in bounded chunks. The original
+ * file is only replaced after all the data was written successfully, so a
+ * crash in the middle of the operation does not truncate the file.
+ *
+ * The writer can be used synchronously with write() or in a separate
+ * thread with start(). The caller must guarantee that the buffer is not
+ * modified until the operation finishes.
+ *
+ * The buffer must contain UTF-8 text, which is converted to the encoding
+ * given with setEncoding() while it is written. If a compression format is
+ * set with setCompression(), the converted data is also compressed while
+ * it is written.
+ */
+
+/*!
+ * \internal
+ * Initializes the writer with the given \a {data} buffer
+ */
+
+FileWriter::FileWriter (const QString &file,
+                        const char *data,
+                        qint64 length,
+                        QObject *parent) : QThread (parent),
+    m_file (file),
+    m_length (length),
+    m_succeeded (false),
+    m_data (data),
+    m_sync_directory (false),
+    m_bom (false),
+    m_encoding ("UTF-8") {
+}
+
+/*!
+ * Writes the buffer to the disk and returns \c {true} on success
+ */
+
+bool FileWriter::write (void) {
+    QSaveFile _file (m_file);
+    _file.setDirectWriteFallback (false);
+
+    m_error.clear();
+    m_succeeded = false;
+
+    if (!_file.open (QIODevice::WriteOnly)) {
+        m_error = _file.errorString();
+        return false;
+    }
+
+    //
+    // Get the encoder for the document, UTF-8 documents are
+    // written without converting them
+    //
+    QTextEncoder *_encoder = NULL;
+
+    if (m_encoding != "UTF-8") {
+        QTextCodec *_codec = QTextCodec::codecForName (m_encoding);
+
+        if (_codec == NULL) {
+            m_error = tr ("Unsupported encoding (%1)").arg (QString (m_encoding));
+            _file.cancelWriting();
+            return false;
+        }
+
+        _encoder = _codec->makeEncoder (QTextCodec::IgnoreHeader);
+    }
+
+    //
+    // Get the compressor of the file (if any)
+    //
+    StreamCodec *_compressor = NULL;
+
+    if (!m_compression.isEmpty()) {
+        CompressionFormat *_format = CompressionFormat::find (m_compression);
+
+        if (_format == NULL) {
+            m_error = tr ("Unsupported compression format (%1)").arg (m_compression);
+            _file.cancelWriting();
+            delete _encoder;
+            return false;
+        }
+
+        _compressor = _format->createEncoder();
+    }
+
+    //
+    // Write the byte order mark
+    //
+    bool _ok = true;
+    QByteArray _bom = EncodingDetector::bom (m_encoding);
+
+    if (m_bom && !_bom.isEmpty())
+        _ok = writeData (&_file, _compressor, _bom.constData(), _bom.size(), false);
+
+    //
+    // Write the buffer in chunks, so that the operating
+    // system does not need to copy the whole document at once
+    //
+    for (qint64 _offset = 0; _ok && _offset < m_length;) {
+        qint64 _size = chunkSize (_offset);
+
+        if (_encoder == NULL)
+            _ok = writeData (&_file, _compressor, m_data + _offset, _size, false);
+
+        else {
+            QByteArray _data = _encoder->fromUnicode (QString::fromUtf8 (m_data + _offset, (int) _size));
+            _ok = writeData (&_file, _compressor, _data.constData(), _data.size(), false);
+        }
+
+        _offset += _size;
+    }
+
+    //
+    // Write the end of the compressed stream
+    //
+    if (_ok && _compressor != NULL)
+        _ok = writeData (&_file, _compressor, NULL, 0, true);
+
+    delete _encoder;
+    delete _compressor;
+
+    if (!_ok) {
+        if (m_error.isEmpty())
+            m_error = _file.errorString();
+
+        _file.cancelWriting();
+        return false;
+    }
+
+    //
+    // Replace the original file (QSaveFile syncs
+    // the new file before renaming it)
+    //
+    if (!_file.commit()) {
+        m_error = _file.errorString();
+        return false;
+    }
+
+    if (m_sync_directory)
+        syncDirectory();
+
+    m_succeeded = true;
+    return true;
+}
+
+/*!
+ * Returns \c {true} if the last write operation was successful
+ */
+
+bool FileWriter::succeeded (void) const {
+    return m_succeeded;
+}
+
+/*!
+ * Returns the error string of the last write operation
+ */
+
+QString FileWriter::errorString (void) const {
+    return m_error;
+}
+
+/*!
+ * If \a {sync} is set to \c {true}, the writer will also flush the directory
+ * that contains the file, which ensures that the new file survives a power
+ * failure (otherwise the rename operation may be lost).
+ */
+
+void FileWriter::setSyncDirectory (bool sync) {
+    m_sync_directory = sync;
+}
+
+/*!
+ * Sets the \a {encoding} used to write the file, if \a {bom} is set to
+ * \c {true}, the file will start with a byte order mark
+ */
+
+void FileWriter::setEncoding (const QByteArray &encoding, bool bom) {
+    m_bom = bom;
+    m_encoding = encoding.isEmpty() ? QByteArray ("UTF-8") : encoding;
+}
+
+/*!
+ * Sets the name of the compression \a {format} used to write the file (see
+ * the \c CompressionFormat class), the file is not compressed if the name
+ * is empty
+ */
+
+void FileWriter::setCompression (const QString &format) {
+    m_compression = format;
+}
+
+/*!
+ * \internal
+ * Writes the file in a separate thread
+ */
+
+void FileWriter::run (void) {
+    write();
+}
+
+/*!
+ * \internal
+ * Returns the size of the chunk that starts at the given \a {offset}.
+ *
+ * Chunks never end in the middle of a UTF-8 sequence, so that each
+ * chunk can be converted to another encoding on its own.
+ */
+
+qint64 FileWriter::chunkSize (qint64 offset) const {
+    qint64 _size = qMin ((qint64) WRITE_CHUNK_SIZE, m_length - offset);
+    qint64 _end = offset + _size;
+
+    while (_end < m_length && _end > offset + 1 &&
+           (static_cast<uchar> (m_data[_end]) & 0xC0) == 0x80)
+        --_end;
+
+    return _end - offset;
+}
+
+/*!
+ * \internal
+ * Writes the given \a {data} to the \a {device}, the data is compressed
+ * first if a \a {codec} is given. Set \a {finish} to \c {true} after the
+ * last chunk to write the end of the compressed stream.
+ */
+
+bool FileWriter::writeData (QIODevice *device,
+                            StreamCodec *codec,
+                            const char *data,
+                            qint64 length,
+                            bool finish) {
+    if (codec == NULL)
+        return device->write (data, length) == length;
+
+    char _buffer[WRITE_BUFFER_SIZE];
+    StreamCodec::Status _status = StreamCodec::Ok;
+
+    //
+    // Compress until the codec has consumed all the data (and
+    // has written the end of the stream when finishing)
+    //
+    while (length > 0 || (finish && _status == StreamCodec::Ok)) {
+        char *_output = _buffer;
+        qint64 _output_length = sizeof (_buffer);
+
+        _status = codec->process (&data, &length, &_output, &_output_length, finish);
+
+        if (_status == StreamCodec::Error) {
+            m_error = codec->errorString();
+            return false;
+        }
+
+        qint64 _size = sizeof (_buffer) - _output_length;
+        if (_size > 0 && device->write (_buffer, _size) != _size)
+            return false;
+    }
+
+    return true;
+}
+
+/*!
+ * \internal
+ * Flushes the directory entry of the file to the disk, this is not
+ * needed (nor possible) on Windows.
+ */
+
+void FileWriter::syncDirectory (void) {
+#if !WINDOWS
+    QString _path = QFileInfo (m_file).absolutePath();
+    int _fd = ::open (QFile::encodeName (_path).constData(), O_RDONLY);
+
+    if (_fd >= 0) {
+        ::fsync (_fd);
+        ::close (_fd);
+    }
+#endif
+}
@@ -0,0 +1,79 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef FILE_WRITER_H
+#define FILE_WRITER_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QThread>
+
+class QIODevice;
+class StreamCodec;
+
+class FileWriter : public QThread {
+        Q_OBJECT
+
+    public:
+        explicit FileWriter (const QString &file,
+                             const char *data,
+                             qint64 length,
+                             QObject *parent = 0);
+
+        bool write (void);
+        bool succeeded (void) const;
+        QString errorString (void) const;
+
+        void setSyncDirectory (bool sync);
+        void setEncoding (const QByteArray &encoding, bool bom);
+        void setCompression (const QString &format);
+
+    protected:
+        void run (void);
+
+    private:
+        void syncDirectory (void);
+        qint64 chunkSize (qint64 offset) const;
+        bool writeData (QIODevice *device,
+                        StreamCodec *codec,
+                        const char *data,
+                        qint64 length,
+                        bool finish);
+
+        QString m_file;
+        qint64 m_length;
+        bool m_succeeded;
+        QString m_error;
+        const char *m_data;
+        bool m_sync_directory;
+
+        bool m_bom;
+        QByteArray m_encoding;
+        QString m_compression;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
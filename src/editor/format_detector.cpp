@@ -0,0 +1,372 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <limits.h>
+#include <string.h>
+
+#include "simd.h"
+#include "format_detector.h"
+
+#define INDENT_SAMPLE_LINES 4096
+
+/*!
+ * \class FormatDetector
+ * \brief Detects the line endings and the indentation style of a document
+ *
+ * The \c FormatDetector is fed with the chunks of a file while it is being
+ * loaded, and it finds out:
+ *
+ * - The number of CR, LF and CRLF line endings, which are counted with
+ *   SSE2 instructions (16 bytes at a time) when they are available
+ * - If the document is indented with tabs or spaces, and the width of
+ *   each indentation level, using the first \c INDENT_SAMPLE_LINES lines
+ *
+ * The results are used by the \c Editor to configure the EOL mode and the
+ * indentation of Scintilla, so that new lines match the rest of the file.
+ */
+
+/*!
+ * \internal
+ * Initializes the detector
+ */
+
+FormatDetector::FormatDetector (void) {
+    reset();
+}
+
+/*!
+ * Clears the statistics, so that the detector can be used with another file
+ */
+
+void FormatDetector::reset (void) {
+    m_cr = 0;
+    m_lf = 0;
+    m_crlf = 0;
+    m_last_cr = false;
+
+    m_lines = 0;
+    m_spaces = 0;
+    m_in_indent = true;
+    m_tab_indent = false;
+    m_previous_indent = 0;
+    m_tab_lines = 0;
+    m_space_lines = 0;
+
+    memset (m_widths, 0, sizeof (m_widths));
+}
+
+/*!
+ * Updates the statistics with the next chunk of the file
+ */
+
+void FormatDetector::feed (const char *data, qint64 length) {
+    if (data == NULL || length <= 0)
+        return;
+
+    const uchar *_data = reinterpret_cast<const uchar *> (data);
+
+    countLineEndings (_data, length);
+
+    if (m_lines < INDENT_SAMPLE_LINES)
+        sampleIndentation (_data, length);
+}
+
+/*!
+ * Returns the number of CR characters (including the ones that are part
+ * of a CRLF line ending)
+ */
+
+qint64 FormatDetector::crCount (void) const {
+    return m_cr;
+}
+
+/*!
+ * Returns the number of LF characters (including the ones that are part
+ * of a CRLF line ending)
+ */
+
+qint64 FormatDetector::lfCount (void) const {
+    return m_lf;
+}
+
+/*!
+ * Returns the number of CRLF line endings
+ */
+
+qint64 FormatDetector::crlfCount (void) const {
+    return m_crlf;
+}
+
+/*!
+ * Returns \c {true} if the document uses more than one type of line ending
+ */
+
+bool FormatDetector::hasMixedEols (void) const {
+    int _types = 0;
+
+    if (m_crlf > 0)
+        ++_types;
+
+    if (m_lf - m_crlf > 0)
+        ++_types;
+
+    if (m_cr - m_crlf > 0)
+        ++_types;
+
+    return _types > 1;
+}
+
+/*!
+ * Returns the line ending used by most lines of the document, or
+ * \a {fallback} if the document does not have any line endings
+ */
+
+QsciScintilla::EolMode FormatDetector::eolMode (QsciScintilla::EolMode fallback) const {
+    qint64 _lf = m_lf - m_crlf;
+    qint64 _cr = m_cr - m_crlf;
+
+    if (m_crlf == 0 && _lf == 0 && _cr == 0)
+        return fallback;
+
+    if (m_crlf >= _lf && m_crlf >= _cr)
+        return QsciScintilla::EolWindows;
+
+    if (_lf >= _cr)
+        return QsciScintilla::EolUnix;
+
+    return QsciScintilla::EolMac;
+}
+
+/*!
+ * Returns \c {true} if at least one of the sampled lines is indented
+ */
+
+bool FormatDetector::hasIndentation (void) const {
+    return m_tab_lines > 0 || m_space_lines > 0;
+}
+
+/*!
+ * Returns \c {true} if most of the indented lines start with a tab
+ */
+
+bool FormatDetector::indentationUsesTabs (void) const {
+    return m_tab_lines > m_space_lines;
+}
+
+/*!
+ * Returns the most common difference between the indentation of two
+ * consecutive lines (indented with spaces), or 0 if it cannot be detected
+ */
+
+int FormatDetector::indentationWidth (void) const {
+    int _width = 0;
+
+    for (int i = 2; i <= MAX_INDENT_WIDTH; ++i) {
+        if (m_widths[i] > m_widths[_width])
+            _width = i;
+    }
+
+    return _width;
+}
+
+/*!
+ * Returns a copy of the given \a {data} where all the line endings (CR, LF
+ * and CRLF) are replaced with the line ending of the given \a {mode}.
+ *
+ * The conversion is done in a single pass, blocks of text without line
+ * endings are copied at once.
+ */
+
+QByteArray FormatDetector::convertEols (const char *data,
+                                        qint64 length,
+                                        QsciScintilla::EolMode mode) {
+    QByteArray _eol = mode == QsciScintilla::EolWindows ? "\r\n" :
+                      mode == QsciScintilla::EolMac ? "\r" : "\n";
+
+    QByteArray _output;
+    _output.reserve ((int) qMin (length + length / 16 + 16, (qint64) INT_MAX));
+
+    qint64 _start = 0;
+    qint64 i = 0;
+
+    while (i < length) {
+#if SIMD_SSE2
+        //
+        // Skip blocks that do not contain any line ending
+        //
+        const __m128i _cr = _mm_set1_epi8 ('\r');
+        const __m128i _lf = _mm_set1_epi8 ('\n');
+
+        while (i + 16 <= length) {
+            __m128i _block = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (data + i));
+            int _mask = _mm_movemask_epi8 (_mm_or_si128 (_mm_cmpeq_epi8 (_block, _cr),
+                                                         _mm_cmpeq_epi8 (_block, _lf)));
+
+            if (_mask != 0) {
+                i += countTrailingZeros (_mask);
+                break;
+            }
+
+            i += 16;
+        }
+
+        if (i >= length)
+            break;
+#endif
+
+        char c = data[i];
+
+        if (c != '\r' && c != '\n') {
+            ++i;
+            continue;
+        }
+
+        _output.append (data + _start, (int) (i - _start));
+        _output.append (_eol);
+
+        if (c == '\r' && i + 1 < length && data[i + 1] == '\n')
+            ++i;
+
+        _start = ++i;
+    }
+
+    _output.append (data + _start, (int) (length - _start));
+    return _output;
+}
+
+/*!
+ * \internal
+ * Counts the CR, LF and CRLF characters of the given \a {data}
+ */
+
+void FormatDetector::countLineEndings (const uchar *data, qint64 length) {
+    qint64 i = 0;
+
+    //
+    // A CRLF sequence may be split between two chunks
+    //
+    if (m_last_cr && data[0] == '\n')
+        ++m_crlf;
+
+#if SIMD_SSE2
+    const __m128i _cr = _mm_set1_epi8 ('\r');
+    const __m128i _lf = _mm_set1_epi8 ('\n');
+
+    unsigned int _carry = 0;
+    bool _first = true;
+
+    for (; i + 16 <= length; i += 16) {
+        __m128i _block = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (data + i));
+        unsigned int _cr_mask = _mm_movemask_epi8 (_mm_cmpeq_epi8 (_block, _cr));
+        unsigned int _lf_mask = _mm_movemask_epi8 (_mm_cmpeq_epi8 (_block, _lf));
+
+        //
+        // The first CRLF of the chunk was already counted
+        //
+        unsigned int _crlf_mask = _lf_mask & ((_cr_mask << 1) | (_first ? 0 : _carry));
+
+        m_cr += popCount (_cr_mask);
+        m_lf += popCount (_lf_mask);
+        m_crlf += popCount (_crlf_mask);
+
+        _carry = (_cr_mask >> 15) & 1;
+        _first = false;
+    }
+#endif
+
+    for (; i < length; ++i) {
+        if (data[i] == '\r')
+            ++m_cr;
+
+        else if (data[i] == '\n') {
+            ++m_lf;
+
+            if (i > 0 && data[i - 1] == '\r')
+                ++m_crlf;
+        }
+    }
+
+    m_last_cr = data[length - 1] == '\r';
+}
+
+/*!
+ * \internal
+ * Reads the leading whitespace of each line in the given \a {data}, until
+ * \c INDENT_SAMPLE_LINES lines have been sampled.
+ *
+ * For lines indented with spaces, the difference with the indentation of
+ * the previous line is used to guess the width of an indentation level.
+ */
+
+void FormatDetector::sampleIndentation (const uchar *data, qint64 length) {
+    for (qint64 i = 0; i < length && m_lines < INDENT_SAMPLE_LINES; ++i) {
+        uchar c = data[i];
+
+        //
+        // Start a new line, blank lines are ignored
+        //
+        if (c == '\n' || c == '\r') {
+            if (!m_in_indent)
+                ++m_lines;
+
+            m_spaces = 0;
+            m_in_indent = true;
+            m_tab_indent = false;
+            continue;
+        }
+
+        if (!m_in_indent)
+            continue;
+
+        if (c == ' ') {
+            ++m_spaces;
+            continue;
+        }
+
+        else if (c == '\t') {
+            if (m_spaces == 0)
+                m_tab_indent = true;
+
+            continue;
+        }
+
+        //
+        // This is the first character of the line, so we
+        // have the complete indentation of the line
+        //
+        m_in_indent = false;
+
+        if (m_tab_indent)
+            ++m_tab_lines;
+
+        else {
+            int _delta = qAbs (m_spaces - m_previous_indent);
+
+            if (m_spaces > 0)
+                ++m_space_lines;
+
+            if (_delta >= 2 && _delta <= MAX_INDENT_WIDTH)
+                ++m_widths[_delta];
+
+            m_previous_indent = m_spaces;
+        }
+    }
+}
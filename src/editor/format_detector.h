@@ -0,0 +1,79 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef FORMAT_DETECTOR_H
+#define FORMAT_DETECTOR_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QByteArray>
+#include <Qsci/qsciscintilla.h>
+
+#define MAX_INDENT_WIDTH 8
+
+class FormatDetector {
+    public:
+        FormatDetector (void);
+
+        void reset (void);
+        void feed (const char *data, qint64 length);
+
+        qint64 crCount (void) const;
+        qint64 lfCount (void) const;
+        qint64 crlfCount (void) const;
+
+        bool hasMixedEols (void) const;
+        QsciScintilla::EolMode eolMode (QsciScintilla::EolMode fallback) const;
+
+        bool hasIndentation (void) const;
+        bool indentationUsesTabs (void) const;
+        int indentationWidth (void) const;
+
+        static QByteArray convertEols (const char *data,
+                                       qint64 length,
+                                       QsciScintilla::EolMode mode);
+
+    private:
+        void countLineEndings (const uchar *data, qint64 length);
+        void sampleIndentation (const uchar *data, qint64 length);
+
+        qint64 m_cr;
+        qint64 m_lf;
+        qint64 m_crlf;
+        bool m_last_cr;
+
+        int m_lines;
+        int m_spaces;
+        bool m_in_indent;
+        bool m_tab_indent;
+        int m_previous_indent;
+        int m_tab_lines;
+        int m_space_lines;
+        int m_widths[MAX_INDENT_WIDTH + 1];
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -0,0 +1,504 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <ctype.h>
+
+#include <QScrollBar>
+
+#include "editor.h"
+#include "hex_viewer.h"
+#include "file_searcher.h"
+#include "encoding_detector.h"
+
+#define BYTES_PER_ROW 16
+#define WINDOW_ROWS 4096
+#define PAGE_MARGIN_ROWS 64
+#define SNIFF_SIZE 65536
+
+/*!
+ * \class HexViewer
+ * \brief Displays binary files as hexadecimal and ASCII rows
+ *
+ * The \c HexViewer displays each row of \c BYTES_PER_ROW bytes of the file
+ * with its offset, the hexadecimal value of each byte and its printable
+ * ASCII characters. Binary files are never converted to text, so they
+ * cannot be damaged by the editor.
+ *
+ * Only a window of \c WINDOW_ROWS rows around the visible rows is
+ * formatted and given to the \c Editor, and only that part of the file is
+ * mapped into memory. All the rows have the same length, so the viewer
+ * can find the row of any offset without scanning the file, which allows
+ * it to open files of any size instantly. Searches run in a
+ * \c FileSearcher, like in the \c FileViewer.
+ *
+ * The viewer is read-only.
+ */
+
+/*!
+ * \internal
+ * Initializes the viewer, the file is opened with open()
+ */
+
+HexViewer::HexViewer (const QString &file, Editor *editor) : QObject (editor),
+    m_file (file),
+    m_size (0),
+    m_paging (false),
+    m_editor (editor),
+    m_offset_digits (8),
+    m_first_row (0),
+    m_window_rows (0),
+    m_searcher (NULL) {
+    Q_ASSERT (editor != NULL);
+}
+
+/*!
+ * \internal
+ * Stops the search before destroying the viewer
+ */
+
+HexViewer::~HexViewer (void) {
+    stopSearching();
+}
+
+/*!
+ * Opens the file and displays its first rows.
+ * Returns \c {false} if the file cannot be opened.
+ */
+
+bool HexViewer::open (void) {
+    if (!m_file.open (QIODevice::ReadOnly)) {
+        m_error = m_file.errorString();
+        return false;
+    }
+
+    m_size = m_file.size();
+    m_offset_digits = m_size > Q_INT64_C (0xFFFFFFFF) ? 16 : 8;
+
+    if (!loadWindow (0))
+        return false;
+
+    connect (m_editor->verticalScrollBar(), SIGNAL (valueChanged (int)), this, SLOT (onScroll()));
+
+    return true;
+}
+
+/*!
+ * Returns the error string of the last failed operation
+ */
+
+QString HexViewer::errorString (void) const {
+    return m_error;
+}
+
+/*!
+ * Returns the size of the file in bytes
+ */
+
+qint64 HexViewer::fileSize (void) const {
+    return m_size;
+}
+
+/*!
+ * Returns the number of rows of the file
+ */
+
+qint64 HexViewer::rowCount (void) const {
+    return (m_size + BYTES_PER_ROW - 1) / BYTES_PER_ROW;
+}
+
+/*!
+ * Returns the offset of the byte under the cursor
+ */
+
+qint64 HexViewer::currentOffset (void) const {
+    return offsetOfPosition (m_editor->SendScintilla (QsciScintillaBase::SCI_GETCURRENTPOS));
+}
+
+/*!
+ * Moves the cursor to the byte at the given \a {offset}, loading a new
+ * window if necessary.
+ *
+ * Returns \c {false} if the offset is not inside the file.
+ */
+
+bool HexViewer::goToOffset (qint64 offset) {
+    if (offset < 0 || offset >= m_size)
+        return false;
+
+    if (!showRows (offset / BYTES_PER_ROW, 1))
+        return false;
+
+    long _position = positionOfOffset (offset);
+    m_editor->SendScintilla (QsciScintillaBase::SCI_GOTOPOS, _position);
+
+    return true;
+}
+
+/*!
+ * Starts searching the given bytes \a {pattern} in the file, after the
+ * start of the current selection. The search runs in a separate thread
+ * and the next match is selected when it is found.
+ *
+ * Returns \c {false} if the search cannot be started.
+ */
+
+bool HexViewer::findNext (const QByteArray &pattern) {
+    if (pattern.isEmpty() || m_size <= 0)
+        return false;
+
+    stopSearching();
+
+    long _anchor = m_editor->SendScintilla (QsciScintillaBase::SCI_GETSELECTIONSTART);
+    long _caret = m_editor->SendScintilla (QsciScintillaBase::SCI_GETSELECTIONEND);
+    qint64 _from = offsetOfPosition (_anchor) + (_anchor != _caret ? 1 : 0);
+
+    m_searcher = new FileSearcher (m_file.fileName(), pattern, _from, this);
+    connect (m_searcher, SIGNAL (progress (int)),  this, SIGNAL (searchProgress (int)));
+    connect (m_searcher, SIGNAL (found (qint64)),  this, SLOT (onMatchFound (qint64)));
+    connect (m_searcher, SIGNAL (finished()),      this, SLOT (onSearchFinished()));
+
+    emit searchStarted();
+    m_searcher->start (QThread::LowPriority);
+
+    return true;
+}
+
+/*!
+ * Stops the current search (if any)
+ */
+
+void HexViewer::stopSearching (void) {
+    if (m_searcher == NULL)
+        return;
+
+    //
+    // The searcher may have queued signals that have not been
+    // delivered yet, so we delete it with the event loop
+    //
+    m_searcher->cancel();
+    m_searcher->wait();
+    m_searcher->deleteLater();
+    m_searcher = NULL;
+
+    emit searchFinished();
+}
+
+/*!
+ * Reads the first bytes of the given \a {file} and returns \c {true} if
+ * the file does not seem to contain text
+ */
+
+bool HexViewer::isBinaryFile (const QString &file) {
+    QFile _file (file);
+
+    if (!_file.open (QIODevice::ReadOnly))
+        return false;
+
+    QByteArray _data = _file.read (SNIFF_SIZE);
+    return EncodingDetector::isBinary (_data.constData(), _data.size());
+}
+
+/*!
+ * Converts the given search \a {text} to the bytes to search.
+ *
+ * If the text only contains pairs of hexadecimal digits (optionally
+ * separated with spaces, e.g. \c {"7F 45 4C 46"}), the pattern contains
+ * the values of those digits. Otherwise, the pattern is the UTF-8 text,
+ * without the quotes if the text is quoted (e.g. \c {"\"cafe\""}).
+ */
+
+QByteArray HexViewer::parsePattern (const QString &text) {
+    QString _digits = text;
+    _digits.remove (' ');
+
+    bool _hex = !_digits.isEmpty() && _digits.length() % 2 == 0;
+
+    for (int i = 0; _hex && i < _digits.length(); ++i) {
+        if (!isxdigit (_digits.at (i).toLatin1()))
+            _hex = false;
+    }
+
+    if (_hex)
+        return QByteArray::fromHex (_digits.toLatin1());
+
+    if (text.length() >= 2 && text.startsWith ('"') && text.endsWith ('"'))
+        return text.mid (1, text.length() - 2).toUtf8();
+
+    return text.toUtf8();
+}
+
+/*!
+ * \internal
+ * Displays the rows of the match found at the given \a {offset} and
+ * selects the hexadecimal values of the match
+ */
+
+void HexViewer::onMatchFound (qint64 offset) {
+    if (sender() != m_searcher)
+        return;
+
+    qint64 _last = offset + m_searcher->pattern().size() - 1;
+    qint64 _rows = _last / BYTES_PER_ROW - offset / BYTES_PER_ROW + 1;
+
+    if (!showRows (offset / BYTES_PER_ROW, _rows))
+        return;
+
+    long _end = positionOfOffset (qMin (_last, (m_first_row + m_window_rows) * BYTES_PER_ROW - 1)) + 2;
+    m_editor->SendScintilla (QsciScintillaBase::SCI_SETSEL, positionOfOffset (offset), _end);
+}
+
+/*!
+ * \internal
+ * Destroys the searcher when the search is over
+ */
+
+void HexViewer::onSearchFinished (void) {
+    if (sender() != m_searcher)
+        return;
+
+    m_searcher->deleteLater();
+    m_searcher = NULL;
+
+    emit searchFinished();
+}
+
+/*!
+ * \internal
+ * Loads a new window when the user scrolls near the start or the end of
+ * the current window, keeping the same rows on the screen
+ */
+
+void HexViewer::onScroll (void) {
+    if (m_paging)
+        return;
+
+    m_paging = true;
+
+    qint64 _first = m_editor->SendScintilla (QsciScintillaBase::SCI_GETFIRSTVISIBLELINE);
+    qint64 _visible = m_editor->SendScintilla (QsciScintillaBase::SCI_LINESONSCREEN);
+
+    bool _forward = _first + _visible >= m_window_rows - PAGE_MARGIN_ROWS &&
+                    m_first_row + m_window_rows < rowCount();
+    bool _backward = _first <= PAGE_MARGIN_ROWS && m_first_row > 0;
+
+    if (_forward || _backward) {
+        long _cursor = m_editor->SendScintilla (QsciScintillaBase::SCI_GETCURRENTPOS);
+        qint64 _cursor_offset = offsetOfPosition (_cursor);
+        qint64 _row = m_first_row + _first;
+
+        if (loadWindow (qMax ((qint64) 0, _row - WINDOW_ROWS / 2))) {
+            qint64 _cursor_row = _cursor_offset / BYTES_PER_ROW;
+
+            if (_cursor_row >= m_first_row && _cursor_row < m_first_row + m_window_rows)
+                m_editor->SendScintilla (QsciScintillaBase::SCI_GOTOPOS, positionOfOffset (_cursor_offset));
+
+            m_editor->SendScintilla (QsciScintillaBase::SCI_SETFIRSTVISIBLELINE, (long) (_row - m_first_row));
+        }
+    }
+
+    m_paging = false;
+}
+
+/*!
+ * \internal
+ * Replaces the contents of the editor with the rows of the window that
+ * starts at the given row
+ */
+
+bool HexViewer::loadWindow (qint64 first_row) {
+    qint64 _rows = rowCount();
+
+    first_row = qMax ((qint64) 0, qMin (first_row, _rows - WINDOW_ROWS));
+
+    qint64 _end_row = qMin (first_row + WINDOW_ROWS, _rows);
+    qint64 _offset = first_row * BYTES_PER_ROW;
+    qint64 _length = qMin (_end_row * BYTES_PER_ROW, m_size) - _offset;
+
+    uchar *_data = NULL;
+
+    if (_length > 0) {
+        _data = m_file.map (_offset, _length);
+
+        if (_data == NULL) {
+            m_error = m_file.errorString();
+            return false;
+        }
+    }
+
+    //
+    // Format the rows of the window
+    //
+    QByteArray _text;
+    _text.reserve ((int) ((_end_row - first_row) * rowLength()));
+
+    for (qint64 i = 0; i < _length; i += BYTES_PER_ROW)
+        appendRow (&_text, _data + i, _offset + i, (int) qMin ((qint64) BYTES_PER_ROW, _length - i));
+
+    if (_data != NULL)
+        m_file.unmap (_data);
+
+    //
+    // Replace the contents of the editor
+    //
+    bool _paging = m_paging;
+    m_paging = true;
+
+    m_editor->SendScintilla (QsciScintillaBase::SCI_SETREADONLY, false);
+    m_editor->SendScintilla (QsciScintillaBase::SCI_SETUNDOCOLLECTION, false);
+    m_editor->SendScintilla (QsciScintillaBase::SCI_CLEARALL);
+    m_editor->SendScintilla (QsciScintillaBase::SCI_APPENDTEXT,
+                             (unsigned long) _text.size(),
+                             _text.constData());
+    m_editor->SendScintilla (QsciScintillaBase::SCI_SETREADONLY, true);
+    m_editor->SendScintilla (QsciScintillaBase::SCI_SETSAVEPOINT);
+
+    m_paging = _paging;
+
+    m_first_row = first_row;
+    m_window_rows = _end_row - first_row;
+
+    return true;
+}
+
+/*!
+ * \internal
+ * Ensures that the given \a {count} rows starting at \a {row} are loaded,
+ * loading a new window around them if needed
+ */
+
+bool HexViewer::showRows (qint64 row, qint64 count) {
+    if (row >= m_first_row && row + count <= m_first_row + m_window_rows)
+        return true;
+
+    return loadWindow (row - PAGE_MARGIN_ROWS);
+}
+
+/*!
+ * \internal
+ * Appends the row with the given \a {length} bytes of \a {data}, which
+ * starts at the given \a {offset} of the file, to the \a {text}
+ */
+
+void HexViewer::appendRow (QByteArray *text, const uchar *data, qint64 offset, int length) const {
+    static const char _digits[] = "0123456789ABCDEF";
+
+    char _row[64 + BYTES_PER_ROW * 4];
+    char *_cursor = _row;
+
+    for (int i = m_offset_digits - 1; i >= 0; --i)
+        *_cursor++ = _digits[(offset >> (i * 4)) & 0xF];
+
+    *_cursor++ = ' ';
+    *_cursor++ = ' ';
+
+    for (int i = 0; i < BYTES_PER_ROW; ++i) {
+        if (i == BYTES_PER_ROW / 2)
+            *_cursor++ = ' ';
+
+        *_cursor++ = i < length ? _digits[data[i] >> 4] : ' ';
+        *_cursor++ = i < length ? _digits[data[i] & 0xF] : ' ';
+        *_cursor++ = ' ';
+    }
+
+    *_cursor++ = ' ';
+
+    for (int i = 0; i < length; ++i)
+        *_cursor++ = (data[i] >= 0x20 && data[i] < 0x7F) ? (char) data[i] : '.';
+
+    *_cursor++ = '\n';
+
+    text->append (_row, (int) (_cursor - _row));
+}
+
+/*!
+ * \internal
+ * Returns the length of a complete row (including the line feed)
+ */
+
+int HexViewer::rowLength (void) const {
+    return asciiColumn() + BYTES_PER_ROW + 1;
+}
+
+/*!
+ * \internal
+ * Returns the column of the first hexadecimal value of a row
+ */
+
+int HexViewer::hexColumn (void) const {
+    return m_offset_digits + 2;
+}
+
+/*!
+ * \internal
+ * Returns the column of the first ASCII character of a row
+ */
+
+int HexViewer::asciiColumn (void) const {
+    return hexColumn() + BYTES_PER_ROW * 3 + 2;
+}
+
+/*!
+ * \internal
+ * Returns the column of the hexadecimal value of the given \a {byte}
+ * of a row
+ */
+
+int HexViewer::byteColumn (int byte) const {
+    return hexColumn() + byte * 3 + (byte >= BYTES_PER_ROW / 2 ? 1 : 0);
+}
+
+/*!
+ * \internal
+ * Returns the position (in the editor) of the hexadecimal value of the
+ * byte at the given \a {offset}, which must be inside the window
+ */
+
+long HexViewer::positionOfOffset (qint64 offset) const {
+    qint64 _row = offset / BYTES_PER_ROW - m_first_row;
+    return (long) (_row * rowLength() + byteColumn ((int) (offset % BYTES_PER_ROW)));
+}
+
+/*!
+ * \internal
+ * Returns the offset of the byte displayed at the given \a {position}
+ * (in the editor), which may be its hexadecimal value or its character
+ */
+
+qint64 HexViewer::offsetOfPosition (long position) const {
+    qint64 _row = position / rowLength();
+    int _column = (int) (position % rowLength());
+    int _byte = 0;
+
+    if (_column >= asciiColumn())
+        _byte = _column - asciiColumn();
+
+    else if (_column >= hexColumn()) {
+        _byte = (_column - hexColumn()) / 3;
+
+        if (_byte > 0 && _column < byteColumn (_byte))
+            --_byte;
+    }
+
+    _byte = qBound (0, _byte, BYTES_PER_ROW - 1);
+
+    qint64 _offset = (m_first_row + _row) * BYTES_PER_ROW + _byte;
+    return qMax ((qint64) 0, qMin (_offset, m_size - 1));
+}
@@ -0,0 +1,95 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef HEX_VIEWER_H
+#define HEX_VIEWER_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+class Editor;
+class FileSearcher;
+
+#include <QFile>
+#include <QObject>
+
+class HexViewer : public QObject {
+        Q_OBJECT
+
+    public:
+        explicit HexViewer (const QString &file, Editor *editor);
+        ~HexViewer (void);
+
+        bool open (void);
+        QString errorString (void) const;
+
+        qint64 fileSize (void) const;
+        qint64 rowCount (void) const;
+        qint64 currentOffset (void) const;
+
+        bool goToOffset (qint64 offset);
+        bool findNext (const QByteArray &pattern);
+
+        static bool isBinaryFile (const QString &file);
+        static QByteArray parsePattern (const QString &text);
+
+    signals:
+        void searchStarted (void);
+        void searchProgress (int percent);
+        void searchFinished (void);
+
+    public slots:
+        void stopSearching (void);
+
+    private slots:
+        void onScroll (void);
+        void onMatchFound (qint64 offset);
+        void onSearchFinished (void);
+
+    private:
+        bool loadWindow (qint64 first_row);
+        bool showRows (qint64 row, qint64 count);
+        void appendRow (QByteArray *text, const uchar *data, qint64 offset, int length) const;
+
+        int rowLength (void) const;
+        int hexColumn (void) const;
+        int asciiColumn (void) const;
+        int byteColumn (int byte) const;
+        long positionOfOffset (qint64 offset) const;
+        qint64 offsetOfPosition (long position) const;
+
+        QFile m_file;
+        qint64 m_size;
+        bool m_paging;
+        Editor *m_editor;
+        QString m_error;
+        int m_offset_digits;
+        qint64 m_first_row;
+        qint64 m_window_rows;
+        FileSearcher *m_searcher;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -0,0 +1,184 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QFile>
+#include <QCoreApplication>
+
+#include "edit_journal.h"
+#include "journal_writer.h"
+
+#define FLUSH_INTERVAL 1000
+
+/*!
+ * \class JournalWriter
+ * \brief Writes the edit journals to the disk in a background thread
+ *
+ * The \c JournalWriter thread is shared by all the \c EditJournal objects
+ * of the application. Every \c FLUSH_INTERVAL milliseconds (or when it is
+ * woken up), the writer asks each registered journal to write its pending
+ * records, so the GUI thread never waits for the disk.
+ *
+ * The thread is started with the first journal and it is stopped (after
+ * writing all the pending records) when the application quits.
+ */
+
+/*!
+ * Returns the only instance of the writer, the thread is created and
+ * started the first time this function is called
+ */
+
+JournalWriter *JournalWriter::instance (void) {
+    static JournalWriter *_instance = NULL;
+
+    if (_instance == NULL) {
+        _instance = new JournalWriter (qApp);
+        _instance->start (QThread::LowPriority);
+
+        connect (qApp, SIGNAL (aboutToQuit()), _instance, SLOT (stop()));
+    }
+
+    return _instance;
+}
+
+/*!
+ * \internal
+ * Initializes the writer
+ */
+
+JournalWriter::JournalWriter (QObject *parent) : QThread (parent),
+    m_stop (false),
+    m_flushing (NULL) {
+}
+
+/*!
+ * Adds the given \a {journal} to the list of journals written by this thread
+ */
+
+void JournalWriter::registerJournal (EditJournal *journal) {
+    QMutexLocker _locker (&m_mutex);
+
+    if (!m_journals.contains (journal))
+        m_journals.append (journal);
+}
+
+/*!
+ * Removes the given \a {journal} from the list of journals, the function
+ * only waits if this journal is being written (the other journals are
+ * written without holding the lock)
+ */
+
+void JournalWriter::unregisterJournal (EditJournal *journal) {
+    QMutexLocker _locker (&m_mutex);
+    m_journals.removeAll (journal);
+
+    while (m_flushing == journal)
+        m_flushed.wait (&m_mutex);
+}
+
+/*!
+ * Removes the given journal \a {file} in the writer thread, this is used
+ * by the journals that are destroyed before their file is removed
+ */
+
+void JournalWriter::removeFile (const QString &file) {
+    QMutexLocker _locker (&m_mutex);
+    m_removed_files.append (file);
+}
+
+/*!
+ * Writes the pending records without waiting for the next interval
+ */
+
+void JournalWriter::wake (void) {
+    m_condition.wakeAll();
+}
+
+/*!
+ * Writes the pending records and stops the thread
+ */
+
+void JournalWriter::stop (void) {
+    m_mutex.lock();
+    m_stop = true;
+    m_condition.wakeAll();
+    m_mutex.unlock();
+
+    wait();
+}
+
+/*!
+ * \internal
+ * Flushes the registered journals periodically
+ */
+
+void JournalWriter::run (void) {
+    m_mutex.lock();
+
+    while (!m_stop) {
+        m_condition.wait (&m_mutex, FLUSH_INTERVAL);
+        flush();
+    }
+
+    //
+    // Write the records added after the last flush
+    //
+    flush();
+
+    m_mutex.unlock();
+}
+
+/*!
+ * \internal
+ * Writes the pending records of each journal and removes the files of the
+ * destroyed journals.
+ *
+ * The mutex must be locked by the caller, but it is released during the
+ * disk operations, so that the GUI thread can register or unregister a
+ * journal meanwhile. The journal being written is kept in \c m_flushing,
+ * unregisterJournal() waits until it is written.
+ */
+
+void JournalWriter::flush (void) {
+    QList<EditJournal *> _journals = m_journals;
+    QStringList _removed_files = m_removed_files;
+    m_removed_files.clear();
+
+    foreach (EditJournal *_journal, _journals) {
+        if (!m_journals.contains (_journal))
+            continue;
+
+        m_flushing = _journal;
+        m_mutex.unlock();
+
+        _journal->flush();
+
+        m_mutex.lock();
+        m_flushing = NULL;
+        m_flushed.wakeAll();
+    }
+
+    m_mutex.unlock();
+
+    foreach (const QString &_file, _removed_files)
+        QFile::remove (_file);
+
+    m_mutex.lock();
+}
@@ -0,0 +1,71 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef JOURNAL_WRITER_H
+#define JOURNAL_WRITER_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+class EditJournal;
+
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QStringList>
+#include <QWaitCondition>
+
+class JournalWriter : public QThread {
+        Q_OBJECT
+
+    public:
+        static JournalWriter *instance (void);
+
+        void registerJournal (EditJournal *journal);
+        void unregisterJournal (EditJournal *journal);
+        void removeFile (const QString &file);
+
+    public slots:
+        void wake (void);
+        void stop (void);
+
+    protected:
+        void run (void);
+
+    private:
+        explicit JournalWriter (QObject *parent = 0);
+        void flush (void);
+
+        bool m_stop;
+        QMutex m_mutex;
+        QWaitCondition m_condition;
+        QWaitCondition m_flushed;
+        EditJournal *m_flushing;
+        QStringList m_removed_files;
+        QList<EditJournal *> m_journals;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
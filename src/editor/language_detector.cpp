@@ -0,0 +1,579 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QHash>
+#include <QList>
+#include <QStringList>
+
+#include "language_detector.h"
+#include "language_registry.h"
+
+#define MODELINE_LINES 5
+#define KEYWORD_MIN_SCORE 4
+#define YAML_MIN_LINES 2
+
+/*!
+ * \class LanguageDetector
+ * \brief Guesses the language of a document from its contents
+ *
+ * The \c LanguageDetector is used by the \c LexerDatabase when the name of
+ * a file does not match any language (e.g. scripts without extension).
+ * Only the first \c LANGUAGE_SAMPLE_SIZE bytes of the document are read,
+ * so the detection takes the same time regardless of the file size.
+ *
+ * The following signals are checked, in order:
+ *
+ * - Shebangs, such as \c {#!/usr/bin/env python3}
+ * - Emacs (\c {-*- mode: perl -*-}) and Vim (\c {vim: ft=sh}) modelines
+ *   in the first \c MODELINE_LINES lines
+ * - XML prologs and HTML doctypes
+ * - Unified diffs
+ * - The shape of JSON and YAML documents
+ * - The number of keywords of each language found in the sample
+ *
+ * Interpreter and mode names are resolved with a small table of aliases
+ * and then with the \c LanguageRegistry, so that names such as \c py or
+ * \c yml are treated as file extensions.
+ */
+
+/*!
+ * \internal
+ * Aliases of interpreters and editor modes that do not match the name
+ * or an extension of a language
+ */
+
+static const char *const ALIASES[][2] = {
+    { "sh",           "bash"       },
+    { "zsh",          "bash"       },
+    { "ksh",          "bash"       },
+    { "dash",         "bash"       },
+    { "ash",          "bash"       },
+    { "shell-script", "bash"       },
+    { "c",            "cpp"        },
+    { "c++",          "cpp"        },
+    { "node",         "javascript" },
+    { "nodejs",       "javascript" },
+    { "groovy",       "java"       },
+    { "golang",       "go"         },
+    { "proto",        "protobuf"   },
+    { "make",         "makefile"   },
+    { "gmake",        "makefile"   },
+    { "tclsh",        "tcl"        },
+    { "wish",         "tcl"        },
+    { "latex",        "tex"        },
+    { "dosbatch",     "batch"      },
+    { "octave",       "matlab"     },
+    { "sbcl",         "lisp"       },
+    { "clisp",        "lisp"       },
+    { "emacs-lisp",   "lisp"       },
+    { "runghc",       "haskell"    },
+    { "runhaskell",   "haskell"    },
+};
+
+/*!
+ * \internal
+ * Keywords that are characteristic of each language, the keywords are
+ * compared without regard to case
+ */
+
+static const char *const KEYWORDS[][2] = {
+    { "def",                    "python"     },
+    { "elif",                   "python"     },
+    { "import",                 "python"     },
+    { "self",                   "python"     },
+    { "none",                   "python"     },
+    { "lambda",                 "python"     },
+    { "except",                 "python"     },
+    { "__name__",               "python"     },
+    { "__init__",               "python"     },
+
+    { "#include",               "cpp"        },
+    { "#define",                "cpp"        },
+    { "#ifdef",                 "cpp"        },
+    { "#ifndef",                "cpp"        },
+    { "#endif",                 "cpp"        },
+    { "std",                    "cpp"        },
+    { "nullptr",                "cpp"        },
+    { "namespace",              "cpp"        },
+    { "typedef",                "cpp"        },
+
+    { "fi",                     "bash"       },
+    { "esac",                   "bash"       },
+    { "then",                   "bash"       },
+    { "echo",                   "bash"       },
+    { "export",                 "bash"       },
+    { "done",                   "bash"       },
+
+    { "pipeline",               "java"       },
+    { "stages",                 "java"       },
+    { "stage",                  "java"       },
+    { "steps",                  "java"       },
+    { "agent",                  "java"       },
+    { "println",                "java"       },
+    { "extends",                "java"       },
+    { "implements",             "java"       },
+    { "package",                "java"       },
+
+    { "my",                     "perl"       },
+    { "sub",                    "perl"       },
+    { "use",                    "perl"       },
+    { "elsif",                  "perl"       },
+    { "unless",                 "perl"       },
+    { "chomp",                  "perl"       },
+
+    { "end",                    "ruby"       },
+    { "puts",                   "ruby"       },
+    { "require",                "ruby"       },
+    { "module",                 "ruby"       },
+    { "attr_accessor",          "ruby"       },
+
+    { "local",                  "lua"        },
+    { "function",               "lua"        },
+    { "end",                    "lua"        },
+    { "then",                   "lua"        },
+    { "nil",                    "lua"        },
+    { "elseif",                 "lua"        },
+
+    { "select",                 "sql"        },
+    { "from",                   "sql"        },
+    { "where",                  "sql"        },
+    { "insert",                 "sql"        },
+    { "into",                   "sql"        },
+    { "create",                 "sql"        },
+    { "table",                  "sql"        },
+    { "values",                 "sql"        },
+
+    { "cmake_minimum_required", "cmake"      },
+    { "add_executable",         "cmake"      },
+    { "add_library",            "cmake"      },
+    { "target_link_libraries",  "cmake"      },
+    { "find_package",           "cmake"      },
+
+    { "phony",                  "makefile"   },
+    { "ifeq",                   "makefile"   },
+    { "ifneq",                  "makefile"   },
+};
+
+/*!
+ * \internal
+ * Returns the index of the \c KEYWORDS table, which is built only once
+ */
+
+static const QMultiHash<QByteArray, QString> &keywordIndex (void) {
+    static QMultiHash<QByteArray, QString> _index;
+
+    if (_index.isEmpty()) {
+        int _count = sizeof (KEYWORDS) / sizeof (KEYWORDS[0]);
+        for (int i = 0; i < _count; ++i)
+            _index.insert (QByteArray (KEYWORDS[i][0]), KEYWORDS[i][1]);
+    }
+
+    return _index;
+}
+
+/*!
+ * Returns the language of the given \a data, or an empty string if the
+ * language cannot be guessed. Only the first \c LANGUAGE_SAMPLE_SIZE
+ * bytes of \a data are used.
+ *
+ * The \a registry is used to resolve the names found in shebangs and
+ * modelines, it may be \c NULL.
+ */
+
+QString LanguageDetector::detect (const char *data,
+                                  qint64 length,
+                                  const LanguageRegistry *registry) {
+    if (data == NULL || length <= 0)
+        return QString ("");
+
+    QByteArray _sample = QByteArray::fromRawData (data, qMin (length,
+                                                  (qint64) LANGUAGE_SAMPLE_SIZE));
+
+    //
+    // Skip the UTF-8 BOM and give up with binary (or UTF-16) data
+    //
+    if (_sample.startsWith ("\xEF\xBB\xBF"))
+        _sample = _sample.mid (3);
+
+    if (_sample.contains ('\0'))
+        return QString ("");
+
+    //
+    // Shebangs and modelines
+    //
+    QList<QByteArray> _lines = _sample.split ('\n');
+    QString _language = detectShebang (_lines.first(), registry);
+
+    for (int i = 0; _language.isEmpty() && i < qMin (_lines.count(), MODELINE_LINES); ++i)
+        _language = detectModeline (_lines.at (i), registry);
+
+    if (!_language.isEmpty())
+        return _language;
+
+    //
+    // Markup and patches
+    //
+    _language = detectMarkup (_sample);
+    if (_language.isEmpty())
+        _language = detectDiff (_sample);
+
+    if (!_language.isEmpty())
+        return _language;
+
+    //
+    // Data files
+    //
+    if (looksLikeJson (_sample))
+        return resolve ("json", registry);
+
+    if (looksLikeYaml (_sample))
+        return resolve ("yaml", registry);
+
+    //
+    // Source code
+    //
+    return detectKeywords (_sample);
+}
+
+/*!
+ * \internal
+ * Returns the language that matches the interpreter or mode \a name,
+ * version numbers (e.g. \c python3.11) and mode variants (e.g.
+ * \c makefile-gmake) are ignored if the full name is not known
+ */
+
+QString LanguageDetector::resolve (const QByteArray &name,
+                                   const LanguageRegistry *registry) {
+    QByteArray _name = name.trimmed().toLower();
+
+    QList<QByteArray> _candidates;
+    _candidates.append (_name);
+
+    //
+    // Remove the version number, e.g. "python3.11"
+    //
+    int _end = _name.length();
+    while (_end > 0 && (QChar (_name.at (_end - 1)).isDigit() || _name.at (_end - 1) == '.'))
+        --_end;
+
+    if (_end > 0 && _end < _name.length())
+        _candidates.append (_name.left (_end));
+
+    //
+    // Remove the variant of the mode, e.g. "makefile-gmake"
+    //
+    if (_name.indexOf ('-') > 0)
+        _candidates.append (_name.left (_name.indexOf ('-')));
+
+    int _alias_count = sizeof (ALIASES) / sizeof (ALIASES[0]);
+
+    foreach (QByteArray _candidate, _candidates) {
+        for (int i = 0; i < _alias_count; ++i) {
+            if (_candidate == ALIASES[i][0])
+                return ALIASES[i][1];
+        }
+
+        if (registry == NULL)
+            continue;
+
+        QString _string = QString::fromLatin1 (_candidate);
+        if (registry->languages().contains (_string))
+            return _string;
+
+        QString _language = registry->languageForFile ("file." + _string);
+        if (!_language.isEmpty())
+            return _language;
+    }
+
+    return QString ("");
+}
+
+/*!
+ * \internal
+ * Returns the language of the interpreter given in the shebang \a line,
+ * the arguments of \c env (e.g. \c {#!/usr/bin/env -S python3 -u}) are
+ * skipped
+ */
+
+QString LanguageDetector::detectShebang (const QByteArray &line,
+                                         const LanguageRegistry *registry) {
+    if (!line.startsWith ("#!"))
+        return QString ("");
+
+    QList<QByteArray> _args = line.mid (2).simplified().split (' ');
+    if (_args.isEmpty() || _args.first().isEmpty())
+        return QString ("");
+
+    QByteArray _program = _args.takeFirst();
+    _program = _program.mid (_program.lastIndexOf ('/') + 1);
+
+    if (_program == "env") {
+        _program.clear();
+
+        foreach (QByteArray _arg, _args) {
+            if (!_arg.startsWith ('-') && !_arg.contains ('=')) {
+                _program = _arg.mid (_arg.lastIndexOf ('/') + 1);
+                break;
+            }
+        }
+    }
+
+    if (_program.isEmpty())
+        return QString ("");
+
+    return resolve (_program, registry);
+}
+
+/*!
+ * \internal
+ * Returns the language given in an Emacs or Vim modeline, if the
+ * \a line contains one
+ */
+
+QString LanguageDetector::detectModeline (const QByteArray &line,
+                                          const LanguageRegistry *registry) {
+    //
+    // Emacs, "-*- mode: python; coding: utf-8 -*-" or "-*- python -*-"
+    //
+    int _start = line.indexOf ("-*-");
+    int _end = _start >= 0 ? line.indexOf ("-*-", _start + 3) : -1;
+
+    if (_end > _start) {
+        QByteArray _vars = line.mid (_start + 3, _end - _start - 3).trimmed();
+
+        if (!_vars.contains (':'))
+            return resolve (_vars, registry);
+
+        foreach (QByteArray _var, _vars.split (';')) {
+            int _colon = _var.indexOf (':');
+            if (_colon > 0 && _var.left (_colon).trimmed().toLower() == "mode")
+                return resolve (_var.mid (_colon + 1), registry);
+        }
+    }
+
+    //
+    // Vim, "vim: set ft=sh:" or "vi: syntax=perl"
+    //
+    const char *_markers[] = { "vim:", "vi:", "ex:" };
+    const char *_keys[] = { "filetype=", "ft=", "syntax=", "syn=" };
+
+    for (int m = 0; m < 3; ++m) {
+        int _marker = line.indexOf (_markers[m]);
+        if (_marker < 0 || (_marker > 0 && !QChar (line.at (_marker - 1)).isSpace()))
+            continue;
+
+        QByteArray _options = line.mid (_marker);
+
+        for (int k = 0; k < 4; ++k) {
+            int _key = _options.indexOf (_keys[k]);
+            if (_key <= 0)
+                continue;
+
+            char _before = _options.at (_key - 1);
+            if (_before != ' ' && _before != ':' && _before != '\t')
+                continue;
+
+            int _value = _key + (int) qstrlen (_keys[k]);
+            int _length = 0;
+            while (_value + _length < _options.length() &&
+                    !QByteArray (" :\t\r").contains (_options.at (_value + _length)))
+                ++_length;
+
+            return resolve (_options.mid (_value, _length), registry);
+        }
+    }
+
+    return QString ("");
+}
+
+/*!
+ * \internal
+ * Detects XML and HTML documents
+ */
+
+QString LanguageDetector::detectMarkup (const QByteArray &sample) {
+    QByteArray _start = sample.left (256).trimmed().toLower();
+
+    if (!_start.startsWith ('<'))
+        return QString ("");
+
+    if (_start.startsWith ("<!doctype html") || _start.startsWith ("<html") ||
+            _start.startsWith ("<?php"))
+        return "html";
+
+    if (_start.startsWith ("<?xml")) {
+        if (sample.toLower().contains ("<html"))
+            return "html";
+
+        return "xml";
+    }
+
+    if (_start.length() > 1 && (QChar (_start.at (1)).isLetter() ||
+                                _start.startsWith ("<!--"))) {
+        if (sample.contains ("</") || sample.contains ("/>"))
+            return "xml";
+    }
+
+    return QString ("");
+}
+
+/*!
+ * \internal
+ * Detects unified diffs and patches created by version control systems
+ */
+
+QString LanguageDetector::detectDiff (const QByteArray &sample) {
+    if (sample.startsWith ("diff ") || sample.contains ("\ndiff --git "))
+        return "diff";
+
+    if ((sample.startsWith ("--- ") || sample.contains ("\n--- ")) &&
+            sample.contains ("\n+++ ") && sample.contains ("\n@@ "))
+        return "diff";
+
+    return QString ("");
+}
+
+/*!
+ * \internal
+ * Returns \c true if the \a sample starts like a JSON object or array
+ */
+
+bool LanguageDetector::looksLikeJson (const QByteArray &sample) {
+    QByteArray _start = sample.left (256).simplified();
+    _start.replace (" ", "");
+
+    if (_start.length() < 2)
+        return false;
+
+    if (_start.at (0) == '{')
+        return _start.at (1) == '"' || _start.at (1) == '}';
+
+    if (_start.at (0) == '[') {
+        QByteArray _value = _start.mid (1);
+
+        return QByteArray ("{[\"]-0123456789").contains (_value.at (0)) ||
+               _value.startsWith ("true") ||
+               _value.startsWith ("false") ||
+               _value.startsWith ("null");
+    }
+
+    return false;
+}
+
+/*!
+ * \internal
+ * Returns \c true if most of the lines of the \a sample are YAML
+ * mappings (\c {key: value}) or sequence items (\c {- item})
+ */
+
+bool LanguageDetector::looksLikeYaml (const QByteArray &sample) {
+    if (sample.startsWith ("%YAML") || sample.startsWith ("---\n") ||
+            sample.startsWith ("---\r"))
+        return true;
+
+    int _lines = 0;
+    int _matches = 0;
+
+    foreach (QByteArray _line, sample.split ('\n')) {
+        _line = _line.trimmed();
+
+        if (_line.isEmpty() || _line.startsWith ('#'))
+            continue;
+
+        ++_lines;
+
+        if (_line.startsWith ("- ") || _line == "-") {
+            ++_matches;
+            continue;
+        }
+
+        int _colon = _line.indexOf (':');
+        if (_colon <= 0)
+            continue;
+
+        if (_colon + 1 < _line.length() && _line.at (_colon + 1) != ' ')
+            continue;
+
+        bool _valid_key = true;
+        for (int i = 0; i < _colon && _valid_key; ++i) {
+            char _c = _line.at (i);
+            _valid_key = QChar (_c).isLetterOrNumber() || _c == '_' ||
+                         _c == '-' || _c == '.' || _c == '/';
+        }
+
+        if (_valid_key)
+            ++_matches;
+    }
+
+    return _matches >= YAML_MIN_LINES && _matches * 10 >= _lines * 8;
+}
+
+/*!
+ * \internal
+ * Counts the keywords of each language in the \a sample and returns the
+ * language with the highest score, if it is clearly ahead of the others
+ */
+
+QString LanguageDetector::detectKeywords (const QByteArray &sample) {
+    const QMultiHash<QByteArray, QString> &_index = keywordIndex();
+    QHash<QString, int> _scores;
+
+    int i = 0;
+    while (i < sample.length()) {
+        char _c = sample.at (i);
+
+        if (!QChar (_c).isLetter() && _c != '_' && _c != '#') {
+            ++i;
+            continue;
+        }
+
+        int _start = i++;
+        while (i < sample.length() && (QChar (sample.at (i)).isLetterOrNumber() ||
+                                       sample.at (i) == '_'))
+            ++i;
+
+        QByteArray _word = sample.mid (_start, i - _start).toLower();
+        foreach (QString _language, _index.values (_word))
+            _scores[_language] += 1;
+    }
+
+    QString _best;
+    int _best_score = 0;
+    int _second_score = 0;
+
+    foreach (QString _language, _scores.keys()) {
+        int _score = _scores.value (_language);
+
+        if (_score > _best_score) {
+            _second_score = _best_score;
+            _best_score = _score;
+            _best = _language;
+        }
+
+        else if (_score > _second_score)
+            _second_score = _score;
+    }
+
+    if (_best_score < KEYWORD_MIN_SCORE || _best_score <= _second_score)
+        return QString ("");
+
+    return _best;
+}
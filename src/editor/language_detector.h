@@ -0,0 +1,61 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef LANGUAGE_DETECTOR_H
+#define LANGUAGE_DETECTOR_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+class LanguageRegistry;
+
+#include <QString>
+#include <QByteArray>
+
+#define LANGUAGE_SAMPLE_SIZE 4096
+
+class LanguageDetector {
+    public:
+        static QString detect (const char *data,
+                               qint64 length,
+                               const LanguageRegistry *registry);
+
+    private:
+        static QString resolve (const QByteArray &name,
+                                const LanguageRegistry *registry);
+
+        static QString detectShebang (const QByteArray &line,
+                                      const LanguageRegistry *registry);
+        static QString detectModeline (const QByteArray &line,
+                                       const LanguageRegistry *registry);
+        static QString detectMarkup (const QByteArray &sample);
+        static QString detectDiff (const QByteArray &sample);
+        static bool looksLikeJson (const QByteArray &sample);
+        static bool looksLikeYaml (const QByteArray &sample);
+        static QString detectKeywords (const QByteArray &sample);
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -0,0 +1,209 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QFile>
+#include <QXmlStreamReader>
+
+#include "language_registry.h"
+
+/*!
+ * \class LanguageRegistry
+ * \brief Maps file names to the languages known by the \c LexerDatabase
+ *
+ * The registry is filled from a definitions file, which lists the
+ * extensions, file names and glob patterns of each language:
+ *
+ * \code
+ * <languages>
+ *     <language name="cmake" extensions="cmake" filenames="cmakelists.txt" />
+ * </languages>
+ * \endcode
+ *
+ * All the mappings are stored in hash tables, so finding the language of
+ * a file takes constant time, regardless of the number of languages.
+ * Glob patterns in the form of \c {name.*} are stored in a hash table
+ * too, other patterns are checked one by one as a last resort.
+ */
+
+/*!
+ * Initializes an empty registry
+ */
+
+LanguageRegistry::LanguageRegistry (void) {}
+
+/*!
+ * Removes all the registered languages and mappings
+ */
+
+void LanguageRegistry::clear (void) {
+    m_languages.clear();
+    m_extensions.clear();
+    m_filenames.clear();
+    m_basenames.clear();
+    m_patterns.clear();
+}
+
+/*!
+ * Reads the language definitions stored in the given \a path, returns
+ * \c false if the file cannot be read or if it is not valid.
+ *
+ * The mappings of the file are added to the existing ones, later
+ * definitions override the previous mappings of the same extension,
+ * file name or pattern.
+ */
+
+bool LanguageRegistry::loadDefinitions (const QString &path) {
+    QFile _file (path);
+    if (!_file.open (QFile::ReadOnly))
+        return false;
+
+    QXmlStreamReader _xml (&_file);
+
+    while (!_xml.atEnd() && !_xml.hasError()) {
+        if (_xml.readNext() != QXmlStreamReader::StartElement)
+            continue;
+
+        if (_xml.name() != "language")
+            continue;
+
+        QXmlStreamAttributes _attributes = _xml.attributes();
+        QString _language = _attributes.value ("name").toString();
+
+        if (_language.isEmpty())
+            continue;
+
+        foreach (QString _ext, _attributes.value ("extensions").toString()
+                 .split (" ", QString::SkipEmptyParts))
+            registerExtension (_ext, _language);
+
+        foreach (QString _name, _attributes.value ("filenames").toString()
+                 .split (" ", QString::SkipEmptyParts))
+            registerFilename (_name, _language);
+
+        foreach (QString _pattern, _attributes.value ("patterns").toString()
+                 .split (" ", QString::SkipEmptyParts))
+            registerPattern (_pattern, _language);
+    }
+
+    _file.close();
+    return !_xml.hasError();
+}
+
+/*!
+ * Associates the given file \a extension (without the leading dot)
+ * with the given \a language
+ */
+
+void LanguageRegistry::registerExtension (const QString &extension,
+                                          const QString &language) {
+    if (!m_languages.contains (language))
+        m_languages.append (language);
+
+    m_extensions.insert (extension.toLower(), language);
+}
+
+/*!
+ * Associates the file \a name (e.g. \c makefile) with the given
+ * \a language, the comparison is case-insensitive
+ */
+
+void LanguageRegistry::registerFilename (const QString &name,
+                                         const QString &language) {
+    if (!m_languages.contains (language))
+        m_languages.append (language);
+
+    m_filenames.insert (name.toLower(), language);
+}
+
+/*!
+ * Associates a glob \a pattern (e.g. \c {makefile.*}) with the given
+ * \a language, the comparison is case-insensitive
+ */
+
+void LanguageRegistry::registerPattern (const QString &pattern,
+                                        const QString &language) {
+    if (!m_languages.contains (language))
+        m_languages.append (language);
+
+    //
+    // Patterns such as "makefile.*" only depend on the base name
+    //
+    QString _pattern = pattern.toLower();
+    QString _base = _pattern.left (_pattern.length() - 2);
+    if (_pattern.endsWith (".*") && !_base.contains (QRegExp ("[*?\\[.]"))) {
+        m_basenames.insert (_base, language);
+        return;
+    }
+
+    m_patterns.append (qMakePair (QRegExp (_pattern,
+                                           Qt::CaseInsensitive,
+                                           QRegExp::WildcardUnix),
+                                  language));
+}
+
+/*!
+ * Returns the names of all the registered languages
+ */
+
+QStringList LanguageRegistry::languages (void) const {
+    return m_languages;
+}
+
+/*!
+ * Returns the language of the given \a file, or an empty string if
+ * no registered mapping matches its name.
+ *
+ * The file name is checked first, then its extension, then its
+ * base name and finally the remaining glob patterns.
+ */
+
+QString LanguageRegistry::languageForFile (const QString &file) const {
+    int _slash = qMax (file.lastIndexOf ('/'), file.lastIndexOf ('\\'));
+    QString _name = file.mid (_slash + 1).toLower();
+
+    if (_name.isEmpty())
+        return QString ("");
+
+    QString _language = m_filenames.value (_name);
+    if (!_language.isEmpty())
+        return _language;
+
+    int _last_dot = _name.lastIndexOf ('.');
+    if (_last_dot >= 0) {
+        _language = m_extensions.value (_name.mid (_last_dot + 1));
+        if (!_language.isEmpty())
+            return _language;
+    }
+
+    int _first_dot = _name.indexOf ('.');
+    if (_first_dot >= 0) {
+        _language = m_basenames.value (_name.left (_first_dot));
+        if (!_language.isEmpty())
+            return _language;
+    }
+
+    for (int i = 0; i < m_patterns.count(); ++i) {
+        if (m_patterns.at (i).first.exactMatch (_name))
+            return m_patterns.at (i).second;
+    }
+
+    return QString ("");
+}
@@ -0,0 +1,62 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef LANGUAGE_REGISTRY_H
+#define LANGUAGE_REGISTRY_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QRegExp>
+#include <QString>
+#include <QStringList>
+
+class LanguageRegistry {
+    public:
+        LanguageRegistry (void);
+
+        void clear (void);
+        bool loadDefinitions (const QString &path);
+
+        void registerExtension (const QString &extension, const QString &language);
+        void registerFilename (const QString &name, const QString &language);
+        void registerPattern (const QString &pattern, const QString &language);
+
+        QStringList languages (void) const;
+        QString languageForFile (const QString &file) const;
+
+    private:
+        QStringList m_languages;
+        QHash<QString, QString> m_extensions;
+        QHash<QString, QString> m_filenames;
+        QHash<QString, QString> m_basenames;
+        QList<QPair<QRegExp, QString> > m_patterns;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -20,7 +20,8 @@
 //
 
 #include <QFile>
-#include <QFileInfo>
+#include <QApplication>
+#include <QStandardPaths>
 
 #include <Qsci/qscilexer.h>
 #include <Qsci/qscilexerbash.h>
@@ -55,12 +56,16 @@
 
 #include "theme.h"
 #include "lexer_database.h"
+#include "language_registry.h"
+#include "language_detector.h"
+#include "syntax_grammar.h"
 
 #include "qscilexerada.h"
 #include "qscilexerasm.h"
 #include "qscilexerhaskell.h"
 #include "qscilexerlisp.h"
 #include "qscilexernsis.h"
+#include "qscilexergrammar.h"
 #include "qscilexerplaintext.h"
 
 /*!
@@ -68,266 +73,323 @@
  * \brief Configures appropiate lexers for the \c Editor
  *
  * The \c LexerDatabase is in charge of creating, configuring
- * and loading the correct \c QsciLexer for the \c Editor automatically
+ * and loading the correct \c QsciLexer for the \c Editor automatically.
+ *
+ * A single database is shared by the whole application, together with
+ * the language registry and the compiled grammars. Each lexer is owned by
+ * the object that requested it, so that it is destroyed together with its
+ * editor (which keeps its lexer as long as the language does not change).
+ */
+
+/*!
+ * \internal
+ * Name of the dynamic property used to tag each lexer with its language
+ */
+
+#define LANGUAGE_PROPERTY "thunderpad-language"
+
+/*!
+ * \internal
+ * Location of the bundled language definitions
+ */
+
+#define LANGUAGES_PATH ":/languages/languages.xml"
+
+/*!
+ * \internal
+ * Location of the bundled grammars, used by languages that do not have
+ * a built-in lexer
+ */
+
+#define GRAMMARS_PATH ":/grammars/"
+
+/*!
+ * \internal
+ * Name of the language used when no definition matches a file
+ */
+
+#define FALLBACK_LANGUAGE "plaintext"
+
+/*!
+ * Returns the only instance of the database, which is shared by all the
+ * editors of the application
+ */
+
+LexerDatabase *LexerDatabase::instance (void) {
+    static LexerDatabase *_instance = NULL;
+
+    if (_instance == NULL)
+        _instance = new LexerDatabase (qApp);
+
+    return _instance;
+}
+
+/*!
+ * Returns the language that the given \a lexer was created for, or an
+ * empty string if the lexer was not created by the database
+ */
+
+QString LexerDatabase::languageOf (QsciLexer *lexer) const {
+    if (lexer == NULL)
+        return QString ("");
+
+    return lexer->property (LANGUAGE_PROPERTY).toString();
+}
+
+/*!
+ * Returns the name of the language that should be used to highlight
+ * the given \a file.
+ *
+ * If the file name does not match any language, the language is guessed
+ * from the \a head of the document (its first \c LANGUAGE_SAMPLE_SIZE
+ * bytes) with the \c LanguageDetector.
  */
 
-/*! \internal
- * Initializes the class and configures the theme
+QString LexerDatabase::languageForFile (const QString &file,
+                                        const QByteArray &head) const {
+    QString _language = m_registry->languageForFile (file);
+
+    if (_language.isEmpty())
+        _language = LanguageDetector::detect (head.constData(),
+                                              head.size(),
+                                              m_registry);
+
+    if (_language.isEmpty())
+        return FALLBACK_LANGUAGE;
+
+    return _language;
+}
+
+/*!
+ * Returns the registry that maps file names to languages, it can be used
+ * to register additional extensions, file names or patterns at run-time
  */
 
-LexerDatabase::LexerDatabase (void) {}
+LanguageRegistry *LexerDatabase::registry (void) const {
+    return m_registry;
+}
 
 /*!
  * Creates a new lexer based on the \c file name and
  * configures it to fit the needs of the \a Editor.
+ *
+ * The returned lexer is owned by \a parent.
  */
 
-QsciLexer *LexerDatabase::getLexer (const QString &file, Theme *theme) {
-    QsciLexer *_lexer = _guessByName (file);
+QsciLexer *LexerDatabase::getLexer (const QString &file, Theme *theme,
+                                    QObject *parent) {
+    return lexerForLanguage (languageForFile (file), theme, parent);
+}
 
-    _lexer->setDefaultColor (theme->foreground());
-    _lexer->setDefaultPaper (theme->background());
+/*!
+ * Creates a new lexer for the given \a language and applies the colors
+ * of the \a theme to it, the returned lexer is owned by \a parent
+ */
 
-    _lexer->setAutoIndentStyle (QsciScintilla::AiOpening ||
-                                QsciScintilla::AiClosing);
+QsciLexer *LexerDatabase::lexerForLanguage (const QString &language, Theme *theme,
+                                            QObject *parent) {
+    QsciLexer *_lexer = _createLexer (language);
 
-    _lexer->refreshProperties();
+    _lexer->setParent (parent);
+    _lexer->setProperty (LANGUAGE_PROPERTY, language);
+    applyTheme (_lexer, theme);
 
     return _lexer;
 }
 
+/*!
+ * Re-applies the colors of the given \a theme to an existing \a lexer,
+ * this allows the editors to keep their lexer when the settings change
+ */
+
+void LexerDatabase::applyTheme (QsciLexer *lexer, Theme *theme) {
+    if (lexer == NULL || theme == NULL)
+        return;
+
+    lexer->setDefaultColor (theme->foreground());
+    lexer->setDefaultPaper (theme->background());
+
+    lexer->setAutoIndentStyle (QsciScintilla::AiOpening ||
+                               QsciScintilla::AiClosing);
+
+    lexer->refreshProperties();
+}
+
 /*!
  * \internal
- * Returns a appropiate QsciLexer given the input \a {file}
+ * Initializes the class and loads the bundled language definitions,
+ * followed by the (optional) definitions of the user, which are stored
+ * in the data directory of the application
  */
 
-QsciLexer *LexerDatabase::_guessByName (const QString &file) {
-    QsciLexer *lexer;
-    QFile _file (file);
-    QString s = QFileInfo (_file).suffix().toLower();
-    QString n = QFileInfo (_file).baseName().toLower();
+LexerDatabase::LexerDatabase (QObject *parent) : QObject (parent) {
+    m_registry = new LanguageRegistry();
+    m_registry->loadDefinitions (LANGUAGES_PATH);
+    m_registry->loadDefinitions (QStandardPaths::writableLocation (
+                                     QStandardPaths::DataLocation) +
+                                 "/languages.xml");
+}
 
-    //
-    // Ada
-    //
-    if (s == "adb" || s == "ads")
-        lexer = new QsciLexerAda();
+/*!
+ * \internal
+ * Deletes the language registry and the compiled grammars
+ */
 
-    //
-    // Assembly
-    //
-    else if (s == "s" || s == "asm")
-        lexer = new QsciLexerASM();
+LexerDatabase::~LexerDatabase (void) {
+    delete m_registry;
+    qDeleteAll (m_grammars);
+}
 
-    //
-    // Haskell
-    //
-    else if (s == "hs" || s == "lhs")
-        lexer = new QsciLexerHaskell();
+/*!
+ * \internal
+ * Returns the compiled grammar of the given \a language, or \c NULL if
+ * the language has no valid grammar.
+ *
+ * The grammar is looked up in the data directory of the application
+ * first, and then in the bundled grammars. Each grammar is compiled
+ * only once and shared by all the lexers of the language.
+ */
 
-    //
-    // Lisp
-    //
-    else if (s == "lisp" || s == "cl")
-        lexer = new QsciLexerLisp();
+const SyntaxGrammar *LexerDatabase::grammar (const QString &language) {
+    if (m_grammars.contains (language))
+        return m_grammars.value (language);
 
-    //
-    // NSIS
-    //
-    else if (s == "nsi")
-        lexer = new QsciLexerNSIS();
+    QStringList _paths;
+    _paths.append (QStandardPaths::writableLocation (QStandardPaths::DataLocation) +
+                   "/grammars/" + language + ".xml");
+    _paths.append (GRAMMARS_PATH + language + ".xml");
 
-    //
-    // Bash files
-    //
-    else if (s == "sh" || s == "bsh")
-        lexer = new QsciLexerBash();
+    SyntaxGrammar *_grammar = NULL;
+    foreach (QString _path, _paths) {
+        if (!QFile::exists (_path))
+            continue;
 
-    //
-    // Batch files
-    //
-    else if (s == "cmd" || s == "bat" ||
-             s == "btm" || s == "nt")
-        lexer = new QsciLexerBatch();
+        _grammar = new SyntaxGrammar();
+        if (_grammar->load (_path))
+            break;
 
-    //
-    // CMake files
-    //
-    else if (s == "cmake" || n == "cmakelists")
-        lexer = new QsciLexerCMake();
+        delete _grammar;
+        _grammar = NULL;
+    }
 
-    //
-    // C and C++ files
-    //
-    else if (s == "cpp" || s == "cxx" ||
-             s == "cc"  || s == "c"   ||
-             s == "h"   || s == "hh"  ||
-             s == "hpp")
-        lexer = new QsciLexerCPP();
+    m_grammars.insert (language, _grammar);
+    return _grammar;
+}
 
-    //
-    // C# files
-    //
-    else if (s == "cs")
-        lexer = new QsciLexerCSharp();
+/*!
+ * \internal
+ * Creates a new, unconfigured lexer for the given \a {language}
+ */
 
-    //
-    // CSS files
-    //
-    else if (s == "css")
-        lexer = new QsciLexerCSS();
+QsciLexer *LexerDatabase::_createLexer (const QString &language) {
+    if (language == "ada")
+        return new QsciLexerAda();
 
-    //
-    // D files
-    //
-    else if (s == "d")
-        lexer = new QsciLexerD();
+    else if (language == "asm")
+        return new QsciLexerASM();
 
-    //
-    // Diff
-    //
-    else if (s == "diff" || s == "patch")
-        lexer = new QsciLexerDiff();
+    else if (language == "haskell")
+        return new QsciLexerHaskell();
 
-    //
-    // Fortran files
-    //
-    else if (s == "f90" || s == "f95" ||
-             s == "f03" || s == "f15" ||
-             s == "f2k")
-        lexer = new QsciLexerFortran();
+    else if (language == "lisp")
+        return new QsciLexerLisp();
 
-    //
-    // Fortran77 files
-    //
-    else if (s == "f" || s == "for")
-        lexer = new QsciLexerFortran77();
+    else if (language == "nsis")
+        return new QsciLexerNSIS();
 
-    //
-    // HTML
-    //
-    else if (s == "html" || s == "htm")
-        lexer = new QsciLexerHTML();
+    else if (language == "bash")
+        return new QsciLexerBash();
 
-    //
-    // Java
-    //
-    else if (s == "java")
-        lexer = new QsciLexerJava();
+    else if (language == "batch")
+        return new QsciLexerBatch();
 
-    //
-    // Javascript
-    //
-    else if (s == "js")
-        lexer = new QsciLexerJavaScript();
+    else if (language == "cmake")
+        return new QsciLexerCMake();
 
-    //
-    // Lua
-    //
-    else if (s == "lua")
-        lexer = new QsciLexerLua();
+    else if (language == "cpp")
+        return new QsciLexerCPP();
 
-    //
-    // Makefile
-    //
-    else if (s == "mak" || n == "gnumakefile" ||
-             n == "makefile")
-        lexer = new QsciLexerMakefile();
+    else if (language == "csharp")
+        return new QsciLexerCSharp();
 
-    //
-    // Matlab
-    //
-    else if (s == "m")
-        lexer = new QsciLexerMatlab();
+    else if (language == "css")
+        return new QsciLexerCSS();
 
-    //
-    // Pascal
-    //
-    else if (s == "pas" || s == "inc")
-        lexer = new QsciLexerPascal();
+    else if (language == "d")
+        return new QsciLexerD();
 
-    //
-    // Perl
-    //
-    else if (s == "pl" || s == "pm" ||
-             s == "plx")
-        lexer = new QsciLexerPerl();
+    else if (language == "diff")
+        return new QsciLexerDiff();
 
-    //
-    // Postscript
-    //
-    else if (s == "ps")
-        lexer = new QsciLexerPostScript();
+    else if (language == "fortran")
+        return new QsciLexerFortran();
 
-    //
-    // Python
-    //
-    else if (s == "py" || s == "pyw")
-        lexer = new QsciLexerPython();
+    else if (language == "fortran77")
+        return new QsciLexerFortran77();
 
-    //
-    // Ruby
-    //
-    else if (s == "rb" || s == "rbw")
-        lexer = new QsciLexerRuby();
+    else if (language == "html")
+        return new QsciLexerHTML();
 
-    //
-    // Spice
-    //
-    else if (s == "cir")
-        lexer = new QsciLexerSpice();
+    else if (language == "java")
+        return new QsciLexerJava();
 
-    //
-    // SQL
-    //
-    else if (s == "sql")
-        lexer = new QsciLexerSQL();
+    else if (language == "javascript")
+        return new QsciLexerJavaScript();
 
-    //
-    // TCL
-    //
-    else if (s == "tcl")
-        lexer = new QsciLexerTCL();
+    else if (language == "lua")
+        return new QsciLexerLua();
 
-    //
-    // TeX
-    //
-    else if (s == "tex")
-        lexer = new QsciLexerTeX();
+    else if (language == "makefile")
+        return new QsciLexerMakefile();
 
-    //
-    // Verilog
-    //
-    else if (s == "v"  || s == "sv" ||
-             s == "vh" || s == "svh")
-        lexer = new QsciLexerVerilog();
+    else if (language == "matlab")
+        return new QsciLexerMatlab();
 
-    //
-    // VHDL
-    //
-    else if (s == "vhd" || s == " vhdl")
-        lexer = new QsciLexerVHDL();
+    else if (language == "pascal")
+        return new QsciLexerPascal();
 
-    //
-    // XML
-    //
-    else if (s == "xml"  || s == "xsl"  ||
-             s == "xsml" || s == "xsd"  ||
-             s == "kml"  || s == "wsdl" ||
-             s == "xlf"  || s == "xliff")
-        lexer = new QsciLexerXML();
+    else if (language == "perl")
+        return new QsciLexerPerl();
 
-    //
-    // YAML
-    //
-    else if (s == "yml")
-        lexer = new QsciLexerYAML();
+    else if (language == "postscript")
+        return new QsciLexerPostScript();
+
+    else if (language == "python")
+        return new QsciLexerPython();
+
+    else if (language == "ruby")
+        return new QsciLexerRuby();
+
+    else if (language == "spice")
+        return new QsciLexerSpice();
+
+    else if (language == "sql")
+        return new QsciLexerSQL();
+
+    else if (language == "tcl")
+        return new QsciLexerTCL();
+
+    else if (language == "tex")
+        return new QsciLexerTeX();
+
+    else if (language == "verilog")
+        return new QsciLexerVerilog();
+
+    else if (language == "vhdl")
+        return new QsciLexerVHDL();
+
+    else if (language == "xml")
+        return new QsciLexerXML();
+
+    else if (language == "yaml")
+        return new QsciLexerYAML();
 
     //
-    // Other shit
+    // Languages without a built-in lexer may have a grammar
     //
-    else
-        lexer = new QsciLexerPlainText();
+    const SyntaxGrammar *_grammar = grammar (language);
+    if (_grammar != NULL)
+        return new QsciLexerGrammar (_grammar);
 
-    return lexer;
+    return new QsciLexerPlainText();
 }
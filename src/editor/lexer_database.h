@@ -28,20 +28,41 @@ extern "C++" {
 
 class Theme;
 class QsciLexer;
+class SyntaxGrammar;
+class LanguageRegistry;
 
+#include <QHash>
 #include <QObject>
+#include <QByteArray>
 
 class LexerDatabase : public QObject {
         Q_OBJECT
 
     public:
-        explicit LexerDatabase (void);
+        static LexerDatabase *instance (void);
+
+        QString languageOf (QsciLexer *lexer) const;
+        QString languageForFile (const QString &file,
+                                 const QByteArray &head = QByteArray()) const;
+
+        LanguageRegistry *registry (void) const;
 
     public slots:
-        QsciLexer *getLexer (const QString &file, Theme *theme);
+        QsciLexer *getLexer (const QString &file, Theme *theme, QObject *parent);
+        QsciLexer *lexerForLanguage (const QString &language, Theme *theme, QObject *parent);
+        void applyTheme (QsciLexer *lexer, Theme *theme);
+
+    protected:
+        explicit LexerDatabase (QObject *parent = 0);
+        ~LexerDatabase (void);
 
     private:
-        QsciLexer *_guessByName (const QString &file);
+        const SyntaxGrammar *grammar (const QString &language);
+
+        QsciLexer *_createLexer (const QString &language);
+
+        LanguageRegistry *m_registry;
+        QHash<QString, SyntaxGrammar *> m_grammars;
 };
 
 #endif
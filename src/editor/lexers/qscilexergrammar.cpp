@@ -0,0 +1,403 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <QFont>
+#include <QColor>
+#include <QString>
+#include <QRegularExpression>
+#include <Qsci/qsciscintilla.h>
+
+#include "syntax_grammar.h"
+#include "qscilexergrammar.h"
+
+/*!
+ * \class QsciLexerGrammar
+ * \brief Styles a document with the rules of a \c SyntaxGrammar
+ *
+ * The lexer works one line at a time. The stack of grammar states at the
+ * end of each line is stored in the line state of Scintilla, so that
+ * styling can resume at any line.
+ *
+ * After an edit, Scintilla asks the lexer to style the text from the
+ * modified line. The lexer keeps track of the lines that have been
+ * modified since the last run, and as soon as the state at the end of a
+ * line (past the modified ones) is the same as in the previous run, the
+ * styles that follow are still valid and styling stops there.
+ */
+
+/*!
+ * \internal
+ * The state stack is packed in an integer: the lowest bits hold the
+ * depth and each level uses \c STACK_BITS bits. The first state of the
+ * grammar is always at the bottom of the stack and is not stored.
+ */
+
+#define DEPTH_BITS 3
+#define STACK_BITS 4
+#define MAX_DEPTH 7
+
+/*!
+ * \internal
+ * Returns the state at the top of the \a stack
+ */
+
+static int topState (int stack) {
+    int _depth = stack & MAX_DEPTH;
+
+    if (_depth == 0)
+        return 0;
+
+    return (stack >> (DEPTH_BITS + STACK_BITS * (_depth - 1))) & ((1 << STACK_BITS) - 1);
+}
+
+/*!
+ * \internal
+ * Pushes the \a state into the \a stack, the top of the stack is
+ * replaced if the stack is full
+ */
+
+static int pushState (int stack, int state) {
+    int _depth = stack & MAX_DEPTH;
+
+    if (_depth == MAX_DEPTH) {
+        int _shift = DEPTH_BITS + STACK_BITS * (_depth - 1);
+        return (stack & ~(((1 << STACK_BITS) - 1) << _shift)) | (state << _shift);
+    }
+
+    stack = (stack & ~MAX_DEPTH) | (_depth + 1);
+    return stack | (state << (DEPTH_BITS + STACK_BITS * _depth));
+}
+
+/*!
+ * \internal
+ * Removes the top state from the \a stack
+ */
+
+static int popState (int stack) {
+    int _depth = stack & MAX_DEPTH;
+
+    if (_depth == 0)
+        return stack;
+
+    stack &= ~(((1 << STACK_BITS) - 1) << (DEPTH_BITS + STACK_BITS * (_depth - 1)));
+    return (stack & ~MAX_DEPTH) | (_depth - 1);
+}
+
+/*!
+ * \internal
+ * Returns the number of bytes that the \a length characters of \a text
+ * starting at \a from use when encoded in UTF-8
+ */
+
+static int utf8Length (const QString &text, int from, int length) {
+    int _bytes = 0;
+
+    for (int i = from; i < from + length; ++i) {
+        ushort _c = text.at (i).unicode();
+
+        if (_c < 0x80)
+            _bytes += 1;
+
+        else if (_c < 0x800)
+            _bytes += 2;
+
+        else if (QChar::isHighSurrogate (_c) || QChar::isLowSurrogate (_c))
+            _bytes += 2;
+
+        else
+            _bytes += 3;
+    }
+
+    return _bytes;
+}
+
+/*!
+ * Creates a lexer that uses the given \a grammar, the grammar is not
+ * owned by the lexer and must outlive it
+ */
+
+QsciLexerGrammar::QsciLexerGrammar (const SyntaxGrammar *grammar, QObject *parent) :
+    QsciLexerCustom (parent) {
+    Q_ASSERT (grammar != NULL);
+
+    m_grammar = grammar;
+    m_language = grammar->name().toUtf8();
+    m_dirty_line = -1;
+}
+
+/*!
+ * Returns the name of the language of the grammar
+ */
+
+const char *QsciLexerGrammar::language() const {
+    return m_language.constData();
+}
+
+/*!
+ * Returns the description of the given \a style, or an empty string if
+ * the grammar does not use the style
+ */
+
+QString QsciLexerGrammar::description (int style) const {
+    if (style >= 0 && style < m_grammar->styleCount())
+        return m_grammar->style (style).description;
+
+    return QString ("");
+}
+
+/*!
+ * Returns the color that the grammar uses for the given \a style
+ */
+
+QColor QsciLexerGrammar::defaultColor (int style) const {
+    if (style >= 0 && style < m_grammar->styleCount() &&
+            m_grammar->style (style).color.isValid())
+        return m_grammar->style (style).color;
+
+    return QsciLexer::defaultColor (style);
+}
+
+/*!
+ * Returns the default font, in bold or italics if the grammar
+ * says so for the given \a style
+ */
+
+QFont QsciLexerGrammar::defaultFont (int style) const {
+    QFont _font = QsciLexer::defaultFont (style);
+
+    if (style >= 0 && style < m_grammar->styleCount()) {
+        _font.setBold (m_grammar->style (style).bold);
+        _font.setItalic (m_grammar->style (style).italic);
+    }
+
+    return _font;
+}
+
+/*!
+ * Attaches the lexer to the given \a editor, and watches its
+ * modifications to know which lines must be styled again
+ */
+
+void QsciLexerGrammar::setEditor (QsciScintilla *editor) {
+    if (this->editor() != NULL)
+        disconnect (this->editor(),
+                    SIGNAL (SCN_MODIFIED (int, int, const char *, int, int, int, int, int, int, int)),
+                    this,
+                    SLOT (onModified (int, int, const char *, int, int)));
+
+    QsciLexerCustom::setEditor (editor);
+    m_dirty_line = -1;
+
+    if (editor != NULL)
+        connect (editor,
+                 SIGNAL (SCN_MODIFIED (int, int, const char *, int, int, int, int, int, int, int)),
+                 this,
+                 SLOT (onModified (int, int, const char *, int, int)));
+}
+
+/*!
+ * Styles the text between \a start and \a end, starting at the
+ * beginning of the line that contains \a start
+ */
+
+void QsciLexerGrammar::styleText (int start, int end) {
+    QsciScintilla *_editor = editor();
+    if (_editor == NULL)
+        return;
+
+    int _line = _editor->SendScintilla (QsciScintilla::SCI_LINEFROMPOSITION, start);
+    int _last = _editor->SendScintilla (QsciScintilla::SCI_LINEFROMPOSITION, end);
+    int _pos = _editor->SendScintilla (QsciScintilla::SCI_POSITIONFROMLINE, _line);
+
+    int _stack = 0;
+    if (_line > 0)
+        _stack = qMax (0, (int) _editor->SendScintilla (QsciScintilla::SCI_GETLINESTATE,
+                                                        _line - 1) - 1);
+
+    startStyling (_pos);
+
+    for (; _line <= _last; ++_line) {
+        int _length = _editor->SendScintilla (QsciScintilla::SCI_LINELENGTH, _line);
+        int _previous = _editor->SendScintilla (QsciScintilla::SCI_GETLINESTATE, _line);
+
+        QByteArray _text (_length, 0);
+        if (_length > 0)
+            _editor->SendScintilla (QsciScintilla::SCI_GETTEXTRANGE,
+                                    (long) _pos, (long) (_pos + _length), _text.data());
+
+        _stack = styleLine (_text, _stack);
+        _pos += _length;
+
+        //
+        // Line states are stored with an offset of one, so that lines that
+        // were never styled do not match any state
+        //
+        _editor->SendScintilla (QsciScintilla::SCI_SETLINESTATE, _line, _stack + 1);
+
+        //
+        // The following lines were not modified and start with the same
+        // state as before, their styles are still valid
+        //
+        if (m_dirty_line >= 0 && _line > m_dirty_line && _previous == _stack + 1) {
+            startStyling (qMax (_pos, end));
+            break;
+        }
+    }
+
+    if (_line > m_dirty_line)
+        m_dirty_line = -1;
+}
+
+/*!
+ * \internal
+ * Updates the last modified line when text is inserted or removed
+ */
+
+void QsciLexerGrammar::onModified (int position, int type, const char *text,
+                                   int length, int lines_added) {
+    Q_UNUSED (text);
+    Q_UNUSED (length);
+
+    if (! (type & (QsciScintilla::SC_MOD_INSERTTEXT | QsciScintilla::SC_MOD_DELETETEXT)))
+        return;
+
+    int _line = editor()->SendScintilla (QsciScintilla::SCI_LINEFROMPOSITION, position);
+
+    if (m_dirty_line >= _line)
+        m_dirty_line = qMax (_line, m_dirty_line + lines_added);
+
+    m_dirty_line = qMax (m_dirty_line, _line + qMax (lines_added, 0));
+}
+
+/*!
+ * \internal
+ * Adds \a bytes with the given \a style to the current run of the line.
+ * Adjacent tokens with the same style are styled at once, and the
+ * length is limited to the bytes left in the line (in case that the line
+ * is not valid UTF-8)
+ */
+
+void QsciLexerGrammar::addRun (int style, int bytes, int *run_style,
+                               int *run_bytes, int *bytes_left) {
+    bytes = qMin (bytes, *bytes_left);
+
+    if (style != *run_style && *run_bytes > 0) {
+        setStyling (*run_bytes, *run_style);
+        *run_bytes = 0;
+    }
+
+    *run_style = style;
+    *run_bytes += bytes;
+    *bytes_left -= bytes;
+}
+
+/*!
+ * \internal
+ * Styles a single line of \a text, which must be the next unstyled line,
+ * and returns the state stack at the end of the line
+ */
+
+int QsciLexerGrammar::styleLine (const QByteArray &text, int stack) {
+    QString _line = QString::fromUtf8 (text);
+    const GrammarState *_state = &m_grammar->state (topState (stack));
+
+    int _run_style = -1;
+    int _run_bytes = 0;
+    int _bytes_left = text.length();
+
+    int i = 0;
+    while (i < _line.length()) {
+        int _index = SyntaxGrammar::dispatchIndex (_line.at (i).unicode());
+        const QVector<int> &_rules = _state->dispatch.at (_index);
+
+        //
+        // No rule can start here, skip all the characters that cannot
+        // start a rule either
+        //
+        if (_rules.isEmpty()) {
+            int j = i + 1;
+            while (j < _line.length() && _state->dispatch.at (
+                        SyntaxGrammar::dispatchIndex (_line.at (j).unicode())).isEmpty())
+                ++j;
+
+            addRun (_state->style, utf8Length (_line, i, j - i),
+                    &_run_style, &_run_bytes, &_bytes_left);
+            i = j;
+            continue;
+        }
+
+        bool _matched = false;
+        foreach (int _rule_index, _rules) {
+            const GrammarRule &_rule = _state->rules.at (_rule_index);
+
+            QRegularExpressionMatch _match = _rule.regex.match (
+                                                 _line, i,
+                                                 QRegularExpression::NormalMatch,
+                                                 QRegularExpression::AnchoredMatchOption);
+
+            if (!_match.hasMatch() || _match.capturedLength() == 0)
+                continue;
+
+            int _style = _rule.style;
+            if (!_rule.keywords.isEmpty())
+                _style = _rule.keywords.value (_match.captured(), _style);
+
+            addRun (_style, utf8Length (_line, i, _match.capturedLength()),
+                    &_run_style, &_run_bytes, &_bytes_left);
+            i += _match.capturedLength();
+
+            for (int p = 0; p < _rule.pop; ++p)
+                stack = popState (stack);
+
+            if (_rule.push >= 0)
+                stack = pushState (stack, _rule.push);
+
+            _state = &m_grammar->state (topState (stack));
+            _matched = true;
+            break;
+        }
+
+        if (!_matched) {
+            int _chars = 1;
+            if (_line.at (i).isHighSurrogate() && i + 1 < _line.length())
+                _chars = 2;
+
+            addRun (_state->style, utf8Length (_line, i, _chars),
+                    &_run_style, &_run_bytes, &_bytes_left);
+            i += _chars;
+        }
+    }
+
+    if (_bytes_left > 0)
+        addRun (_state->style, _bytes_left,
+                &_run_style, &_run_bytes, &_bytes_left);
+
+    if (_run_bytes > 0)
+        setStyling (_run_bytes, _run_style);
+
+    //
+    // Single-line states (e.g. strings) end with the line
+    //
+    while ((stack & MAX_DEPTH) > 0 && m_grammar->state (topState (stack)).single_line)
+        stack = popState (stack);
+
+    return stack;
+}
@@ -0,0 +1,67 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef QSCILEXER_GRAMMAR_H
+#define QSCILEXER_GRAMMAR_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+class SyntaxGrammar;
+
+#include <QByteArray>
+#include <Qsci/qscilexercustom.h>
+
+class QsciLexerGrammar : public QsciLexerCustom {
+
+        Q_OBJECT
+
+    public:
+        explicit QsciLexerGrammar (const SyntaxGrammar *grammar, QObject *parent = 0);
+
+        const char *language() const;
+        QString description (int style) const;
+        QColor defaultColor (int style) const;
+        QFont defaultFont (int style) const;
+
+        void setEditor (QsciScintilla *editor);
+        void styleText (int start, int end);
+
+    private slots:
+        void onModified (int position, int type, const char *text, int length,
+                         int lines_added);
+
+    private:
+        void addRun (int style, int bytes, int *run_style,
+                     int *run_bytes, int *bytes_left);
+        int styleLine (const QByteArray &text, int stack);
+
+        const SyntaxGrammar *m_grammar;
+        QByteArray m_language;
+        int m_dirty_line;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -0,0 +1,243 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <string.h>
+
+#include <QFile>
+#include <QMutexLocker>
+
+#include "line_indexer.h"
+
+#define INDEX_STRIDE 4096
+#define SCAN_SLICE_SIZE 67108864
+
+/*!
+ * \class LineIndexer
+ * \brief Builds a sparse line-offset index of a file
+ *
+ * The \c LineIndexer scans a file in a separate thread and records the
+ * offset of the first byte of every \c INDEX_STRIDE lines. The index allows
+ * the \c FileViewer to jump to any line of a huge file by scanning at most
+ * \c INDEX_STRIDE lines, while using a very small amount of memory.
+ *
+ * The file is mapped in slices of \c SCAN_SLICE_SIZE bytes, so that the
+ * scan also works with files that do not fit in the address space.
+ */
+
+/*!
+ * \internal
+ * Initializes the indexer, the scan starts when the thread is started
+ */
+
+LineIndexer::LineIndexer (const QString &file, QObject *parent) : QThread (parent),
+    m_file (file),
+    m_lines (1),
+    m_indexed (0),
+    m_complete (false),
+    m_cancelled (0) {
+    m_offsets.append (0);
+}
+
+/*!
+ * Returns the number of lines found so far
+ */
+
+qint64 LineIndexer::lineCount (void) const {
+    QMutexLocker _locker (&m_mutex);
+    return m_lines;
+}
+
+/*!
+ * Returns the number of bytes that have been scanned so far
+ */
+
+qint64 LineIndexer::indexedBytes (void) const {
+    QMutexLocker _locker (&m_mutex);
+    return m_indexed;
+}
+
+/*!
+ * Returns \c {true} if the whole file has been scanned
+ */
+
+bool LineIndexer::isComplete (void) const {
+    QMutexLocker _locker (&m_mutex);
+    return m_complete;
+}
+
+/*!
+ * Finds the closest indexed line before (or at) the given \a {line} and
+ * writes its line number and offset in \a {point_line} and \a {point_offset}.
+ *
+ * Returns \c {false} if the file has not been indexed up to \a {line} yet.
+ */
+
+bool LineIndexer::findLine (qint64 line, qint64 *point_line, qint64 *point_offset) const {
+    Q_ASSERT (point_line != NULL);
+    Q_ASSERT (point_offset != NULL);
+
+    QMutexLocker _locker (&m_mutex);
+
+    if (line < 0 || (line >= m_lines && !m_complete))
+        return false;
+
+    qint64 _index = qMin (line / INDEX_STRIDE, (qint64) m_offsets.count() - 1);
+    *point_line = _index * INDEX_STRIDE;
+    *point_offset = m_offsets.at (_index);
+
+    return true;
+}
+
+/*!
+ * Finds the closest indexed line that starts before (or at) the given
+ * \a {offset} and writes its line number and offset in \a {point_line}
+ * and \a {point_offset}.
+ *
+ * Returns \c {false} if the file has not been indexed up to \a {offset} yet.
+ */
+
+bool LineIndexer::findOffset (qint64 offset, qint64 *point_line, qint64 *point_offset) const {
+    Q_ASSERT (point_line != NULL);
+    Q_ASSERT (point_offset != NULL);
+
+    QMutexLocker _locker (&m_mutex);
+
+    if (offset < 0 || (offset > m_indexed && !m_complete))
+        return false;
+
+    //
+    // Binary search the last index point before the offset
+    //
+    int _low = 0;
+    int _high = m_offsets.count() - 1;
+
+    while (_low < _high) {
+        int _middle = (_low + _high + 1) / 2;
+
+        if (m_offsets.at (_middle) <= offset)
+            _low = _middle;
+
+        else
+            _high = _middle - 1;
+    }
+
+    *point_line = (qint64) _low * INDEX_STRIDE;
+    *point_offset = m_offsets.at (_low);
+
+    return true;
+}
+
+/*!
+ * Returns the number of line feeds in the given \a {data}
+ */
+
+qint64 LineIndexer::countLines (const char *data, qint64 length) {
+    qint64 _lines = 0;
+    const char *_end = data + length;
+
+    while (data < _end) {
+        data = static_cast<const char *> (memchr (data, '\n', _end - data));
+
+        if (data == NULL)
+            break;
+
+        ++data;
+        ++_lines;
+    }
+
+    return _lines;
+}
+
+/*!
+ * Stops the scan as soon as possible
+ */
+
+void LineIndexer::cancel (void) {
+    m_cancelled.store (1);
+}
+
+/*!
+ * \internal
+ * Scans the file slice by slice and records an index point every
+ * \c INDEX_STRIDE lines
+ */
+
+void LineIndexer::run (void) {
+    QFile _file (m_file);
+
+    if (!_file.open (QIODevice::ReadOnly))
+        return;
+
+    qint64 _size = _file.size();
+    qint64 _lines = 1;
+    qint64 _next_point = INDEX_STRIDE;
+
+    for (qint64 _start = 0; _start < _size; _start += SCAN_SLICE_SIZE) {
+        if (m_cancelled.load() != 0)
+            return;
+
+        qint64 _length = qMin ((qint64) SCAN_SLICE_SIZE, _size - _start);
+        uchar *_slice = _file.map (_start, _length);
+
+        if (_slice == NULL)
+            return;
+
+        //
+        // Find each line feed of the slice and record the start
+        // of the next line when we reach an index point
+        //
+        QVector<qint64> _points;
+        const char *_data = reinterpret_cast<const char *> (_slice);
+        const char *_end = _data + _length;
+        const char *_cursor = _data;
+
+        while (_cursor < _end) {
+            _cursor = static_cast<const char *> (memchr (_cursor, '\n', _end - _cursor));
+
+            if (_cursor == NULL)
+                break;
+
+            ++_cursor;
+            ++_lines;
+
+            if (_lines - 1 == _next_point) {
+                _points.append (_start + (_cursor - _data));
+                _next_point += INDEX_STRIDE;
+            }
+        }
+
+        _file.unmap (_slice);
+
+        //
+        // Publish the results of this slice
+        //
+        m_mutex.lock();
+        m_lines = _lines;
+        m_indexed = _start + _length;
+        m_offsets += _points;
+        m_mutex.unlock();
+
+        emit progress ((int) ((_start + _length) * 100 / _size));
+    }
+
+    QMutexLocker _locker (&m_mutex);
+    m_complete = true;
+}
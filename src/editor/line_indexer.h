@@ -0,0 +1,72 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef LINE_INDEXER_H
+#define LINE_INDEXER_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+#include <QAtomicInt>
+
+class LineIndexer : public QThread {
+        Q_OBJECT
+
+    public:
+        explicit LineIndexer (const QString &file, QObject *parent = 0);
+
+        qint64 lineCount (void) const;
+        qint64 indexedBytes (void) const;
+        bool isComplete (void) const;
+
+        bool findLine (qint64 line, qint64 *point_line, qint64 *point_offset) const;
+        bool findOffset (qint64 offset, qint64 *point_line, qint64 *point_offset) const;
+
+        static qint64 countLines (const char *data, qint64 length);
+
+    signals:
+        void progress (int percent);
+
+    public slots:
+        void cancel (void);
+
+    protected:
+        void run (void);
+
+    private:
+        QString m_file;
+        qint64 m_lines;
+        qint64 m_indexed;
+        bool m_complete;
+        QVector<qint64> m_offsets;
+        QAtomicInt m_cancelled;
+        mutable QMutex m_mutex;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -0,0 +1,645 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <ctype.h>
+
+#include <QFile>
+#include <QStringList>
+#include <QXmlStreamReader>
+
+#include "syntax_grammar.h"
+
+/*!
+ * \class SyntaxGrammar
+ * \brief Compiled syntax definition used by the \c QsciLexerGrammar
+ *
+ * A grammar is loaded from an XML file that declares the styles, the
+ * keyword lists and the states of a language:
+ *
+ * \code
+ * <grammar name="Go">
+ *     <style name="default" description="Default" color="#000000" />
+ *     <style name="comment" description="Comment" color="#007f00" />
+ *     <keywords name="keywords" style="keyword">break case chan</keywords>
+ *     <state name="root">
+ *         <rule pattern="//.*" style="comment" />
+ *         <rule pattern="/\*" style="comment" push="comment" />
+ *         <rule pattern="[A-Za-z_]\w*" style="default" keywords="keywords" />
+ *     </state>
+ *     <state name="comment" style="comment">
+ *         <rule pattern="\*\/" style="comment" pop="1" />
+ *     </state>
+ * </grammar>
+ * \endcode
+ *
+ * The first state is the initial state of every document. The rules of
+ * a state are tried in order, the text that is not matched by any rule
+ * gets the style of the state. A rule can \c push a new state and/or
+ * \c pop a number of states from the stack, states marked as
+ * \c single-line are popped at the end of each line. Rules never match
+ * across lines.
+ *
+ * Grammars are compiled once: every regular expression is optimized and
+ * each state gets a dispatch table that lists, for every possible first
+ * character, the rules that can start with it. Keyword lists are stored
+ * in hash tables, so the style of an identifier is found with a single
+ * lookup.
+ */
+
+/*!
+ * \internal
+ * Returns a character set with all the characters enabled
+ */
+
+static QVector<bool> anyChar (void) {
+    return QVector<bool> (GRAMMAR_DISPATCH_SIZE, true);
+}
+
+/*!
+ * \internal
+ * Returns the position of the bracket that closes the character class
+ * starting at \a pos, or -1 if the class is not closed
+ */
+
+static int classEnd (const QString &pattern, int pos) {
+    int i = pos + 1;
+
+    if (i < pattern.length() && pattern.at (i) == '^')
+        ++i;
+
+    if (i < pattern.length() && pattern.at (i) == ']')
+        ++i;
+
+    while (i < pattern.length()) {
+        if (pattern.at (i) == '\\')
+            i += 2;
+
+        else if (pattern.at (i) == ']')
+            return i;
+
+        else
+            ++i;
+    }
+
+    return -1;
+}
+
+/*!
+ * \internal
+ * Returns the position of the parenthesis that closes the group
+ * starting at \a pos, or -1 if the group is not closed
+ */
+
+static int groupEnd (const QString &pattern, int pos) {
+    int _depth = 0;
+
+    for (int i = pos; i < pattern.length(); ++i) {
+        QChar _c = pattern.at (i);
+
+        if (_c == '\\')
+            ++i;
+
+        else if (_c == '[') {
+            i = classEnd (pattern, i);
+            if (i < 0)
+                return -1;
+        }
+
+        else if (_c == '(')
+            ++_depth;
+
+        else if (_c == ')' && --_depth == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+/*!
+ * \internal
+ * Splits the \a pattern in its top-level alternatives
+ */
+
+static QStringList alternatives (const QString &pattern) {
+    QStringList _list;
+    int _start = 0;
+
+    for (int i = 0; i < pattern.length(); ++i) {
+        QChar _c = pattern.at (i);
+
+        if (_c == '\\')
+            ++i;
+
+        else if (_c == '[' || _c == '(') {
+            int _end = _c == '[' ? classEnd (pattern, i) : groupEnd (pattern, i);
+            if (_end < 0)
+                break;
+
+            i = _end;
+        }
+
+        else if (_c == '|') {
+            _list.append (pattern.mid (_start, i - _start));
+            _start = i + 1;
+        }
+    }
+
+    _list.append (pattern.mid (_start));
+    return _list;
+}
+
+/*!
+ * \internal
+ * Adds the characters matched by the escape sequence \c {\\c} to \a set,
+ * returns \c false if the escape can match any character or no
+ * character at all (e.g. \c {\\b})
+ */
+
+static bool addEscape (QVector<bool> *set, QChar c) {
+    switch (c.unicode()) {
+        case 'd':
+            for (char i = '0'; i <= '9'; ++i)
+                (*set)[i] = true;
+            return true;
+
+        case 'w':
+            for (int i = 0; i < 128; ++i)
+                if (isalnum (i) || i == '_')
+                    (*set)[i] = true;
+            (*set)[128] = true;
+            return true;
+
+        case 's':
+            (*set)[' '] = (*set)['\t'] = (*set)['\n'] = true;
+            (*set)['\r'] = (*set)['\f'] = (*set)['\v'] = true;
+            (*set)[128] = true;
+            return true;
+
+        case 'n':
+            (*set)['\n'] = true;
+            return true;
+
+        case 't':
+            (*set)['\t'] = true;
+            return true;
+
+        case 'r':
+            (*set)['\r'] = true;
+            return true;
+
+        case 'f':
+            (*set)['\f'] = true;
+            return true;
+
+        case 'v':
+            (*set)['\v'] = true;
+            return true;
+    }
+
+    if (c.isLetterOrNumber())
+        return false;
+
+    (*set)[SyntaxGrammar::dispatchIndex (c.unicode())] = true;
+    return true;
+}
+
+/*!
+ * Initializes an empty grammar
+ */
+
+SyntaxGrammar::SyntaxGrammar (void) {}
+
+/*!
+ * Loads and compiles the grammar stored in the given \a path, returns
+ * \c false (and sets the \c errorString()) if the grammar is not valid
+ */
+
+bool SyntaxGrammar::load (const QString &path) {
+    m_name.clear();
+    m_error.clear();
+    m_styles.clear();
+    m_states.clear();
+
+    QFile _file (path);
+    if (!_file.open (QFile::ReadOnly))
+        return fail (_file.errorString());
+
+    //
+    // Keyword lists and rules are resolved once all the styles and
+    // states have been read, so that they can be declared in any order
+    //
+    struct RawRule {
+        QString pattern;
+        QString style;
+        QString push;
+        QString keywords;
+        int pop;
+    };
+
+    QHash<QString, QPair<QString, QStringList> > _keywords;
+    QVector<QVector<RawRule> > _rules;
+    QStringList _state_styles;
+
+    QXmlStreamReader _xml (&_file);
+
+    while (!_xml.atEnd() && !_xml.hasError()) {
+        if (_xml.readNext() != QXmlStreamReader::StartElement)
+            continue;
+
+        QXmlStreamAttributes _attributes = _xml.attributes();
+
+        if (_xml.name() == "grammar")
+            m_name = _attributes.value ("name").toString();
+
+        else if (_xml.name() == "style") {
+            GrammarStyle _style;
+            _style.name = _attributes.value ("name").toString();
+            _style.description = _attributes.value ("description").toString();
+            _style.color = QColor (_attributes.value ("color").toString());
+            _style.bold = _attributes.value ("bold") == "true";
+            _style.italic = _attributes.value ("italic") == "true";
+
+            if (_style.description.isEmpty())
+                _style.description = _style.name;
+
+            m_styles.append (_style);
+        }
+
+        else if (_xml.name() == "keywords") {
+            QString _name = _attributes.value ("name").toString();
+            QString _style = _attributes.value ("style").toString();
+            QStringList _words = _xml.readElementText().simplified()
+                                 .split (" ", QString::SkipEmptyParts);
+
+            _keywords.insert (_name, qMakePair (_style, _words));
+        }
+
+        else if (_xml.name() == "state") {
+            GrammarState _state;
+            _state.name = _attributes.value ("name").toString();
+            _state.single_line = _attributes.value ("single-line") == "true";
+            _state.style = 0;
+
+            m_states.append (_state);
+            _state_styles.append (_attributes.value ("style").toString());
+            _rules.append (QVector<RawRule>());
+        }
+
+        else if (_xml.name() == "rule" && !_rules.isEmpty()) {
+            RawRule _rule;
+            _rule.pattern = _attributes.value ("pattern").toString();
+            _rule.style = _attributes.value ("style").toString();
+            _rule.push = _attributes.value ("push").toString();
+            _rule.keywords = _attributes.value ("keywords").toString();
+            _rule.pop = _attributes.value ("pop").toString().toInt();
+
+            _rules.last().append (_rule);
+        }
+    }
+
+    _file.close();
+
+    if (_xml.hasError())
+        return fail (_xml.errorString());
+
+    if (m_styles.isEmpty() || m_styles.count() > GRAMMAR_MAX_STYLES)
+        return fail (QString ("A grammar needs between 1 and %1 styles")
+                     .arg (GRAMMAR_MAX_STYLES));
+
+    if (m_states.isEmpty() || m_states.count() > GRAMMAR_MAX_STATES)
+        return fail (QString ("A grammar needs between 1 and %1 states")
+                     .arg (GRAMMAR_MAX_STATES));
+
+    //
+    // Resolve the names used by the states and rules
+    //
+    for (int i = 0; i < m_states.count(); ++i) {
+        GrammarState &_state = m_states[i];
+
+        if (!_state_styles.at (i).isEmpty()) {
+            _state.style = styleIndex (_state_styles.at (i));
+            if (_state.style < 0)
+                return fail ("Unknown style " + _state_styles.at (i));
+        }
+
+        foreach (RawRule _raw, _rules.at (i)) {
+            GrammarRule _rule;
+            _rule.regex = QRegularExpression (_raw.pattern);
+            _rule.style = _raw.style.isEmpty() ? _state.style : styleIndex (_raw.style);
+            _rule.push = _raw.push.isEmpty() ? -1 : stateIndex (_raw.push);
+            _rule.pop = qMax (_raw.pop, 0);
+
+            if (!_rule.regex.isValid())
+                return fail (_raw.pattern + ": " + _rule.regex.errorString());
+
+            if (_rule.style < 0)
+                return fail ("Unknown style " + _raw.style);
+
+            if (!_raw.push.isEmpty() && _rule.push < 0)
+                return fail ("Unknown state " + _raw.push);
+
+            foreach (QString _list, _raw.keywords.split (" ", QString::SkipEmptyParts)) {
+                if (!_keywords.contains (_list))
+                    return fail ("Unknown keyword list " + _list);
+
+                int _style = styleIndex (_keywords.value (_list).first);
+                if (_style < 0)
+                    return fail ("Unknown style " + _keywords.value (_list).first);
+
+                foreach (QString _word, _keywords.value (_list).second) {
+                    if (!_rule.keywords.contains (_word))
+                        _rule.keywords.insert (_word, _style);
+                }
+            }
+
+            _rule.regex.optimize();
+            _state.rules.append (_rule);
+        }
+
+        compileDispatch (&_state);
+    }
+
+    return true;
+}
+
+/*!
+ * Returns the reason why the last call to \c load() failed
+ */
+
+QString SyntaxGrammar::errorString (void) const {
+    return m_error;
+}
+
+/*!
+ * Returns the name of the language described by the grammar
+ */
+
+QString SyntaxGrammar::name (void) const {
+    return m_name;
+}
+
+/*!
+ * Returns the number of styles declared by the grammar
+ */
+
+int SyntaxGrammar::styleCount (void) const {
+    return m_styles.count();
+}
+
+/*!
+ * Returns the style with the given \a index
+ */
+
+const GrammarStyle &SyntaxGrammar::style (int index) const {
+    return m_styles.at (index);
+}
+
+/*!
+ * Returns the number of states declared by the grammar
+ */
+
+int SyntaxGrammar::stateCount (void) const {
+    return m_states.count();
+}
+
+/*!
+ * Returns the state with the given \a index, the first state is used
+ * at the start of each document
+ */
+
+const GrammarState &SyntaxGrammar::state (int index) const {
+    return m_states.at (index);
+}
+
+/*!
+ * Returns the entry of the dispatch tables used for the UTF-16 code
+ * unit \a c, all the non-ASCII characters share the last entry
+ */
+
+int SyntaxGrammar::dispatchIndex (ushort c) {
+    return c < 128 ? c : 128;
+}
+
+/*!
+ * \internal
+ * Sets the \a error string and returns \c false
+ */
+
+bool SyntaxGrammar::fail (const QString &error) {
+    m_error = error;
+    return false;
+}
+
+/*!
+ * \internal
+ * Returns the index of the style with the given \a name, or -1
+ */
+
+int SyntaxGrammar::styleIndex (const QString &name) const {
+    for (int i = 0; i < m_styles.count(); ++i) {
+        if (m_styles.at (i).name == name)
+            return i;
+    }
+
+    return -1;
+}
+
+/*!
+ * \internal
+ * Returns the index of the state with the given \a name, or -1
+ */
+
+int SyntaxGrammar::stateIndex (const QString &name) const {
+    for (int i = 0; i < m_states.count(); ++i) {
+        if (m_states.at (i).name == name)
+            return i;
+    }
+
+    return -1;
+}
+
+/*!
+ * \internal
+ * Builds the dispatch table of the given \a state, which lists the rules
+ * that can match at a position given the character found there
+ */
+
+void SyntaxGrammar::compileDispatch (GrammarState *state) {
+    state->dispatch.fill (QVector<int>(), GRAMMAR_DISPATCH_SIZE);
+
+    for (int i = 0; i < state->rules.count(); ++i) {
+        QVector<bool> _chars = firstChars (state->rules.at (i).regex.pattern());
+
+        for (int c = 0; c < GRAMMAR_DISPATCH_SIZE; ++c) {
+            if (_chars.at (c))
+                state->dispatch[c].append (i);
+        }
+    }
+}
+
+/*!
+ * \internal
+ * Returns the set of characters that a match of \a pattern can start
+ * with. The analysis is conservative: when in doubt, every character
+ * is included in the set.
+ */
+
+QVector<bool> SyntaxGrammar::firstChars (const QString &pattern) {
+    QVector<bool> _set (GRAMMAR_DISPATCH_SIZE, false);
+
+    foreach (QString _alternative, alternatives (pattern)) {
+        int _pos = 0;
+        QVector<bool> _chars = firstCharsOfAtom (_alternative, &_pos);
+
+        for (int i = 0; i < GRAMMAR_DISPATCH_SIZE; ++i)
+            _set[i] = _set.at (i) || _chars.at (i);
+    }
+
+    return _set;
+}
+
+/*!
+ * \internal
+ * Returns the set of characters that the atom of \a pattern found at
+ * \a pos can start with
+ */
+
+QVector<bool> SyntaxGrammar::firstCharsOfAtom (const QString &pattern, int *pos) {
+    QVector<bool> _set (GRAMMAR_DISPATCH_SIZE, false);
+
+    while (*pos < pattern.length() && pattern.at (*pos) == '^')
+        ++*pos;
+
+    if (*pos >= pattern.length())
+        return anyChar();
+
+    int _end = *pos + 1;
+    QChar _c = pattern.at (*pos);
+
+    //
+    // Groups, lookarounds and inline options are not analyzed
+    //
+    if (_c == '(') {
+        int _close = groupEnd (pattern, *pos);
+        if (_close < 0)
+            return anyChar();
+
+        QString _inner = pattern.mid (*pos + 1, _close - *pos - 1);
+        if (_inner.startsWith ("?:"))
+            _inner = _inner.mid (2);
+
+        else if (_inner.startsWith ("?"))
+            return anyChar();
+
+        _set = firstChars (_inner);
+        _end = _close + 1;
+    }
+
+    //
+    // Character classes
+    //
+    else if (_c == '[') {
+        int _close = classEnd (pattern, *pos);
+        if (_close < 0)
+            return anyChar();
+
+        int i = *pos + 1;
+        bool _negated = pattern.at (i) == '^';
+        if (_negated)
+            ++i;
+
+        while (i < _close) {
+            QChar _from = pattern.at (i);
+
+            if (_from == '[' && i + 1 < _close && pattern.at (i + 1) == ':')
+                return anyChar();
+
+            if (_from == '\\') {
+                if (!addEscape (&_set, pattern.at (i + 1)))
+                    return anyChar();
+
+                i += 2;
+                continue;
+            }
+
+            if (i + 2 < _close && pattern.at (i + 1) == '-' && pattern.at (i + 2) != '\\') {
+                ushort _to = pattern.at (i + 2).unicode();
+                for (ushort u = _from.unicode(); u <= _to && u < 128; ++u)
+                    _set[u] = true;
+
+                if (_to >= 128)
+                    _set[128] = true;
+
+                i += 3;
+                continue;
+            }
+
+            _set[dispatchIndex (_from.unicode())] = true;
+            ++i;
+        }
+
+        if (_negated) {
+            for (int u = 0; u < 128; ++u)
+                _set[u] = !_set.at (u);
+
+            _set[128] = true;
+        }
+
+        _end = _close + 1;
+    }
+
+    //
+    // Escape sequences
+    //
+    else if (_c == '\\') {
+        if (*pos + 1 >= pattern.length() || !addEscape (&_set, pattern.at (*pos + 1)))
+            return anyChar();
+
+        _end = *pos + 2;
+    }
+
+    //
+    // Any character and anchors
+    //
+    else if (_c == '.' || _c == '$')
+        return anyChar();
+
+    //
+    // Literal character
+    //
+    else
+        _set[dispatchIndex (_c.unicode())] = true;
+
+    //
+    // The atom is optional, so the match can start with anything
+    //
+    if (_end < pattern.length()) {
+        QChar _quantifier = pattern.at (_end);
+        if (_quantifier == '?' || _quantifier == '*')
+            return anyChar();
+
+        if (_quantifier == '{' && pattern.mid (_end + 1).startsWith ("0"))
+            return anyChar();
+    }
+
+    *pos = _end;
+    return _set;
+}
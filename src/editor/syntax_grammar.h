@@ -0,0 +1,99 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef SYNTAX_GRAMMAR_H
+#define SYNTAX_GRAMMAR_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QHash>
+#include <QColor>
+#include <QString>
+#include <QVector>
+#include <QRegularExpression>
+
+#define GRAMMAR_MAX_STYLES 32
+#define GRAMMAR_MAX_STATES 15
+#define GRAMMAR_DISPATCH_SIZE 129
+
+struct GrammarStyle {
+    QString name;
+    QString description;
+    QColor color;
+    bool bold;
+    bool italic;
+};
+
+struct GrammarRule {
+    QRegularExpression regex;
+    QHash<QString, int> keywords;
+    int style;
+    int push;
+    int pop;
+};
+
+struct GrammarState {
+    QString name;
+    int style;
+    bool single_line;
+    QVector<GrammarRule> rules;
+    QVector<QVector<int> > dispatch;
+};
+
+class SyntaxGrammar {
+    public:
+        SyntaxGrammar (void);
+
+        bool load (const QString &path);
+        QString errorString (void) const;
+
+        QString name (void) const;
+
+        int styleCount (void) const;
+        const GrammarStyle &style (int index) const;
+
+        int stateCount (void) const;
+        const GrammarState &state (int index) const;
+
+        static int dispatchIndex (ushort c);
+
+    private:
+        bool fail (const QString &error);
+        int styleIndex (const QString &name) const;
+        int stateIndex (const QString &name) const;
+        void compileDispatch (GrammarState *state);
+
+        static QVector<bool> firstChars (const QString &pattern);
+        static QVector<bool> firstCharsOfAtom (const QString &pattern, int *pos);
+
+        QString m_name;
+        QString m_error;
+        QVector<GrammarStyle> m_styles;
+        QVector<GrammarState> m_states;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -0,0 +1,261 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include <string.h>
+
+#include "text_diff.h"
+
+#define MAX_DIFF_DISTANCE 1024
+
+/*!
+ * \class TextDiff
+ * \brief Finds the differences between two versions of a document
+ *
+ * The \c TextDiff class compares two versions of a document line by line
+ * and returns the list of edits that transform the first version into the
+ * second one. This allows the \c Editor to apply only the changed lines
+ * when a file is modified by another program, instead of replacing the
+ * whole document.
+ *
+ * The common prefix and suffix of both versions are skipped first, and the
+ * remaining lines are compared with the Myers O(ND) algorithm. If the
+ * versions have more than \c MAX_DIFF_DISTANCE different lines, the changed
+ * region is replaced with a single edit.
+ */
+
+/*!
+ * Returns the edits that transform \a {before} into \a {after}, sorted by
+ * their position. The positions refer to the \a {before} data, so the
+ * edits must be applied from the last one to the first one.
+ */
+
+QList<TextEdit> TextDiff::compute (const QByteArray &before, const QByteArray &after) {
+    QList<TextEdit> _edits;
+
+    //
+    // Skip the common prefix, and move back to the start of the line
+    //
+    qint64 _prefix = 0;
+    qint64 _min_length = qMin (before.size(), after.size());
+
+    while (_prefix < _min_length && before.at (_prefix) == after.at (_prefix))
+        ++_prefix;
+
+    if (_prefix == before.size() && _prefix == after.size())
+        return _edits;
+
+    while (_prefix > 0 && before.at (_prefix - 1) != '\n')
+        --_prefix;
+
+    //
+    // Skip the common suffix, and move forward until the
+    // suffix starts at the beginning of a line in both versions
+    //
+    qint64 _suffix = 0;
+    _min_length -= _prefix;
+
+    while (_suffix < _min_length &&
+           before.at (before.size() - _suffix - 1) == after.at (after.size() - _suffix - 1))
+        ++_suffix;
+
+    while (_suffix > 0) {
+        qint64 _a = before.size() - _suffix;
+        qint64 _b = after.size() - _suffix;
+
+        if ((_a == _prefix || before.at (_a - 1) == '\n') &&
+            (_b == _prefix || after.at (_b - 1) == '\n'))
+            break;
+
+        --_suffix;
+    }
+
+    QVector<Line> _a = splitLines (before, _prefix, before.size() - _suffix);
+    QVector<Line> _b = splitLines (after, _prefix, after.size() - _suffix);
+
+    int _n = _a.size();
+    int _m = _b.size();
+    int _max = qMin (_n + _m, MAX_DIFF_DISTANCE);
+
+    //
+    // Find the shortest edit script (Myers algorithm), the state of
+    // each iteration is saved to find the path afterwards
+    //
+    int _offset = _max + 1;
+    QVector<int> _v (2 * _max + 3, 0);
+    QVector<QVector<int> > _trace;
+
+    int _distance = -1;
+    for (int d = 0; d <= _max && _distance < 0; ++d) {
+        _trace.append (_v);
+
+        for (int k = -d; k <= d; k += 2) {
+            int x;
+
+            if (k == -d || (k != d && _v[_offset + k - 1] < _v[_offset + k + 1]))
+                x = _v[_offset + k + 1];
+            else
+                x = _v[_offset + k - 1] + 1;
+
+            int y = x - k;
+
+            while (x < _n && y < _m && sameLine (before, _a[x], after, _b[y])) {
+                ++x;
+                ++y;
+            }
+
+            _v[_offset + k] = x;
+
+            if (x >= _n && y >= _m) {
+                _distance = d;
+                break;
+            }
+        }
+    }
+
+    //
+    // The documents are too different, replace the changed region at once
+    //
+    if (_distance < 0) {
+        TextEdit _edit;
+        _edit.position = _prefix;
+        _edit.length = before.size() - _suffix - _prefix;
+        _edit.text = after.mid (_prefix, after.size() - _suffix - _prefix);
+        _edits.append (_edit);
+        return _edits;
+    }
+
+    //
+    // Walk the path backwards, saving each point
+    //
+    QVector<QPair<int, int> > _path;
+    int x = _n;
+    int y = _m;
+
+    for (int d = _distance; d > 0; --d) {
+        const QVector<int> &_state = _trace.at (d);
+        int k = x - y;
+        int _prev_k;
+
+        if (k == -d || (k != d && _state[_offset + k - 1] < _state[_offset + k + 1]))
+            _prev_k = k + 1;
+        else
+            _prev_k = k - 1;
+
+        int _prev_x = _state[_offset + _prev_k];
+        int _prev_y = _prev_x - _prev_k;
+
+        while (x > _prev_x && y > _prev_y) {
+            _path.prepend (qMakePair (x, y));
+            --x;
+            --y;
+        }
+
+        _path.prepend (qMakePair (x, y));
+        x = _prev_x;
+        y = _prev_y;
+    }
+
+    while (x > 0 && y > 0) {
+        _path.prepend (qMakePair (x, y));
+        --x;
+        --y;
+    }
+
+    _path.prepend (qMakePair (0, 0));
+
+    //
+    // Group the consecutive insertions and deletions into edits
+    //
+    int _hunk_x = -1;
+    int _hunk_y = -1;
+
+    for (int i = 1; i <= _path.size(); ++i) {
+        bool _diagonal = i == _path.size() ||
+                         (_path[i].first == _path[i - 1].first + 1 &&
+                          _path[i].second == _path[i - 1].second + 1);
+
+        if (!_diagonal && _hunk_x < 0) {
+            _hunk_x = _path[i - 1].first;
+            _hunk_y = _path[i - 1].second;
+        }
+
+        else if (_diagonal && _hunk_x >= 0) {
+            int _end_x = _path[i - 1].first;
+            int _end_y = _path[i - 1].second;
+
+            qint64 _start = _hunk_x < _n ? _a[_hunk_x].offset : before.size() - _suffix;
+            qint64 _end = _end_x < _n ? _a[_end_x].offset : before.size() - _suffix;
+            qint64 _text_start = _hunk_y < _m ? _b[_hunk_y].offset : after.size() - _suffix;
+            qint64 _text_end = _end_y < _m ? _b[_end_y].offset : after.size() - _suffix;
+
+            TextEdit _edit;
+            _edit.position = _start;
+            _edit.length = _end - _start;
+            _edit.text = after.mid (_text_start, _text_end - _text_start);
+            _edits.append (_edit);
+
+            _hunk_x = -1;
+            _hunk_y = -1;
+        }
+    }
+
+    return _edits;
+}
+
+/*!
+ * \internal
+ * Splits the given region of \a {data} into lines (including the line
+ * endings), and calculates the hash of each line
+ */
+
+QVector<TextDiff::Line> TextDiff::splitLines (const QByteArray &data,
+                                              qint64 start,
+                                              qint64 end) {
+    QVector<Line> _lines;
+    const char *_data = data.constData();
+
+    while (start < end) {
+        const char *_eol = static_cast<const char *> (memchr (_data + start, '\n', end - start));
+        qint64 _end = _eol != NULL ? _eol - _data + 1 : end;
+
+        Line _line;
+        _line.offset = start;
+        _line.length = (int) (_end - start);
+        _line.hash = qHash (QByteArray::fromRawData (_data + start, _line.length));
+        _lines.append (_line);
+
+        start = _end;
+    }
+
+    return _lines;
+}
+
+/*!
+ * \internal
+ * Returns \c {true} if the line \a {a} of \a {a_data} is equal to the line
+ * \a {b} of \a {b_data}
+ */
+
+bool TextDiff::sameLine (const QByteArray &a_data, const Line &a,
+                         const QByteArray &b_data, const Line &b) {
+    return a.hash == b.hash && a.length == b.length &&
+           memcmp (a_data.constData() + a.offset, b_data.constData() + b.offset, a.length) == 0;
+}
@@ -0,0 +1,62 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef TEXT_DIFF_H
+#define TEXT_DIFF_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QList>
+#include <QVector>
+#include <QByteArray>
+
+struct TextEdit {
+    qint64 position;
+    qint64 length;
+    QByteArray text;
+};
+
+class TextDiff {
+    public:
+        static QList<TextEdit> compute (const QByteArray &before,
+                                        const QByteArray &after);
+
+    private:
+        struct Line {
+            qint64 offset;
+            int length;
+            uint hash;
+        };
+
+        static QVector<Line> splitLines (const QByteArray &data,
+                                         qint64 start,
+                                         qint64 end);
+        static bool sameLine (const QByteArray &a_data, const Line &a,
+                              const QByteArray &b_data, const Line &b);
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
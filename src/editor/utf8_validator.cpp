@@ -0,0 +1,563 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#include "simd.h"
+#include "utf8_validator.h"
+
+/*!
+ * \class Utf8Validator
+ * \brief Validates UTF-8 data at memory bandwidth
+ *
+ * The \c Utf8Validator checks that a stream of bytes is valid UTF-8
+ * (no overlong forms, no surrogates and no code points above U+10FFFF).
+ *
+ * The data can be fed in chunks of any size, sequences that are split
+ * between two chunks are handled by a small scalar state machine, while the
+ * rest of each chunk is validated with AVX2 (when supported by the processor)
+ * or with an SSE2 loop that skips ASCII blocks.
+ */
+
+//
+// Error flags used by the AVX2 lookup tables, each flag represents
+// an invalid combination of the high/low nibbles of two bytes
+//
+#define TOO_SHORT  (1 << 0)
+#define TOO_LONG   (1 << 1)
+#define OVERLONG_3 (1 << 2)
+#define TOO_LARGE  (1 << 3)
+#define SURROGATE  (1 << 4)
+#define OVERLONG_2 (1 << 5)
+#define TOO_LARGE_1000 (1 << 6)
+#define OVERLONG_4 (1 << 6)
+#define TWO_CONTS  (1 << 7)
+#define CARRY      (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+/*!
+ * \internal
+ * Returns \c {true} if the given \a {data} only contains ASCII characters
+ */
+
+static bool isAsciiScalar (const uchar *data, qint64 length) {
+    uchar _bits = 0;
+
+    for (qint64 i = 0; i < length; ++i)
+        _bits |= data[i];
+
+    return (_bits & 0x80) == 0;
+}
+
+#if SIMD_AVX2
+
+/*!
+ * \internal
+ * Shifts the given vector to the left by N bytes, filling the gap with the
+ * last bytes of the \a {previous} vector
+ */
+
+#define AVX2_PREV(input, previous, n) \
+    _mm256_alignr_epi8 (input, _mm256_permute2x128_si256 (previous, input, 0x21), 16 - n)
+
+/*!
+ * \internal
+ * Returns the high nibble of each byte of the given vector
+ */
+
+SIMD_TARGET_AVX2 static inline __m256i avx2HighNibbles (__m256i input) {
+    return _mm256_and_si256 (_mm256_srli_epi16 (input, 4), _mm256_set1_epi8 (0x0F));
+}
+
+/*!
+ * \internal
+ * Classifies each pair of consecutive bytes (see the "Validating UTF-8 In
+ * Less Than One Instruction Per Byte" paper by Keiser and Lemire), the
+ * result is non-zero for each invalid pair.
+ */
+
+SIMD_TARGET_AVX2 static inline __m256i avx2SpecialCases (__m256i input, __m256i prev1) {
+    const __m256i _byte_1_high_table = _mm256_setr_epi8 (
+                                           TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                                           TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                                           TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                                           TOO_SHORT | OVERLONG_2,
+                                           TOO_SHORT,
+                                           TOO_SHORT | OVERLONG_3 | SURROGATE,
+                                           TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+                                           TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                                           TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                                           TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                                           TOO_SHORT | OVERLONG_2,
+                                           TOO_SHORT,
+                                           TOO_SHORT | OVERLONG_3 | SURROGATE,
+                                           TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+
+    const __m256i _byte_1_low_table = _mm256_setr_epi8 (
+                                          CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+                                          CARRY | OVERLONG_2,
+                                          CARRY,
+                                          CARRY,
+                                          CARRY | TOO_LARGE,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+                                          CARRY | OVERLONG_2,
+                                          CARRY,
+                                          CARRY,
+                                          CARRY | TOO_LARGE,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000,
+                                          CARRY | TOO_LARGE | TOO_LARGE_1000);
+
+    const __m256i _byte_2_high_table = _mm256_setr_epi8 (
+                                           TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                                           TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                                           TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+                                           TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+                                           TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                                           TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                                           TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                                           TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                                           TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                                           TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+                                           TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+                                           TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                                           TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                                           TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+    __m256i _byte_1_high = _mm256_shuffle_epi8 (_byte_1_high_table, avx2HighNibbles (prev1));
+    __m256i _byte_1_low = _mm256_shuffle_epi8 (_byte_1_low_table,
+                                               _mm256_and_si256 (prev1, _mm256_set1_epi8 (0x0F)));
+    __m256i _byte_2_high = _mm256_shuffle_epi8 (_byte_2_high_table, avx2HighNibbles (input));
+
+    return _mm256_and_si256 (_mm256_and_si256 (_byte_1_high, _byte_1_low), _byte_2_high);
+}
+
+/*!
+ * \internal
+ * Validates the given \a {data} with AVX2 instructions, the data must start
+ * and end at character boundaries. Writes \c {true} in \a {ascii} if the
+ * data only contains ASCII characters.
+ */
+
+SIMD_TARGET_AVX2 static bool validateAvx2 (const uchar *data, qint64 length, bool *ascii) {
+    const __m256i _max_values = _mm256_setr_epi8 (
+                                    (char) 0xFF, (char) 0xFF, (char) 0xFF, (char) 0xFF,
+                                    (char) 0xFF, (char) 0xFF, (char) 0xFF, (char) 0xFF,
+                                    (char) 0xFF, (char) 0xFF, (char) 0xFF, (char) 0xFF,
+                                    (char) 0xFF, (char) 0xFF, (char) 0xFF, (char) 0xFF,
+                                    (char) 0xFF, (char) 0xFF, (char) 0xFF, (char) 0xFF,
+                                    (char) 0xFF, (char) 0xFF, (char) 0xFF, (char) 0xFF,
+                                    (char) 0xFF, (char) 0xFF, (char) 0xFF, (char) 0xFF,
+                                    (char) 0xFF, (char) (0xF0 - 1), (char) (0xE0 - 1), (char) (0xC0 - 1));
+
+    __m256i _error = _mm256_setzero_si256();
+    __m256i _previous = _mm256_setzero_si256();
+    __m256i _incomplete = _mm256_setzero_si256();
+
+    bool _ascii = true;
+
+    qint64 i = 0;
+    uchar _tail[32];
+
+    while (i < length) {
+        __m256i _input;
+
+        //
+        // Pad the last block with zeros (which are valid ASCII)
+        //
+        if (i + 32 <= length)
+            _input = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (data + i));
+
+        else {
+            for (int j = 0; j < 32; ++j)
+                _tail[j] = i + j < length ? data[i + j] : 0;
+
+            _input = _mm256_loadu_si256 (reinterpret_cast<const __m256i *> (_tail));
+        }
+
+        i += 32;
+
+        //
+        // Fast path for ASCII blocks, we only need to check
+        // that the previous block did not end with an incomplete
+        // sequence
+        //
+        if (_mm256_movemask_epi8 (_input) == 0) {
+            _error = _mm256_or_si256 (_error, _incomplete);
+            _previous = _input;
+            _incomplete = _mm256_setzero_si256();
+            continue;
+        }
+
+        _ascii = false;
+
+        __m256i _prev1 = AVX2_PREV (_input, _previous, 1);
+        __m256i _prev2 = AVX2_PREV (_input, _previous, 2);
+        __m256i _prev3 = AVX2_PREV (_input, _previous, 3);
+
+        __m256i _special = avx2SpecialCases (_input, _prev1);
+
+        //
+        // Third and fourth bytes of 3 and 4-byte sequences must be
+        // continuation bytes, (and only them)
+        //
+        __m256i _third = _mm256_subs_epu8 (_prev2, _mm256_set1_epi8 ((char) (0xE0 - 0x80)));
+        __m256i _fourth = _mm256_subs_epu8 (_prev3, _mm256_set1_epi8 ((char) (0xF0 - 0x80)));
+        __m256i _must_23 = _mm256_and_si256 (_mm256_or_si256 (_third, _fourth),
+                                             _mm256_set1_epi8 ((char) 0x80));
+
+        _error = _mm256_or_si256 (_error, _mm256_xor_si256 (_must_23, _special));
+
+        _incomplete = _mm256_subs_epu8 (_input, _max_values);
+        _previous = _input;
+    }
+
+    _error = _mm256_or_si256 (_error, _incomplete);
+
+    if (ascii != NULL)
+        *ascii = _ascii;
+
+    return _mm256_testz_si256 (_error, _error) != 0;
+}
+
+#endif
+
+/*!
+ * \internal
+ * Initializes the validator
+ */
+
+Utf8Validator::Utf8Validator (void) {
+    reset();
+}
+
+/*!
+ * Resets the validator, so that it can be used with another stream
+ */
+
+void Utf8Validator::reset (void) {
+    m_valid = true;
+    m_ascii = true;
+    m_needed = 0;
+    m_lower = 0x80;
+    m_upper = 0xBF;
+}
+
+/*!
+ * Validates the next chunk of the stream, returns \c {false} if the stream
+ * (up to this chunk) is not valid UTF-8.
+ */
+
+bool Utf8Validator::feed (const char *data, qint64 length) {
+    if (!m_valid || length <= 0)
+        return m_valid;
+
+    const uchar *_data = reinterpret_cast<const uchar *> (data);
+
+    //
+    // Complete the sequence that was split by the previous chunk
+    //
+    qint64 _start = feedScalar (_data, length, true);
+
+    if (!m_valid || _start >= length)
+        return m_valid;
+
+    //
+    // Find the start of the last (possibly incomplete) sequence,
+    // we validate it later with the scalar validator
+    //
+    qint64 _end = length;
+
+    for (qint64 i = length - 1; i >= qMax (_start, length - 4); --i) {
+        if (_data[i] >= 0xC0) {
+            _end = i;
+            break;
+        }
+
+        else if (_data[i] < 0x80)
+            break;
+    }
+
+    //
+    // Validate the complete sequences
+    //
+    bool _ascii = true;
+
+#if SIMD_AVX2
+    if (cpuSupportsAvx2())
+        m_valid = validateAvx2 (_data + _start, _end - _start, &_ascii);
+
+    else
+#endif
+    {
+        _ascii = isAscii (data + _start, _end - _start);
+        m_valid = _ascii || validateScalar (data + _start, _end - _start);
+    }
+
+    m_ascii = m_ascii && _ascii;
+
+    //
+    // Validate the last sequence
+    //
+    if (m_valid && _end < length)
+        feedScalar (_data + _end, length - _end, false);
+
+    return m_valid;
+}
+
+/*!
+ * Returns \c {true} if the stream is valid and does not end with an
+ * incomplete sequence
+ */
+
+bool Utf8Validator::finish (void) const {
+    return m_valid && m_needed == 0;
+}
+
+/*!
+ * Returns \c {true} if all the data fed so far is valid UTF-8
+ */
+
+bool Utf8Validator::isValid (void) const {
+    return m_valid;
+}
+
+/*!
+ * Returns \c {true} if all the data fed so far only contains ASCII
+ * characters
+ */
+
+bool Utf8Validator::isAscii (void) const {
+    return m_ascii;
+}
+
+/*!
+ * Returns \c {true} if the given \a {data} only contains ASCII characters
+ */
+
+bool Utf8Validator::isAscii (const char *data, qint64 length) {
+    const uchar *_data = reinterpret_cast<const uchar *> (data);
+    qint64 i = 0;
+
+#if SIMD_SSE2
+    __m128i _bits = _mm_setzero_si128();
+
+    for (; i + 16 <= length; i += 16)
+        _bits = _mm_or_si128 (_bits, _mm_loadu_si128 (reinterpret_cast<const __m128i *> (_data + i)));
+
+    if (_mm_movemask_epi8 (_bits) != 0)
+        return false;
+#endif
+
+    return isAsciiScalar (_data + i, length - i);
+}
+
+/*!
+ * Returns \c {true} if the given \a {data} is complete and valid UTF-8
+ */
+
+bool Utf8Validator::validate (const char *data, qint64 length) {
+    Utf8Validator _validator;
+    _validator.feed (data, length);
+    return _validator.finish();
+}
+
+/*!
+ * Validates the given \a {data} byte by byte, this function is used as a
+ * fallback when the processor does not support AVX2 and as a reference
+ * to verify the vectorised validator.
+ *
+ * When SSE2 is available, ASCII blocks of 16 bytes are skipped at once.
+ */
+
+bool Utf8Validator::validateScalar (const char *data, qint64 length) {
+    const uchar *_data = reinterpret_cast<const uchar *> (data);
+    qint64 i = 0;
+
+    while (i < length) {
+#if SIMD_SSE2
+        //
+        // Skip ASCII blocks
+        //
+        while (i + 16 <= length) {
+            __m128i _block = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (_data + i));
+
+            if (_mm_movemask_epi8 (_block) != 0)
+                break;
+
+            i += 16;
+        }
+
+        if (i >= length)
+            break;
+#endif
+
+        uchar c = _data[i];
+        int _needed = 0;
+        uchar _lower = 0x80;
+        uchar _upper = 0xBF;
+
+        if (c < 0x80) {
+            ++i;
+            continue;
+        }
+
+        else if (c >= 0xC2 && c <= 0xDF)
+            _needed = 1;
+
+        else if (c == 0xE0) {
+            _needed = 2;
+            _lower = 0xA0;
+        }
+
+        else if (c == 0xED) {
+            _needed = 2;
+            _upper = 0x9F;
+        }
+
+        else if (c >= 0xE1 && c <= 0xEF)
+            _needed = 2;
+
+        else if (c == 0xF0) {
+            _needed = 3;
+            _lower = 0x90;
+        }
+
+        else if (c >= 0xF1 && c <= 0xF3)
+            _needed = 3;
+
+        else if (c == 0xF4) {
+            _needed = 3;
+            _upper = 0x8F;
+        }
+
+        else
+            return false;
+
+        if (i + _needed >= length)
+            return false;
+
+        for (int j = 1; j <= _needed; ++j) {
+            uchar _byte = _data[i + j];
+
+            if (_byte < _lower || _byte > _upper)
+                return false;
+
+            _lower = 0x80;
+            _upper = 0xBF;
+        }
+
+        i += _needed + 1;
+    }
+
+    return true;
+}
+
+/*!
+ * \internal
+ * Runs the byte-by-byte state machine over the given \a {data}, which
+ * allows validating sequences that are split between chunks.
+ *
+ * If \a {stop_at_boundary} is \c {true}, the function returns as soon as
+ * the current sequence is completed. Returns the number of bytes consumed.
+ */
+
+qint64 Utf8Validator::feedScalar (const uchar *data, qint64 length, bool stop_at_boundary) {
+    qint64 i = 0;
+
+    for (; i < length && m_valid; ++i) {
+        if (stop_at_boundary && m_needed == 0)
+            return i;
+
+        uchar c = data[i];
+
+        //
+        // Continuation byte
+        //
+        if (m_needed > 0) {
+            if (c < m_lower || c > m_upper)
+                m_valid = false;
+
+            m_lower = 0x80;
+            m_upper = 0xBF;
+            --m_needed;
+            continue;
+        }
+
+        //
+        // Lead byte
+        //
+        if (c < 0x80)
+            continue;
+
+        m_ascii = false;
+
+        if (c >= 0xC2 && c <= 0xDF)
+            m_needed = 1;
+
+        else if (c == 0xE0) {
+            m_needed = 2;
+            m_lower = 0xA0;
+        }
+
+        else if (c == 0xED) {
+            m_needed = 2;
+            m_upper = 0x9F;
+        }
+
+        else if (c >= 0xE1 && c <= 0xEF)
+            m_needed = 2;
+
+        else if (c == 0xF0) {
+            m_needed = 3;
+            m_lower = 0x90;
+        }
+
+        else if (c >= 0xF1 && c <= 0xF3)
+            m_needed = 3;
+
+        else if (c == 0xF4) {
+            m_needed = 3;
+            m_upper = 0x8F;
+        }
+
+        else
+            m_valid = false;
+    }
+
+    return i;
+}
@@ -0,0 +1,60 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef UTF8_VALIDATOR_H
+#define UTF8_VALIDATOR_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+#include <QtGlobal>
+
+class Utf8Validator {
+    public:
+        Utf8Validator (void);
+
+        void reset (void);
+        bool feed (const char *data, qint64 length);
+        bool finish (void) const;
+
+        bool isValid (void) const;
+        bool isAscii (void) const;
+
+        static bool isAscii (const char *data, qint64 length);
+        static bool validate (const char *data, qint64 length);
+        static bool validateScalar (const char *data, qint64 length);
+
+    private:
+        qint64 feedScalar (const uchar *data, qint64 length, bool stop_at_boundary);
+
+        bool m_valid;
+        bool m_ascii;
+        int m_needed;
+        uchar m_lower;
+        uchar m_upper;
+};
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
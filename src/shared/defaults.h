@@ -45,6 +45,26 @@ extern "C++" {
 #define SETTINGS_WORD_WRAP_ENABLED true
 #define SETTINGS_INDENTATION_GUIDES true
 
+//
+// File defaults
+//
+#define SETTINGS_SAVE_FSYNC true
+#define SETTINGS_JOURNAL_ENABLED true
+
+//
+// Large file mode defaults (size is in megabytes)
+//
+#define SETTINGS_LARGE_FILE_MODE true
+#define SETTINGS_LARGE_FILE_SIZE 32
+#define SETTINGS_LARGE_FILE_LINES 500000
+#define SETTINGS_VIEWER_MODE_SIZE 512
+#define SETTINGS_HEX_VIEW_BINARY true
+
+//
+// Follow mode defaults (0 keeps all the lines)
+//
+#define SETTINGS_FOLLOW_MAX_LINES 0
+
 //
 // Editor font
 //
@@ -77,11 +97,57 @@ extern "C++" {
 #define SETTINGS_LARGE_ICONS MAC_OS_X
 #define SETTINGS_ICON_THEME MAC_OS_X ? "Faience" : LINUX ? "Tango" : "Silk"
 
+//
+// Window defaults
+//
+#define SETTINGS_WINDOW_SIZE QSize (640, 420)
+#define SETTINGS_WINDOW_POSITION QPoint (200, 200)
+#define SETTINGS_WINDOW_MAXIMIZED false
+
 //
 // Other defaults
 //
+#define SETTINGS_FONT_BOLD false
+#define SETTINGS_FONT_ITALIC false
+#define SETTINGS_FONT_UNDERLINE false
+#define SETTINGS_FIRST_LAUNCH true
+#define SETTINGS_SECOND_LAUNCH false
 #define SETTINGS_AUTO_CHECK_UPDATES false
 
+//
+// Registry of the settings, each entry has an identifier, the names of the
+// accessors, the key used in the settings file, the type and the default value
+//
+#define SETTINGS_REGISTRY(X) \
+    X (StatusBarEnabled, statusBarEnabled, setStatusBarEnabled, "statusbar-enabled",       bool,    SETTINGS_STATUSBAR_ENABLED)  \
+    X (ToolbarEnabled,   toolbarEnabled,   setToolbarEnabled,   "toolbar-enabled",         bool,    SETTINGS_TOOLBAR_ENABLED)    \
+    X (ToolbarText,      toolbarText,      setToolbarText,      "toolbar-text",            bool,    SETTINGS_TOOLBAR_TEXT)       \
+    X (LargeIcons,       largeIcons,       setLargeIcons,       "large-icons",             bool,    SETTINGS_LARGE_ICONS)        \
+    X (IconTheme,        iconTheme,        setIconTheme,        "icon-theme",              QString, SETTINGS_ICON_THEME)         \
+    X (ColorScheme,      colorScheme,      setColorScheme,      "color-scheme",            QString, DEFAULT_THEME)               \
+    X (CaretLine,        caretLine,        setCaretLine,        "hc-line-enabled",         bool,    SETTINGS_CARET_LINE)         \
+    X (LineNumbers,      lineNumbers,      setLineNumbers,      "line-numbers-enabled",    bool,    SETTINGS_LINE_NUMBERS)       \
+    X (WordWrap,         wordWrap,         setWordWrap,         "wordwrap-enabled",        bool,    SETTINGS_WORD_WRAP_ENABLED)  \
+    X (FontFamily,       fontFamily,       setFontFamily,       "font-family",             QString, DEFAULT_FONT_FAMILY)         \
+    X (FontSize,         fontSize,         setFontSize,         "font-size",               int,     DEFAULT_FONT_SIZE)           \
+    X (FontBold,         fontBold,         setFontBold,         "font-bold",               bool,    SETTINGS_FONT_BOLD)          \
+    X (FontItalic,       fontItalic,       setFontItalic,       "font-italic",             bool,    SETTINGS_FONT_ITALIC)        \
+    X (FontUnderline,    fontUnderline,    setFontUnderline,    "font-underline",          bool,    SETTINGS_FONT_UNDERLINE)     \
+    X (LargeFileMode,    largeFileMode,    setLargeFileMode,    "large-file-mode-enabled", bool,    SETTINGS_LARGE_FILE_MODE)    \
+    X (LargeFileSize,    largeFileSize,    setLargeFileSize,    "large-file-size",         qint64,  SETTINGS_LARGE_FILE_SIZE)    \
+    X (LargeFileLines,   largeFileLines,   setLargeFileLines,   "large-file-lines",        int,     SETTINGS_LARGE_FILE_LINES)   \
+    X (ViewerModeSize,   viewerModeSize,   setViewerModeSize,   "viewer-mode-size",        qint64,  SETTINGS_VIEWER_MODE_SIZE)   \
+    X (HexViewBinary,    hexViewBinary,    setHexViewBinary,    "hex-view-binary",         bool,    SETTINGS_HEX_VIEW_BINARY)    \
+    X (FollowMaxLines,   followMaxLines,   setFollowMaxLines,   "follow-max-lines",        int,     SETTINGS_FOLLOW_MAX_LINES)   \
+    X (JournalEnabled,   journalEnabled,   setJournalEnabled,   "journal-enabled",         bool,    SETTINGS_JOURNAL_ENABLED)    \
+    X (SaveFsync,        saveFsync,        setSaveFsync,        "save-fsync",              bool,    SETTINGS_SAVE_FSYNC)         \
+    X (WindowSize,       windowSize,       setWindowSize,       "size",                    QSize,   SETTINGS_WINDOW_SIZE)        \
+    X (WindowPosition,   windowPosition,   setWindowPosition,   "position",                QPoint,  SETTINGS_WINDOW_POSITION)    \
+    X (WindowMaximized,  windowMaximized,  setWindowMaximized,  "maximized",               bool,    SETTINGS_WINDOW_MAXIMIZED)   \
+    X (CheckForUpdates,  checkForUpdates,  setCheckForUpdates,  "check-for-updates",       bool,    SETTINGS_AUTO_CHECK_UPDATES) \
+    X (FirstLaunch,      firstLaunch,      setFirstLaunch,      "first-launch",            bool,    SETTINGS_FIRST_LAUNCH)       \
+    X (SecondLaunch,     secondLaunch,     setSecondLaunch,     "second-launch",           bool,    SETTINGS_SECOND_LAUNCH)
+
 #endif
 
 #ifdef __APPLE__
@@ -0,0 +1,145 @@
+//
+//  This file is part of Thunderpad
+//
+//  Copyright (c) 2013-2015 Alex Spataru <alex_spataru@outlook.com>
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02111-1301
+//  USA
+//
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#ifdef __APPLE__
+extern "C++" {
+#endif
+
+//
+// Detect the instruction sets that can be used by the compiler
+//
+#define SIMD_SSE2 false
+#define SIMD_AVX2 false
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#undef SIMD_SSE2
+#define SIMD_SSE2 true
+#endif
+
+//
+// AVX2 code is compiled for x86 targets only, and it is only
+// executed if the processor supports it (see cpuSupportsAvx2())
+//
+#if SIMD_SSE2 && (defined (__GNUC__) || defined (__clang__) || defined (_MSC_VER))
+#undef SIMD_AVX2
+#define SIMD_AVX2 true
+#endif
+
+#if SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+#if SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+#if defined (_MSC_VER)
+#include <intrin.h>
+#endif
+
+//
+// Allows the compiler to generate AVX2 code for a single function
+//
+#if SIMD_AVX2 && (defined (__GNUC__) || defined (__clang__))
+#define SIMD_TARGET_AVX2 __attribute__ ((target ("avx2,popcnt")))
+#else
+#define SIMD_TARGET_AVX2
+#endif
+
+/*!
+ * Returns \c {true} if the processor and the operating system support
+ * AVX2 instructions, the result is calculated only once.
+ */
+
+inline bool cpuSupportsAvx2 (void) {
+#if SIMD_AVX2 && (defined (__GNUC__) || defined (__clang__))
+    static const bool _supported = __builtin_cpu_supports ("avx2");
+    return _supported;
+#elif SIMD_AVX2 && defined (_MSC_VER)
+    static int _supported = -1;
+
+    if (_supported < 0) {
+        int _info[4];
+        __cpuid (_info, 0);
+        _supported = 0;
+
+        if (_info[0] >= 7) {
+            __cpuid (_info, 1);
+            bool _osxsave = (_info[2] & (1 << 27)) != 0;
+            bool _avx = (_info[2] & (1 << 28)) != 0;
+
+            __cpuidex (_info, 7, 0);
+            bool _avx2 = (_info[1] & (1 << 5)) != 0;
+
+            if (_osxsave && _avx && _avx2)
+                _supported = (_xgetbv (0) & 0x6) == 0x6;
+        }
+    }
+
+    return _supported == 1;
+#else
+    return false;
+#endif
+}
+
+/*!
+ * Returns the number of bits set in the given \a {value}, this is used
+ * to count the matches reported by the movemask instructions.
+ */
+
+inline int popCount (unsigned int value) {
+#if defined (__GNUC__) || defined (__clang__)
+    return __builtin_popcount (value);
+#else
+    value = value - ((value >> 1) & 0x55555555);
+    value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+    return (((value + (value >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24;
+#endif
+}
+
+/*!
+ * Returns the position of the lowest bit set in the given \a {value},
+ * which must not be zero
+ */
+
+inline int countTrailingZeros (unsigned int value) {
+#if defined (__GNUC__) || defined (__clang__)
+    return __builtin_ctz (value);
+#else
+    int _count = 0;
+
+    while ((value & 1) == 0) {
+        value >>= 1;
+        ++_count;
+    }
+
+    return _count;
+#endif
+}
+
+#endif
+
+#ifdef __APPLE__
+}
+#endif
@@ -22,7 +22,6 @@
 #include <QDir>
 #include <QMenu>
 #include <QAction>
-#include <QSettings>
 #include <QKeySequence>
 #include <QApplication>
 #include <QSignalMapper>
@@ -32,6 +31,7 @@
 #include "menubar.h"
 #include "platform.h"
 #include "defaults.h"
+#include "settings_registry.h"
 
 /*!
  * \class MenuBar
@@ -104,6 +104,10 @@ void MenuBar::initialize (Window *window) {
     // Connect slots for the tools menu
     //
     connect (t_goto_line, SIGNAL (triggered()), window->editor(), SLOT (goToLine()));
+    connect (t_follow_file, SIGNAL (triggered (bool)), window->editor(), SLOT (setFollowMode (bool)));
+    connect (window->editor(), SIGNAL (followModeChanged (bool)), t_follow_file, SLOT (setChecked (bool)));
+    connect (t_hex_view, SIGNAL (triggered (bool)), window->editor(), SLOT (setHexMode (bool)));
+    connect (window->editor(), SIGNAL (hexModeChanged (bool)), t_hex_view, SLOT (setChecked (bool)));
     connect (t_sort_selection, SIGNAL (triggered()), window->editor(), SLOT (sortSelection()));
     connect (t_insert_date_time, SIGNAL (triggered()), window->editor(), SLOT (insertDateTime()));
     connect (t_document_information, SIGNAL (triggered()), window->editor(), SLOT (documentInfo()));
@@ -114,6 +118,15 @@ void MenuBar::initialize (Window *window) {
     connect (format_font, SIGNAL (triggered()), window->editor(), SLOT (selectFonts()));
     connect (format_word_wrap, SIGNAL (triggered (bool)), window, SLOT (setWordWrap (bool)));
 
+    QSignalMapper *eol_mapper = new QSignalMapper (this);
+    eol_mapper->setMapping (eol_windows, QsciScintilla::EolWindows);
+    eol_mapper->setMapping (eol_unix, QsciScintilla::EolUnix);
+    eol_mapper->setMapping (eol_mac, QsciScintilla::EolMac);
+    connect (eol_windows, SIGNAL (triggered()), eol_mapper, SLOT (map()));
+    connect (eol_unix, SIGNAL (triggered()), eol_mapper, SLOT (map()));
+    connect (eol_mac, SIGNAL (triggered()), eol_mapper, SLOT (map()));
+    connect (eol_mapper, SIGNAL (mapped (int)), window->editor(), SLOT (convertLineEndings (int)));
+
     //
     // Connect slots from the view menu
     //
@@ -124,6 +137,7 @@ void MenuBar::initialize (Window *window) {
     connect (v_zoom_reset, SIGNAL (triggered()), window->editor(), SLOT (resetZoom()));
     connect (v_highlight_current_line, SIGNAL (triggered (bool)), window, SLOT (setHCLineEnabled (bool)));
     connect (v_line_numbers, SIGNAL (triggered (bool)), window, SLOT (setLineNumbersEnabled (bool)));
+    connect (v_large_file_mode, SIGNAL (triggered (bool)), window, SLOT (setLargeFileModeEnabled (bool)));
     connect (v_toolbar_text, SIGNAL (triggered (bool)), window, SLOT (setToolbarText (bool)));
     connect (v_large_toolbar_icons, SIGNAL (triggered (bool)), window, SLOT (setUseLargeIcons (bool)));
     connect (this, SIGNAL (colorChanged (QString)), window, SLOT (setColorscheme (QString)));
@@ -147,6 +161,12 @@ void MenuBar::initialize (Window *window) {
     // Sync settings
     //
     connect (window, SIGNAL (updateSettings()), this, SLOT (updateSettings()));
+
+    //
+    // Keep the checked actions in sync when the user changes a setting,
+    // updating them is cheap, so all of them are updated
+    //
+    connect (window, SIGNAL (settingsChanged (QList<int>)), this, SLOT (updateSettings()));
 }
 
 /*!
@@ -158,13 +178,14 @@ void MenuBar::initialize (Window *window) {
  */
 
 void MenuBar::updateSettings (void) {
-    v_toolbar->setChecked (settings()->value ("toolbar-enabled", SETTINGS_TOOLBAR_ENABLED).toBool());
-    v_toolbar_text->setChecked (settings()->value ("toolbar-text", SETTINGS_TOOLBAR_TEXT).toBool());
-    v_statusbar->setChecked (settings()->value ("statusbar-enabled", SETTINGS_STATUSBAR_ENABLED).toBool());
-    format_word_wrap->setChecked (settings()->value ("wordwrap-enabled", SETTINGS_WORD_WRAP_ENABLED).toBool());
-    v_large_toolbar_icons->setChecked (settings()->value ("large-icons", SETTINGS_LARGE_ICONS).toBool());
-    v_line_numbers->setChecked (settings()->value ("line-numbers-enabled", SETTINGS_LINE_NUMBERS).toBool());
-    v_highlight_current_line->setChecked (settings()->value ("hc-line-enabled", SETTINGS_CARET_LINE).toBool());
+    v_toolbar->setChecked (settings()->toolbarEnabled());
+    v_toolbar_text->setChecked (settings()->toolbarText());
+    v_statusbar->setChecked (settings()->statusBarEnabled());
+    format_word_wrap->setChecked (settings()->wordWrap());
+    v_large_toolbar_icons->setChecked (settings()->largeIcons());
+    v_line_numbers->setChecked (settings()->lineNumbers());
+    v_highlight_current_line->setChecked (settings()->caretLine());
+    v_large_file_mode->setChecked (settings()->largeFileMode());
 }
 
 /*!
@@ -202,6 +223,9 @@ void MenuBar::createActions (void) {
     //
     format_font = new QAction (tr ("Fonts") + "...", this);
     format_word_wrap = new QAction (tr ("Word wrap"), this);
+    eol_windows = new QAction (tr ("Windows (CRLF)"), this);
+    eol_unix = new QAction (tr ("Unix (LF)"), this);
+    eol_mac = new QAction (tr ("Classic Mac (CR)"), this);
 
     //
     // Create the view menu actions
@@ -213,6 +237,7 @@ void MenuBar::createActions (void) {
     v_zoom_reset = new QAction (tr ("Reset zoom"), this);
     v_highlight_current_line = new QAction (tr ("Highlight current line"), this);
     v_line_numbers = new QAction (tr ("Show line numbers"), this);
+    v_large_file_mode = new QAction (tr ("Optimize large files"), this);
     v_large_toolbar_icons = new QAction (tr ("Large toolbar icons"), this);
     v_toolbar_text = new QAction (tr ("Display text under toolbar icons"), this);
 
@@ -220,6 +245,8 @@ void MenuBar::createActions (void) {
     // Create the tools menu actions
     //
     t_sort_selection = new QAction (tr ("Sort selection"), this);
+    t_follow_file = new QAction (tr ("Follow file changes"), this);
+    t_hex_view = new QAction (tr ("Hex view"), this);
     t_goto_line = new QAction (tr ("Go to line") + "...", this);
     t_insert_date_time = new QAction (tr ("Insert date/time"), this);
     t_document_information = new QAction (tr ("Document information"), this);
@@ -287,9 +314,12 @@ void MenuBar::configureActions (void) {
     e_read_only->setCheckable (true);
     format_word_wrap->setCheckable (true);
     v_line_numbers->setCheckable (true);
+    v_large_file_mode->setCheckable (true);
     v_toolbar_text->setCheckable (true);
     v_large_toolbar_icons->setCheckable (true);
     v_highlight_current_line->setCheckable (true);
+    t_follow_file->setCheckable (true);
+    t_hex_view->setCheckable (true);
 }
 
 /*!
@@ -362,6 +392,15 @@ void MenuBar::createMenubar (void) {
     //
     m_format->addAction (format_font);
     m_format->addAction (format_word_wrap);
+    m_format->addSeparator();
+
+    //
+    // Create the line endings menu
+    //
+    format_line_endings = m_format->addMenu (tr ("Convert line endings"));
+    format_line_endings->addAction (eol_windows);
+    format_line_endings->addAction (eol_unix);
+    format_line_endings->addAction (eol_mac);
 
     //
     // Create the visible menu
@@ -386,6 +425,7 @@ void MenuBar::createMenubar (void) {
     v_appearance = m_view->addMenu (tr ("Appearance"));
     v_appearance->addAction (v_highlight_current_line);
     v_appearance->addAction (v_line_numbers);
+    v_appearance->addAction (v_large_file_mode);
     v_appearance->addSeparator();
     v_appearance->addAction (v_large_toolbar_icons);
     v_appearance->addAction (v_toolbar_text);
@@ -425,7 +465,7 @@ void MenuBar::createMenubar (void) {
         //
         // Check the icon if necessary
         //
-        if (settings()->value ("icon-theme", SETTINGS_ICON_THEME).toString() == _action->text())
+        if (settings()->iconTheme() == _action->text())
             _action->setChecked (true);
     }
 
@@ -434,6 +474,8 @@ void MenuBar::createMenubar (void) {
     //
     m_tools->addAction (t_sort_selection);
     m_tools->addAction (t_goto_line);
+    m_tools->addAction (t_follow_file);
+    m_tools->addAction (t_hex_view);
     m_tools->addSeparator();
     m_tools->addAction (t_insert_date_time);
     m_tools->addAction (t_document_information);
@@ -477,6 +519,7 @@ void MenuBar::setReadOnly (bool ro) {
     e_cut->setEnabled (!ro);
     e_copy->setEnabled (!ro);
     e_paste->setEnabled (!ro);
+    format_line_endings->setEnabled (!ro);
 
     //
     // Change the state of the read only
@@ -489,7 +532,7 @@ void MenuBar::setReadOnly (bool ro) {
  * Allows the class to access the application settings
  */
 
-QSettings *MenuBar::settings (void) const {
-    return new QSettings (APP_COMPANY, APP_NAME);
+SettingsRegistry *MenuBar::settings (void) const {
+    return SettingsRegistry::instance();
 }
 
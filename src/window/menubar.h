@@ -29,7 +29,7 @@ extern "C++" {
 class QMenu;
 class Window;
 class QAction;
-class QSettings;
+class SettingsRegistry;
 
 #include <QMenuBar>
 
@@ -54,7 +54,7 @@ class MenuBar : public QMenuBar {
         void initialize (Window *window);
 
     private:
-        QSettings *settings (void) const;
+        SettingsRegistry *settings (void) const;
 
         QMenu *m_file;
         QMenu *m_edit;
@@ -88,6 +88,11 @@ class MenuBar : public QMenuBar {
         QAction *format_font;
         QAction *format_word_wrap;
 
+        QMenu *format_line_endings;
+        QAction *eol_windows;
+        QAction *eol_unix;
+        QAction *eol_mac;
+
         QAction *v_toolbar;
         QAction *v_statusbar;
 
@@ -99,6 +104,7 @@ class MenuBar : public QMenuBar {
         QMenu *v_appearance;
         QAction *v_highlight_current_line;
         QAction *v_line_numbers;
+        QAction *v_large_file_mode;
         QAction *v_toolbar_text;
         QAction *v_large_toolbar_icons;
 
@@ -106,6 +112,8 @@ class MenuBar : public QMenuBar {
 
         QAction *t_sort_selection;
         QAction *t_goto_line;
+        QAction *t_follow_file;
+        QAction *t_hex_view;
         QAction *t_insert_date_time;
         QAction *t_document_information;
 
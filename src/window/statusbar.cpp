@@ -22,12 +22,17 @@
 #include <QLabel>
 #include <QString>
 #include <QRegExp>
-#include <QSettings>
+#include <QToolButton>
+#include <QProgressBar>
 
 #include "editor.h"
 #include "window.h"
 #include "defaults.h"
 #include "statusbar.h"
+#include "hex_viewer.h"
+#include "file_viewer.h"
+#include "settings_registry.h"
+#include "update_scheduler.h"
 
 /*!
  * \class StatusBar
@@ -57,17 +62,87 @@ void StatusBar::initialize (Window *window) {
     window->setStatusBar (this);
     m_text_edit = window->editor();
 
+    m_mode_label = new QLabel (this);
+    m_encoding_label = new QLabel (this);
     m_size_label = new QLabel (this);
     m_lines_label = new QLabel (this);
     m_words_label = new QLabel (this);
 
+    m_progress_bar = new QProgressBar (this);
+    m_progress_bar->setRange (0, 100);
+    m_progress_bar->setMaximumWidth (160);
+    m_progress_bar->setMaximumHeight (16);
+
+    m_cancel_button = new QToolButton (this);
+    m_cancel_button->setAutoRaise (true);
+    m_cancel_button->setText (tr ("Cancel"));
+    m_cancel_button->setToolTip (tr ("Stop loading the document"));
+
+    addWidget (m_progress_bar);
+    addWidget (m_cancel_button);
+    addPermanentWidget (m_mode_label);
+    addPermanentWidget (m_encoding_label);
     addPermanentWidget (m_size_label);
     addPermanentWidget (m_lines_label);
     addPermanentWidget (m_words_label);
 
-    connect (m_text_edit, SIGNAL (textChanged()), this, SLOT (updateStatusLabel()));
+    hideLoadProgress();
+    setLargeFileMode (m_text_edit->isLargeFile());
+
+    m_mode_label->setText ("  " + tr ("Large file mode") + "  ");
+    m_mode_label->setToolTip (tr ("Syntax highlighting, word wrap and other "
+                                  "features are disabled for this document"));
+
+    UpdateScheduler *_scheduler = UpdateScheduler::instance();
+    _scheduler->connectUpdate (m_text_edit, SIGNAL (textChanged()), this, SLOT (updateStatusLabel()));
     connect (window, SIGNAL (updateSettings()), this, SLOT (updateSettings()));
+    connect (window, SIGNAL (settingsChanged (QList<int>)), this, SLOT (applySettings (QList<int>)));
+
+    //
+    // Show the progress of the file loader
+    //
+    connect (m_text_edit, SIGNAL (loadStarted()), this, SLOT (showLoadProgress()));
+    connect (m_text_edit, SIGNAL (loadFinished()), this, SLOT (hideLoadProgress()));
+    connect (m_text_edit, SIGNAL (loadProgress (int)), m_progress_bar, SLOT (setValue (int)));
+    connect (m_cancel_button, SIGNAL (clicked()), m_text_edit, SLOT (cancelLoad()));
+    _scheduler->connectUpdate (m_text_edit, SIGNAL (loadFinished()), this, SLOT (updateStatusLabel()));
+
+    //
+    // Tell the user when the large file mode is active
+    //
+    connect (m_text_edit, SIGNAL (largeFileModeChanged (bool)), this, SLOT (setLargeFileMode (bool)));
+
+    updateStatusLabel();
+}
+
+/*!
+ * \internal
+ * Shows the progress bar and the cancel button while a file is loaded
+ */
+
+void StatusBar::showLoadProgress (void) {
+    m_progress_bar->setValue (0);
+    m_progress_bar->show();
+    m_cancel_button->show();
+}
+
+/*!
+ * \internal
+ * Hides the progress bar and the cancel button
+ */
+
+void StatusBar::hideLoadProgress (void) {
+    m_progress_bar->hide();
+    m_cancel_button->hide();
+}
+
+/*!
+ * \internal
+ * Shows or hides the large file mode indicator
+ */
 
+void StatusBar::setLargeFileMode (bool enabled) {
+    m_mode_label->setVisible (enabled);
     updateStatusLabel();
 }
 
@@ -77,7 +152,17 @@ void StatusBar::initialize (Window *window) {
  */
 
 void StatusBar::updateSettings (void) {
-    settings()->value ("statusbar-enabled", SETTINGS_STATUSBAR_ENABLED).toBool() ? show() : hide();
+    settings()->statusBarEnabled() ? show() : hide();
+}
+
+/*!
+ * \internal
+ * Hides or shows the statusbar if the given \a {keys} include its setting
+ */
+
+void StatusBar::applySettings (const QList<int> &keys) {
+    if (keys.contains (SettingsRegistry::StatusBarEnabled))
+        updateSettings();
 }
 
 /*!
@@ -86,6 +171,7 @@ void StatusBar::updateSettings (void) {
  */
 
 void StatusBar::updateStatusLabel (void) {
+    m_encoding_label->setText ("  " + encoding() + "  ");
     m_size_label->setText ("  " + fileSize() + "  ");
     m_lines_label->setText ("  " + lineCount() + "  ");
     m_words_label->setText ("  " + wordCount() + "  ");
@@ -107,6 +193,12 @@ QString StatusBar::fileSize (void) {
  */
 
 QString StatusBar::wordCount (void) {
+    //
+    // The viewers only have a part of the file in the editor
+    //
+    if (m_text_edit->viewer() != NULL || m_text_edit->hexViewer() != NULL)
+        return tr ("Words:") + " " + tr ("N/A");
+
     return tr ("Words:") + " " +
            QString::number (m_text_edit->wordCount());
 }
@@ -117,15 +209,52 @@ QString StatusBar::wordCount (void) {
 */
 
 QString StatusBar::lineCount (void) {
+    //
+    // Binary files are displayed in rows of bytes
+    //
+    if (m_text_edit->hexViewer() != NULL)
+        return tr ("Rows:") + " " +
+               QString::number (m_text_edit->hexViewer()->rowCount());
+
+    //
+    // Show the number of lines indexed so far by the viewer
+    //
+    if (m_text_edit->viewer() != NULL) {
+        FileViewer *_viewer = m_text_edit->viewer();
+        return tr ("Lines:") + " " +
+               QString::number (_viewer->lineCount()) +
+               (_viewer->isIndexing() ? "+" : "");
+    }
+
     return tr ("Lines:") + " " +
            QString::number (m_text_edit->lines());
 }
 
+/*!
+ * \internal
+ * Returns the encoding (and the compression format) of the document
+ */
+
+QString StatusBar::encoding (void) {
+    if (m_text_edit->hexViewer() != NULL)
+        return tr ("Binary");
+
+    QString _encoding = m_text_edit->encoding();
+
+    if (m_text_edit->hasBom())
+        _encoding += " " + tr ("(BOM)");
+
+    if (!m_text_edit->compression().isEmpty())
+        _encoding += ", " + m_text_edit->compression();
+
+    return _encoding;
+}
+
 /*!
  * Allows the class to access the application settings
  */
 
-QSettings *StatusBar::settings (void) const {
-    return new QSettings (APP_COMPANY, APP_NAME);
+SettingsRegistry *StatusBar::settings (void) const {
+    return SettingsRegistry::instance();
 }
 
@@ -31,7 +31,9 @@ class QLabel;
 class Window;
 class QString;
 class QRegExp;
-class QSettings;
+class SettingsRegistry;
+class QToolButton;
+class QProgressBar;
 
 #include <QStatusBar>
 
@@ -43,20 +45,29 @@ class StatusBar : public QStatusBar {
 
     private slots:
         void updateSettings (void);
+        void applySettings (const QList<int> &keys);
         void updateStatusLabel (void);
         void initialize (Window *window);
+        void showLoadProgress (void);
+        void hideLoadProgress (void);
+        void setLargeFileMode (bool enabled);
 
     private:
+        QLabel *m_mode_label;
+        QLabel *m_encoding_label;
         QLabel *m_size_label;
         QLabel *m_words_label;
         QLabel *m_lines_label;
         Editor *m_text_edit;
+        QToolButton *m_cancel_button;
+        QProgressBar *m_progress_bar;
 
-        QSettings *settings (void) const;
+        SettingsRegistry *settings (void) const;
 
         QString fileSize (void);
         QString wordCount (void);
         QString lineCount (void);
+        QString encoding (void);
 };
 
 #endif
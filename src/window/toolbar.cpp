@@ -20,13 +20,13 @@
 //
 
 #include <QAction>
-#include <QSettings>
 
 #include "editor.h"
 #include "window.h"
 #include "toolbar.h"
 #include "platform.h"
 #include "defaults.h"
+#include "settings_registry.h"
 
 //
 // Know where to find the icon themes
@@ -87,8 +87,8 @@ ToolBar::ToolBar (Window *parent) : QToolBar (parent) {
     //
     // Load the settings
     //
-    m_large_icons = settings()->value ("large-icons", SETTINGS_LARGE_ICONS).toBool();
-    m_toolbar_text = settings()->value ("toolbar-text", SETTINGS_TOOLBAR_TEXT).toBool();
+    m_large_icons = settings()->largeIcons();
+    m_toolbar_text = settings()->toolbarText();
     setToolbarText (m_toolbar_text);
 
     //
@@ -228,11 +228,31 @@ void ToolBar::initialize (Window *window) {
     // Change the icon theme when the settings are synced
     //
     connect (window, SIGNAL (updateSettings()), this, SLOT (updateSettings()));
+
+    //
+    // Only update what changed when the user changes a setting
+    //
+    connect (window, SIGNAL (settingsChanged (QList<int>)), this, SLOT (applySettings (QList<int>)));
 }
 
 void ToolBar::updateSettings (void) {
-    bool _new_value = settings()->value ("toolbar-text", SETTINGS_TOOLBAR_TEXT).toBool();
-    bool _new_sizes = settings()->value ("large-icons", SETTINGS_LARGE_ICONS).toBool();
+    updateIcons();
+    updateVisibility();
+}
+
+void ToolBar::applySettings (const QList<int> &keys) {
+    if (keys.contains (SettingsRegistry::ToolbarText) ||
+            keys.contains (SettingsRegistry::LargeIcons) ||
+            keys.contains (SettingsRegistry::IconTheme))
+        updateIcons();
+
+    if (keys.contains (SettingsRegistry::ToolbarEnabled))
+        updateVisibility();
+}
+
+void ToolBar::updateIcons (void) {
+    bool _new_value = settings()->toolbarText();
+    bool _new_sizes = settings()->largeIcons();
 
     //
     // Resize and redraw the toolbar if neccessary
@@ -244,16 +264,15 @@ void ToolBar::updateSettings (void) {
         setToolbarText (_new_value);
     }
 
-    //
-    // Hide/show the toolbar
-    //
-    setVisible (settings()->value ("toolbar-enabled", SETTINGS_TOOLBAR_ENABLED).toBool());
-    setEnabled (settings()->value ("toolbar-enabled", SETTINGS_TOOLBAR_ENABLED).toBool());
-
     //
     // Set icon theme
     //
-    update_theme (settings()->value ("icon-theme", SETTINGS_ICON_THEME).toString());
+    update_theme (settings()->iconTheme());
+}
+
+void ToolBar::updateVisibility (void) {
+    setVisible (settings()->toolbarEnabled());
+    setEnabled (settings()->toolbarEnabled());
 }
 
 void ToolBar::update_theme (const QString &theme) {
@@ -288,7 +307,7 @@ void ToolBar::update_theme (const QString &theme) {
  * Allows the class to access the application settings
  */
 
-QSettings *ToolBar::settings (void) const {
-    return new QSettings (APP_COMPANY, APP_NAME);
+SettingsRegistry *ToolBar::settings (void) const {
+    return SettingsRegistry::instance();
 }
 
@@ -28,7 +28,7 @@ extern "C++" {
 
 class Window;
 class QAction;
-class QSettings;
+class SettingsRegistry;
 
 #include <QToolBar>
 
@@ -70,10 +70,14 @@ class ToolBar : public QToolBar {
 
     private slots:
         void updateSettings (void);
+        void applySettings (const QList<int> &keys);
         void initialize (Window *window);
         void update_theme (const QString &theme);
 
     private:
+        void updateIcons (void);
+        void updateVisibility (void);
+
         QAction *m_new;
         QAction *m_open;
         QAction *m_save;
@@ -89,7 +93,7 @@ class ToolBar : public QToolBar {
         bool m_large_icons;
         bool m_toolbar_text;
 
-        QSettings *settings (void) const;
+        SettingsRegistry *settings (void) const;
 };
 
 #endif
@@ -21,7 +21,6 @@
 
 #include <QUrl>
 #include <QFile>
-#include <QSettings>
 #include <QDateTime>
 #include <QMessageBox>
 #include <QFileDialog>
@@ -30,6 +29,7 @@
 #include <QDesktopServices>
 
 #include <QMoveEvent>
+#include <QShowEvent>
 #include <QCloseEvent>
 
 #include <Qsci/qsciprinter.h>
@@ -39,8 +39,12 @@
 #include "menubar.h"
 #include "toolbar.h"
 #include "platform.h"
+#include "file_viewer.h"
 #include "statusbar.h"
 #include "searchdialog.h"
+#include "settings_bus.h"
+#include "settings_registry.h"
+#include "update_scheduler.h"
 
 #define CURRENT_YEAR QDateTime::currentDateTime().toString("yyyy")
 
@@ -87,18 +91,31 @@ Window::Window (const QString &file) {
     //
     // Change the title of the window when a new file is loaded
     //
-    connect (editor(), SIGNAL (updateTitle()), this, SLOT (updateTitle()));
+    UpdateScheduler *_scheduler = UpdateScheduler::instance();
+    _scheduler->connectUpdate (editor(), SIGNAL (updateTitle()), this, SLOT (updateTitle()));
 
     //
-    // Append a "*" to the document name when the file is modified
+    // Append a "*" to the document name when the file is modified, the
+    // title is updated once per frame while the user is typing
     //
-    connect (editor(), SIGNAL (textChanged()), this, SLOT (updateTitle()));
+    _scheduler->connectUpdate (editor(), SIGNAL (textChanged()), this, SLOT (updateTitle()));
 
     //
-    // Sync the settings across the editor and the window
+    // Binary files displayed in the hex viewer are read-only
     //
-    connect (editor(), SIGNAL (settingsChanged()), this, SIGNAL (settingsChanged()));
-    connect (this,     SIGNAL (updateSettings()), editor(), SLOT (updateSettings()));
+    connect (editor(), SIGNAL (hexModeChanged (bool)), this, SLOT (setReadOnly (bool)));
+
+    //
+    // Apply all the settings when the window is configured, and only the
+    // changed settings when the user changes them
+    //
+    connect (this, SIGNAL (updateSettings()), editor(), SLOT (updateSettings()));
+    connect (this, SIGNAL (settingsChanged (QList<int>)), editor(), SLOT (applySettings (QList<int>)));
+
+    //
+    // Receive the settings changed by any window of the application
+    //
+    SettingsBus::instance()->subscribe (this);
 
     //
     // Configure all widgets
@@ -111,22 +128,25 @@ Window::Window (const QString &file) {
     // Set window geometry
     //
     setMinimumSize (420, 420);
-    resize (settings()->value ("size", QSize (640, 420)).toSize());
-    move (settings()->value ("position", QPoint (200, 200)).toPoint());
-    settings()->value ("maximized", false).toBool() ? showMaximized() : showNormal();
+    resize (settings()->windowSize());
+    move (settings()->windowPosition());
+    settings()->windowMaximized() ? showMaximized() : showNormal();
 
     //
     // Read file
     //
-    if (!file.isEmpty())
+    if (!file.isEmpty()) {
         editor()->readFile (file);
+
+        if (editor()->viewer() != NULL)
+            setReadOnly (true);
+    }
 }
 
 Window::~Window (void) {
     delete m_menu;
     delete m_editor;
     delete m_toolbar;
-    delete settings();
     delete m_statusbar;
     delete m_search_dialog;
 }
@@ -147,13 +167,57 @@ SearchDialog *Window::searchDialog (void) const {
     return m_search_dialog;
 }
 
+/*!
+ * Forwards the changed settings (identified by their \a {keys}) to the
+ * widgets of the window. The settings are applied when the window is shown
+ * again if the window is hidden or minimized.
+ */
+
+void Window::deliverSettings (const QList<int> &keys) {
+    foreach (int _key, keys) {
+        if (!m_deferred_settings.contains (_key))
+            m_deferred_settings.append (_key);
+    }
+
+    if (isVisible() && !isMinimized())
+        applyDeferredSettings();
+}
+
+void Window::showEvent (QShowEvent *event) {
+    applyDeferredSettings();
+    QMainWindow::showEvent (event);
+}
+
+void Window::changeEvent (QEvent *event) {
+    if (event->type() == QEvent::WindowStateChange && !isMinimized())
+        applyDeferredSettings();
+
+    QMainWindow::changeEvent (event);
+}
+
 void Window::moveEvent (QMoveEvent *event) {
     saveWindowState();
     event->accept();
 }
 
 void Window::closeEvent (QCloseEvent *event) {
-    editor()->maybeSave() ? event->accept() : event->ignore();
+    //
+    // The close event can be received while a large document is
+    // saved, the user can close the window after the save
+    //
+    if (editor()->isSaving()) {
+        event->ignore();
+        return;
+    }
+
+    if (editor()->maybeSave()) {
+        editor()->cancelLoad();
+        editor()->discardJournal();
+        event->accept();
+    }
+
+    else
+        event->ignore();
 }
 
 void Window::resizeEvent (QResizeEvent *event) {
@@ -165,9 +229,13 @@ void Window::openFile (const QString &file_name) {
     //
     // Open the file in the same window
     //
-    if (editor()->titleIsShit() && !editor()->isModified())
+    if (editor()->titleIsShit() && !editor()->isModified()) {
         editor()->readFile (file_name);
 
+        if (editor()->viewer() != NULL)
+            setReadOnly (true);
+    }
+
     //
     // Open the file in another window
     //
@@ -191,6 +259,12 @@ void Window::open (void) {
 }
 
 void Window::setReadOnly (bool ro) {
+    //
+    // Documents opened with the viewers are always read-only
+    //
+    if (editor()->viewer() != NULL || editor()->hexViewer() != NULL)
+        ro = true;
+
     editor()->setReadOnly (ro);
     toolbar()->setReadOnly (ro);
 
@@ -198,43 +272,39 @@ void Window::setReadOnly (bool ro) {
 }
 
 void Window::setWordWrap (bool ww) {
-    settings()->setValue ("wordwrap-enabled", ww);
-    syncSettings();
+    settings()->setWordWrap (ww);
 }
 
 void Window::setToolbarText (bool tt) {
-    settings()->setValue ("toolbar-text", tt);
-    syncSettings();
+    settings()->setToolbarText (tt);
 }
 
 void Window::setToolbarEnabled (bool tb) {
-    settings()->setValue ("toolbar-enabled", tb);
-    syncSettings();
+    settings()->setToolbarEnabled (tb);
 }
 
 void Window::setStatusBarEnabled (bool sb) {
-    settings()->setValue ("statusbar-enabled", sb);
-    syncSettings();
+    settings()->setStatusBarEnabled (sb);
 }
 
 void Window::setHCLineEnabled (bool hc) {
-    settings()->setValue ("hc-line-enabled", hc);
-    syncSettings();
+    settings()->setCaretLine (hc);
 }
 
 void Window::setUseLargeIcons (bool li) {
-    settings()->setValue ("large-icons", li);
-    syncSettings();
+    settings()->setLargeIcons (li);
 }
 
 void Window::setLineNumbersEnabled (bool ln) {
-    settings()->setValue ("line-numbers-enabled", ln);
-    syncSettings();
+    settings()->setLineNumbers (ln);
+}
+
+void Window::setLargeFileModeEnabled (bool lf) {
+    settings()->setLargeFileMode (lf);
 }
 
 void Window::setColorscheme (const QString &colorscheme) {
-    settings()->setValue ("color-scheme", colorscheme);
-    syncSettings();
+    settings()->setColorScheme (colorscheme);
 }
 
 void Window::showFindReplaceDialog (void) {
@@ -242,8 +312,7 @@ void Window::showFindReplaceDialog (void) {
 }
 
 void Window::setIconTheme (const QString &theme) {
-    settings()->setValue ("icon-theme", theme);
-    syncSettings();
+    settings()->setIconTheme (theme);
 }
 
 void Window::aboutThunderpad (void) {
@@ -311,13 +380,8 @@ void Window::updateTitle (void) {
     toolbar()->setSaveEnabled (_save_enabled);
 }
 
-void Window::syncSettings (void) {
-    emit updateSettings();
-    emit settingsChanged();
-}
-
 void Window::saveWindowState (void) {
-    settings()->setValue ("maximized", isMaximized());
+    settings()->setWindowMaximized (isMaximized());
 
     //
     // Mac OS X does not register a window as maximized,
@@ -337,11 +401,27 @@ void Window::saveWindowState (void) {
     // Only save the window size and position if it isn't maximized
     //
     if (!isMaximized() && !_mac_os_maximized) {
-        settings()->setValue ("size", size());
-        settings()->setValue ("position", pos());
+        settings()->setWindowSize (size());
+        settings()->setWindowPosition (pos());
     }
 }
 
+/*!
+ * \internal
+ * Applies the settings that were changed since the last time that they
+ * were delivered to the widgets of the window
+ */
+
+void Window::applyDeferredSettings (void) {
+    if (m_deferred_settings.isEmpty())
+        return;
+
+    QList<int> _keys = m_deferred_settings;
+    m_deferred_settings.clear();
+
+    emit settingsChanged (_keys);
+}
+
 void Window::configureWindow (Window *window) {
     Q_ASSERT (window != NULL);
 
@@ -350,16 +430,6 @@ void Window::configureWindow (Window *window) {
     //
     connect (window, SIGNAL (checkForUpdates()), this, SIGNAL (checkForUpdates()));
 
-    //
-    // Sync settings across windows
-    //
-    foreach (QWidget *widget, QApplication::topLevelWidgets()) {
-        if (widget->objectName() == objectName()) {
-            connect (widget, SIGNAL (settingsChanged()), window, SIGNAL (updateSettings()));
-            connect (window, SIGNAL (settingsChanged()), widget, SIGNAL (updateSettings()));
-        }
-    }
-
     //
     // Show the window normally if the current window is maximized
     //
@@ -407,7 +477,7 @@ QString Window::shortFileName (const QString &file) {
  * Allows the class to access the application settings
  */
 
-QSettings *Window::settings (void) const {
-    return new QSettings (APP_COMPANY, APP_NAME);
+SettingsRegistry *Window::settings (void) const {
+    return SettingsRegistry::instance();
 }
 
@@ -32,10 +32,11 @@ class MenuBar;
 class ToolBar;
 class MenuBar;
 class StatusBar;
-class QSettings;
+class SettingsRegistry;
 class QMainWindow;
 class SearchDialog;
 
+#include <QList>
 #include <QMainWindow>
 
 class Window : public QMainWindow {
@@ -48,19 +49,22 @@ class Window : public QMainWindow {
         Editor *editor (void) const;
         ToolBar *toolbar (void) const;
         MenuBar *menubar (void) const;
-        QSettings *settings (void) const;
+        SettingsRegistry *settings (void) const;
         SearchDialog *searchDialog (void) const;
 
         void configureWindow (Window *window);
         void openFile (const QString &file_name);
+        void deliverSettings (const QList<int> &keys);
 
     signals:
         void updateSettings (void);
-        void settingsChanged (void);
+        void settingsChanged (const QList<int> &keys);
         void checkForUpdates (void);
         void readOnlyChanged (bool ro);
 
     protected:
+        void showEvent (QShowEvent *event);
+        void changeEvent (QEvent *event);
         void moveEvent (QMoveEvent *event);
         void closeEvent (QCloseEvent *event);
         void resizeEvent (QResizeEvent *event);
@@ -76,6 +80,7 @@ class Window : public QMainWindow {
         void setHCLineEnabled (bool hc);
         void setUseLargeIcons (bool li);
         void setLineNumbersEnabled (bool ln);
+        void setLargeFileModeEnabled (bool lf);
         void setIconTheme (const QString &theme);
         void setColorscheme (const QString &colorscheme);
         void showFindReplaceDialog (void);
@@ -90,11 +95,14 @@ class Window : public QMainWindow {
 
     private slots:
         void updateTitle (void);
-        void syncSettings (void);
         void saveWindowState (void);
         QString shortFileName (const QString &file);
 
     private:
+        void applyDeferredSettings (void);
+
+        QList<int> m_deferred_settings;
+
         MenuBar *m_menu;
         Editor *m_editor;
         ToolBar *m_toolbar;
@@ -70,9 +70,39 @@ RESOURCES += res/res.qrc
 
 CONFIG += qscintilla2
 
+# Compression libraries, zlib (gzip) is always needed and the other
+# formats are optional, e.g. "qmake CONFIG+=bzip2 CONFIG+=xz CONFIG+=zstd"
+# Windows has no system zlib, so the copy bundled with Qt is used there
+win32* {
+    QT      += zlib-private
+    DEFINES += HAVE_QT_ZLIB=1
+} else {
+    LIBS    += -lz
+}
+
+bzip2 {
+    DEFINES += HAVE_BZIP2=1
+    LIBS    += -lbz2
+}
+
+xz {
+    DEFINES += HAVE_XZ=1
+    LIBS    += -llzma
+}
+
+zstd {
+    DEFINES += HAVE_ZSTD=1
+    LIBS    += -lzstd
+}
+
 HEADERS += \
     src/app/app.h \
+    src/app/update_scheduler.h \
+    src/app/settings_store.h \
+    src/app/settings_registry.h \
+    src/app/settings_bus.h \
     src/dialogs/searchdialog.h \
+    src/dialogs/documentinfodialog.h \
     src/editor/editor.h \
     src/window/menubar.h \
     src/window/toolbar.h \
@@ -81,17 +111,43 @@ HEADERS += \
     src/shared/platform.h \
     src/editor/theme.h \
     src/shared/defaults.h \
+    src/shared/simd.h \
     src/editor/lexer_database.h \
+    src/editor/language_registry.h \
+    src/editor/language_detector.h \
+    src/editor/syntax_grammar.h \
+    src/editor/file_loader.h \
+    src/editor/file_writer.h \
+    src/editor/file_viewer.h \
+    src/editor/line_indexer.h \
+    src/editor/file_searcher.h \
+    src/editor/utf8_validator.h \
+    src/editor/encoding_detector.h \
+    src/editor/format_detector.h \
+    src/editor/text_diff.h \
+    src/editor/file_reloader.h \
+    src/editor/edit_journal.h \
+    src/editor/journal_writer.h \
+    src/editor/compression.h \
+    src/editor/hex_viewer.h \
+    src/editor/document_stats.h \
+    src/editor/document_analyzer.h \
     src/editor/lexers/qscilexerada.h \
     src/editor/lexers/qscilexerasm.h \
     src/editor/lexers/qscilexerhaskell.h \
     src/editor/lexers/qscilexerlisp.h \
     src/editor/lexers/qscilexernsis.h \
+    src/editor/lexers/qscilexergrammar.h \
     src/editor/lexers/qscilexerplaintext.h
     
 SOURCES += \
     src/app/app.cpp \
+    src/app/update_scheduler.cpp \
+    src/app/settings_store.cpp \
+    src/app/settings_registry.cpp \
+    src/app/settings_bus.cpp \
     src/dialogs/searchdialog.cpp \
+    src/dialogs/documentinfodialog.cpp \
     src/editor/editor.cpp \
     src/window/menubar.cpp \
     src/window/toolbar.cpp \
@@ -100,9 +156,29 @@ SOURCES += \
     src/window/statusbar.cpp \
     src/editor/theme.cpp \
     src/editor/lexer_database.cpp \
+    src/editor/language_registry.cpp \
+    src/editor/language_detector.cpp \
+    src/editor/syntax_grammar.cpp \
+    src/editor/file_loader.cpp \
+    src/editor/file_writer.cpp \
+    src/editor/file_viewer.cpp \
+    src/editor/line_indexer.cpp \
+    src/editor/file_searcher.cpp \
+    src/editor/utf8_validator.cpp \
+    src/editor/encoding_detector.cpp \
+    src/editor/format_detector.cpp \
+    src/editor/text_diff.cpp \
+    src/editor/file_reloader.cpp \
+    src/editor/edit_journal.cpp \
+    src/editor/journal_writer.cpp \
+    src/editor/compression.cpp \
+    src/editor/hex_viewer.cpp \
+    src/editor/document_stats.cpp \
+    src/editor/document_analyzer.cpp \
     src/editor/lexers/qscilexerada.cpp \
     src/editor/lexers/qscilexerasm.cpp \
     src/editor/lexers/qscilexerhaskell.cpp \
     src/editor/lexers/qscilexerlisp.cpp \
     src/editor/lexers/qscilexernsis.cpp \
+    src/editor/lexers/qscilexergrammar.cpp \
     src/editor/lexers/qscilexerplaintext.cpp